@@ -0,0 +1,122 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_CATALOGUE_OBJECT_CATALOGUE_H
+#define MIR_OBJECT_CATALOGUE_OBJECT_CATALOGUE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef uint16_t ObjectId;
+
+enum class ObjectShape : uint8_t
+{
+  UNKNOWN = 0,
+  BOX,
+  CYLINDER,
+  SPHERE
+};
+
+/** \brief Pose correction of long objects, which are grasped off their centroid */
+enum class PoseAdjustment : uint8_t
+{
+  NONE = 0,
+  BOLT,  // midpoint between the centroid and the top of the object
+  AXIS   // top of the object
+};
+
+/** \brief Typed attributes of an object of the catalogue */
+struct ObjectInfo
+{
+  ObjectInfo()
+    : id(0),
+      shape(ObjectShape::UNKNOWN),
+      round(false),
+      container(false),
+      pose_adjustment(PoseAdjustment::NONE),
+      grasp_monitored(false),
+      grasp_threshold(0.0)
+  {
+  }
+
+  ObjectId id;
+  std::string name;  // upper case
+  std::string color;
+  ObjectShape shape;
+  bool round;  // spheres, their yaw is meaningless
+  bool container;
+  PoseAdjustment pose_adjustment;
+  // The gripper checks whether the object is grasped, with the position error threshold
+  // of the grasp monitor if grasp_threshold is 0
+  bool grasp_monitored;
+  double grasp_threshold;
+};
+
+/** \brief Table of the objects of objects.xml, read once and shared by perception,
+ * manipulation and planning.
+ *
+ * Every object gets a small integer id in the order of the file, id 0 is the unknown
+ * object (e.g. DECOY), so the ids index plain arrays. Names are resolved once, case
+ * insensitive, and also through the aliases of an object and with an instance suffix
+ * (AXIS-01, bearing_box_02). The per-object decisions are then made on the attributes
+ * instead of repeated name compares.
+ *
+ * <object_info>
+ *   <object>
+ *     <name>CONTAINER_BOX_BLUE</name><shape>box</shape><color>blue</color>
+ *     <container>true</container><alias>BLUE_CONTAINER</alias>
+ *   </object>
+ *   <object>
+ *     <name>MOTOR</name><shape>cylinder</shape><color>black</color>
+ *     <grasp_monitored>true</grasp_monitored><grasp_threshold>0.07</grasp_threshold>
+ *   </object>
+ *   <object><name>AXIS</name><shape>cylinder</shape><pose_adjustment>axis</pose_adjustment></object>
+ * </object_info>
+ *
+ * Not thread safe while loading, const access after loading is.
+ */
+class ObjectCatalogue
+{
+  public:
+    static const ObjectId UNKNOWN_ID = 0;
+
+    ObjectCatalogue();
+
+    /** \brief Read the objects, replaces the current ones
+     * \param[in] Path of objects.xml
+     * \param[out] Description of the error, if any
+     * \return False if the file cannot be read or parsed, or a name or an alias is empty or
+     *     ambiguous, the catalogue is empty then
+     * */
+    bool load(const std::string &filename, std::string *error = nullptr);
+
+    /** \brief Id of an object name, instance name or alias
+     * \return UNKNOWN_ID if the name is not in the catalogue
+     * */
+    ObjectId find(const std::string &name) const;
+
+    /** \brief Attributes of an object, the unknown object for ids out of range */
+    const ObjectInfo &info(ObjectId id) const
+    {
+      return id < objects_.size() ? objects_[id] : objects_[UNKNOWN_ID];
+    }
+
+    const ObjectInfo &info(const std::string &name) const { return info(find(name)); }
+
+    /** \brief Number of objects, including the unknown object */
+    size_t size() const { return objects_.size(); }
+
+    bool empty() const { return objects_.size() <= 1; }
+
+    static ObjectShape parseShape(const std::string &shape);
+
+  private:
+    // objects_[0] is the unknown object
+    std::vector<ObjectInfo> objects_;
+    // upper case names and aliases
+    std::unordered_map<std::string, ObjectId> ids_;
+};
+
+#endif  // MIR_OBJECT_CATALOGUE_OBJECT_CATALOGUE_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <utility>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <mir_object_catalogue/object_catalogue.h>
+
+namespace
+{
+std::string toUpper(const std::string &s)
+{
+  std::string upper(s);
+  std::transform(upper.begin(), upper.end(), upper.begin(),
+                 [](unsigned char c) { return std::toupper(c); });
+  return upper;
+}
+
+std::string toLower(const std::string &s)
+{
+  std::string lower(s);
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return lower;
+}
+
+std::string trim(const std::string &s)
+{
+  size_t begin = s.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos)
+    return "";
+  size_t end = s.find_last_not_of(" \t\r\n");
+  return s.substr(begin, end - begin + 1);
+}
+
+/** \brief Length of a name without an instance suffix (-01, _2), npos if there is none */
+size_t instanceSuffix(const std::string &name)
+{
+  size_t pos = name.find_last_not_of("0123456789");
+  if (pos == std::string::npos || pos == name.size() - 1 || pos == 0)
+    return std::string::npos;
+  if (name[pos] != '-' && name[pos] != '_')
+    return std::string::npos;
+  return pos;
+}
+}  // namespace
+
+const ObjectId ObjectCatalogue::UNKNOWN_ID;
+
+ObjectCatalogue::ObjectCatalogue() : objects_(1) {}
+
+ObjectShape ObjectCatalogue::parseShape(const std::string &shape)
+{
+  const std::string lower = toLower(trim(shape));
+  if (lower == "box")
+    return ObjectShape::BOX;
+  if (lower == "cylinder")
+    return ObjectShape::CYLINDER;
+  if (lower == "sphere")
+    return ObjectShape::SPHERE;
+  return ObjectShape::UNKNOWN;
+}
+
+bool ObjectCatalogue::load(const std::string &filename, std::string *error)
+{
+  using boost::property_tree::ptree;
+  objects_.assign(1, ObjectInfo());
+  ids_.clear();
+
+  // the aliases are registered once all names are known, in the order of the file
+  std::vector<std::pair<std::string, ObjectId>> aliases;
+  ptree pt;
+  try
+  {
+    read_xml(filename, pt);
+    for (const ptree::value_type &v : pt.get_child("object_info"))
+    {
+      if (v.first != "object")
+        continue;
+      ObjectInfo object;
+      object.name = toUpper(trim(v.second.get<std::string>("name")));
+      if (object.name.empty() || ids_.count(object.name))
+      {
+        if (error)
+          *error = "Empty or duplicate object name '" + object.name + "'";
+        objects_.assign(1, ObjectInfo());
+        ids_.clear();
+        return false;
+      }
+      if (objects_.size() > std::numeric_limits<ObjectId>::max())
+      {
+        if (error)
+          *error = "Too many objects";
+        objects_.assign(1, ObjectInfo());
+        ids_.clear();
+        return false;
+      }
+      object.id = static_cast<ObjectId>(objects_.size());
+      object.color = trim(v.second.get<std::string>("color", ""));
+      object.shape = parseShape(v.second.get<std::string>("shape", ""));
+      object.round = object.shape == ObjectShape::SPHERE;
+      object.container = v.second.get<bool>("container", false);
+      const std::string adjustment = toLower(trim(v.second.get<std::string>("pose_adjustment", "")));
+      if (adjustment == "bolt")
+        object.pose_adjustment = PoseAdjustment::BOLT;
+      else if (adjustment == "axis")
+        object.pose_adjustment = PoseAdjustment::AXIS;
+      object.grasp_monitored = v.second.get<bool>("grasp_monitored", false);
+      object.grasp_threshold = v.second.get<double>("grasp_threshold", 0.0);
+
+      ids_[object.name] = object.id;
+      for (const ptree::value_type &alias : v.second)
+      {
+        if (alias.first == "alias")
+          aliases.emplace_back(toUpper(trim(alias.second.data())), object.id);
+      }
+      objects_.push_back(object);
+    }
+  }
+  catch (const boost::property_tree::ptree_error &e)
+  {
+    if (error)
+      *error = e.what();
+    objects_.assign(1, ObjectInfo());
+    ids_.clear();
+    return false;
+  }
+
+  for (const auto &alias : aliases)
+  {
+    // repeated aliases and aliases of an object's own name are harmless, an alias naming
+    // another object or shared by two objects is ambiguous
+    auto it = ids_.emplace(alias.first, alias.second).first;
+    if (alias.first.empty() || it->second != alias.second)
+    {
+      if (error)
+        *error = "Empty or ambiguous alias '" + alias.first + "' of object '" +
+                 objects_[alias.second].name + "'";
+      objects_.assign(1, ObjectInfo());
+      ids_.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+ObjectId ObjectCatalogue::find(const std::string &name) const
+{
+  std::string key = toUpper(name);
+  auto it = ids_.find(key);
+  if (it != ids_.end())
+    return it->second;
+  // instance of an object, e.g. AXIS-01, names such as EM-01 are matched above
+  const size_t suffix = instanceSuffix(key);
+  if (suffix == std::string::npos)
+    return UNKNOWN_ID;
+  key.resize(suffix);
+  it = ids_.find(key);
+  return it != ids_.end() ? it->second : UNKNOWN_ID;
+}
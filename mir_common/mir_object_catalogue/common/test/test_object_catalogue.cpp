@@ -0,0 +1,138 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_catalogue/object_catalogue.h>
+
+class ObjectCatalogueTest : public ::testing::Test
+{
+  protected:
+    ObjectCatalogueTest() : filename_(testing::TempDir() + "test_object_catalogue.xml") {}
+
+    ~ObjectCatalogueTest() { std::remove(filename_.c_str()); }
+
+    /** \brief Load the objects of an object_info element */
+    bool load(const std::string &objects)
+    {
+      std::ofstream file(filename_);
+      file << "<object_info>\n" << objects << "</object_info>\n";
+      file.close();
+      error_.clear();
+      return catalogue_.load(filename_, &error_);
+    }
+
+    /** \brief Objects of objects.xml with instance suffixes and aliases */
+    bool loadObjects()
+    {
+      return load("<object><name>M20_100</name><shape>cylinder</shape>"
+                  "<pose_adjustment>bolt</pose_adjustment></object>\n"
+                  "<object><name>M20</name><shape>sphere</shape><color>black</color></object>\n"
+                  "<object><name>EM-01</name><shape>box</shape></object>\n"
+                  "<object><name>container_box_blue</name><shape>box</shape><color>blue</color>"
+                  "<container>true</container><alias>BLUE_CONTAINER</alias></object>\n"
+                  "<object><name>BEARING_BOX</name><grasp_monitored>true</grasp_monitored>"
+                  "<grasp_threshold>0.07</grasp_threshold></object>\n"
+                  "<object><name>AXIS</name><shape>cylinder</shape>"
+                  "<pose_adjustment>axis</pose_adjustment></object>\n");
+    }
+
+    std::string filename_;
+    std::string error_;
+    ObjectCatalogue catalogue_;
+};
+
+TEST_F(ObjectCatalogueTest, ResolvesNamesAliasesAndInstances)
+{
+  ASSERT_TRUE(loadObjects()) << error_;
+  EXPECT_EQ(catalogue_.size(), 7u);
+  EXPECT_EQ(catalogue_.find("M20_100"), 1);
+  EXPECT_EQ(catalogue_.find("M20"), 2);
+  // case insensitive
+  EXPECT_EQ(catalogue_.find("m20"), 2);
+  EXPECT_EQ(catalogue_.info("Container_Box_Blue").name, "CONTAINER_BOX_BLUE");
+  EXPECT_EQ(catalogue_.find("BLUE_CONTAINER"), 4);
+
+  // instances, the exact name is matched first
+  EXPECT_EQ(catalogue_.find("AXIS-01"), 6);
+  EXPECT_EQ(catalogue_.find("bearing_box_02"), 5);
+  EXPECT_EQ(catalogue_.find("M20_01"), 2);
+  EXPECT_EQ(catalogue_.find("M20_100_2"), 1);
+  EXPECT_EQ(catalogue_.find("EM-01"), 3);
+  EXPECT_EQ(catalogue_.find("EM-02"), ObjectCatalogue::UNKNOWN_ID);
+
+  EXPECT_EQ(catalogue_.find("DECOY"), ObjectCatalogue::UNKNOWN_ID);
+  EXPECT_EQ(catalogue_.find("AXIS-"), ObjectCatalogue::UNKNOWN_ID);
+  EXPECT_EQ(catalogue_.find("_01"), ObjectCatalogue::UNKNOWN_ID);
+  EXPECT_EQ(catalogue_.info("DECOY").id, ObjectCatalogue::UNKNOWN_ID);
+  EXPECT_EQ(catalogue_.info(ObjectId(100)).id, ObjectCatalogue::UNKNOWN_ID);
+}
+
+TEST_F(ObjectCatalogueTest, Flags)
+{
+  ASSERT_TRUE(loadObjects()) << error_;
+  const ObjectInfo &bolt = catalogue_.info("M20_100");
+  EXPECT_EQ(bolt.shape, ObjectShape::CYLINDER);
+  EXPECT_EQ(bolt.pose_adjustment, PoseAdjustment::BOLT);
+  EXPECT_FALSE(bolt.round);
+
+  const ObjectInfo &nut = catalogue_.info("M20");
+  EXPECT_TRUE(nut.round);
+  EXPECT_EQ(nut.color, "black");
+  EXPECT_FALSE(nut.container);
+
+  EXPECT_TRUE(catalogue_.info("BLUE_CONTAINER").container);
+  EXPECT_EQ(catalogue_.info("AXIS-02").pose_adjustment, PoseAdjustment::AXIS);
+  EXPECT_EQ(catalogue_.info("EM-01").pose_adjustment, PoseAdjustment::NONE);
+
+  const ObjectInfo &bearing_box = catalogue_.info("BEARING_BOX");
+  EXPECT_TRUE(bearing_box.grasp_monitored);
+  EXPECT_DOUBLE_EQ(bearing_box.grasp_threshold, 0.07);
+  EXPECT_EQ(bearing_box.shape, ObjectShape::UNKNOWN);
+  EXPECT_FALSE(catalogue_.info("M20").grasp_monitored);
+}
+
+TEST_F(ObjectCatalogueTest, AliasesDoNotDependOnTheOrder)
+{
+  // the alias of the first object names an object which is read later
+  EXPECT_FALSE(load("<object><name>M20_100</name><alias>M20</alias></object>\n"
+                    "<object><name>M20</name></object>\n"));
+  EXPECT_FALSE(error_.empty());
+  EXPECT_TRUE(catalogue_.empty());
+  EXPECT_FALSE(load("<object><name>M20</name></object>\n"
+                    "<object><name>M20_100</name><alias>M20</alias></object>\n"));
+  EXPECT_TRUE(catalogue_.empty());
+
+  // two objects with the same alias
+  EXPECT_FALSE(load("<object><name>CONTAINER_BOX_RED</name><alias>CONTAINER</alias></object>\n"
+                    "<object><name>CONTAINER_BOX_BLUE</name><alias>container</alias></object>\n"));
+  EXPECT_TRUE(catalogue_.empty());
+
+  // repeated aliases and the own name are not collisions
+  ASSERT_TRUE(load("<object><name>RED_CONTAINER</name><alias>container_box_red</alias>"
+                   "<alias>CONTAINER_BOX_RED</alias><alias>red_container</alias></object>\n"))
+      << error_;
+  EXPECT_EQ(catalogue_.find("CONTAINER_BOX_RED"), 1);
+  EXPECT_EQ(catalogue_.find("RED_CONTAINER"), 1);
+}
+
+TEST_F(ObjectCatalogueTest, RejectsInvalidFiles)
+{
+  EXPECT_FALSE(load("<object><name>M20</name></object>\n<object><name>m20</name></object>\n"));
+  EXPECT_TRUE(catalogue_.empty());
+  EXPECT_FALSE(load("<object><shape>box</shape></object>\n"));
+  EXPECT_FALSE(error_.empty());
+  EXPECT_FALSE(catalogue_.load(filename_ + ".missing", &error_));
+  EXPECT_TRUE(catalogue_.empty());
+  EXPECT_EQ(catalogue_.size(), 1u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #define DYNAMIXEL_GRIPPER_GRASP_MONITOR_NODE_H_
 
 #include <dynamixel_msgs/JointState.h>
+#include <mir_object_catalogue/object_catalogue.h>
 #include <ros/ros.h>
 #include <std_msgs/String.h>
 
@@ -23,7 +24,7 @@ class DynamixelGripperGraspMonitorNode
  private:
   enum States { INIT, IDLE, RUN };
 
-  std::map<std::string, double> object_threshold_map;
+  ObjectCatalogue object_catalogue_;
 
   void jointStatesCallback(const dynamixel_msgs::JointState::Ptr &msg);
   void eventCallback(const std_msgs::String::ConstPtr &msg);
@@ -34,7 +35,6 @@ class DynamixelGripperGraspMonitorNode
   void idle_state();
   void run_state();
   bool isObjectGrasped();
-  void addThreshold(std::string str, float f);
   ros::Publisher pub_event_;
   ros::Subscriber sub_event_;
   ros::Subscriber sub_dynamixel_motor_states_;
@@ -46,6 +46,7 @@ class DynamixelGripperGraspMonitorNode
   std_msgs::String event_in_;
   bool event_in_received_;
   std::string object_name_;
+  ObjectId object_id_;
 
   States current_state_;
 
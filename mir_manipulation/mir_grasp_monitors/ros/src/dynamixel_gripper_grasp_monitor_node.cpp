@@ -10,6 +10,7 @@
 DynamixelGripperGraspMonitorNode::DynamixelGripperGraspMonitorNode()
     : joint_states_received_(false),
       event_in_received_(false),
+      object_id_(ObjectCatalogue::UNKNOWN_ID),
       current_state_(INIT),
       loop_rate_init_state_(ros::Rate(100.0))
 {
@@ -23,15 +24,13 @@ DynamixelGripperGraspMonitorNode::DynamixelGripperGraspMonitorNode()
   sub_object_name_ =
       nh.subscribe("object_name", 10, &DynamixelGripperGraspMonitorNode::objectNameCallback, this);
 
-  // addThreshold("bearing", position_error_threshold_ );
-  // addThreshold("distance_tube", position_error_threshold_);
-  addThreshold("bearing_box", position_error_threshold_);
-  addThreshold("motor", position_error_threshold_);
-  addThreshold("s40_40_g", position_error_threshold_);
-  addThreshold("s40_40_b", position_error_threshold_);
-  // addThreshold("m30", position_error_threshold_);
-  // addThreshold("m20", position_error_threshold_);
-  // addThreshold("r20", position_error_threshold_);
+  // the monitored objects and their thresholds are flagged in the object catalogue
+  std::string object_catalogue;
+  nh.param<std::string>("object_catalogue", object_catalogue, "");
+  std::string error;
+  if (!object_catalogue_.load(object_catalogue, &error))
+    ROS_ERROR_STREAM("Cannot read the object catalogue " << object_catalogue << ": " << error
+                                                         << ", no object is monitored");
 }
 
 DynamixelGripperGraspMonitorNode::~DynamixelGripperGraspMonitorNode()
@@ -41,21 +40,6 @@ DynamixelGripperGraspMonitorNode::~DynamixelGripperGraspMonitorNode()
   sub_dynamixel_motor_states_.shutdown();
 }
 
-void DynamixelGripperGraspMonitorNode::addThreshold(std::string str, float f)
-{
-  object_threshold_map[str] = f;
-  for (int i = 0; i < 100; i++) {
-    std::ostringstream stringStream1;
-    stringStream1 << str << "-" << std::setfill('0') << std::setw(2) << i;
-    std::string id1 = stringStream1.str();
-    object_threshold_map[id1] = f;
-    std::ostringstream stringStream2;
-    stringStream2 << str << "_" << std::setfill('0') << std::setw(2) << i;
-    std::string id2 = stringStream2.str();
-    object_threshold_map[id2] = f;
-  }
-}
-
 void DynamixelGripperGraspMonitorNode::jointStatesCallback(
     const dynamixel_msgs::JointState::Ptr &msg)
 {
@@ -72,8 +56,9 @@ void DynamixelGripperGraspMonitorNode::eventCallback(const std_msgs::String::Con
 void DynamixelGripperGraspMonitorNode::objectNameCallback(const std_msgs::String::ConstPtr &msg)
 {
   object_name_ = msg->data;
-  std::transform(object_name_.begin(), object_name_.end(), object_name_.begin(), tolower);
-  ROS_DEBUG("object_name: %s", object_name_.c_str());
+  // also resolves instance names, e.g. bearing_box-01
+  object_id_ = object_catalogue_.find(object_name_);
+  ROS_DEBUG("object_name: %s, object id: %d", object_name_.c_str(), object_id_);
 }
 
 void DynamixelGripperGraspMonitorNode::update()
@@ -132,16 +117,19 @@ void DynamixelGripperGraspMonitorNode::run_state()
 
 bool DynamixelGripperGraspMonitorNode::isObjectGrasped()
 {
-  if (object_threshold_map.find(object_name_) == object_threshold_map.end()) {
+  const ObjectInfo &object = object_catalogue_.info(object_id_);
+  if (!object.grasp_monitored) {
     return true;
   }
+  const double position_error_threshold =
+      object.grasp_threshold > 0.0 ? object.grasp_threshold : position_error_threshold_;
 
   ROS_INFO("[GRASP_MONITOR] Position Error Values: %f, Position Threshold: %f",
-           std::abs(joint_states_->error), object_threshold_map[object_name_]);
+           std::abs(joint_states_->error), position_error_threshold);
   ROS_INFO("[GRASP_MONITOR] Load Values: %f, Load Threshold: %f", std::abs(joint_states_->load),
            load_threshold_);
 
-  if ((std::abs(joint_states_->error) >= object_threshold_map[object_name_]) and
+  if ((std::abs(joint_states_->error) >= position_error_threshold) and
       (std::abs(joint_states_->load) >= load_threshold_)) {
     return true;
   }
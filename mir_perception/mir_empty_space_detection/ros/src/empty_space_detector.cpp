@@ -112,13 +112,9 @@ void EmptySpaceDetector::eventInCallback(const std_msgs::String::ConstPtr &msg)
 void EmptySpaceDetector::pcCallback(const sensor_msgs::PointCloud2::ConstPtr &msg)
 {
   if (add_to_octree_) {
-    sensor_msgs::PointCloud2 msg_transformed;
-    if (!mpu::pointcloud::transformPointCloudMsg(tf_listener_, output_frame_, *msg,
-                                                 msg_transformed))
-      return;
-
     PointCloud::Ptr input_pc(new PointCloud);
-    pcl::fromROSMsg(msg_transformed, *input_pc);
+    if (!mpu::pointcloud::ingestPointCloudMsg(tf_listener_, output_frame_, *msg, *input_pc, false))
+      return;
 
     cloud_accumulation_->addCloud(input_pc);
 
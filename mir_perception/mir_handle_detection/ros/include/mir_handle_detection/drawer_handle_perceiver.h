@@ -17,7 +17,6 @@
 #include <pcl/filters/extract_indices.h>
 #include <pcl/filters/passthrough.h>
 #include <pcl/filters/project_inliers.h>
-#include <pcl/filters/voxel_grid.h>
 #include <pcl/point_types.h>
 #include <pcl/segmentation/extract_clusters.h>
 #include <pcl/segmentation/extract_polygonal_prism_data.h>
@@ -26,6 +25,9 @@
 
 #include <Eigen/Eigenvalues>
 
+#include <mir_perception_utils/pointcloud_utils_ros.h>
+#include <mir_perception_utils/voxel_filter.h>
+
 typedef pcl::PointCloud<pcl::PointXYZ> PCloudT;
 class DrawerHandlePerceiver
 {
@@ -50,7 +52,7 @@ class DrawerHandlePerceiver
 
   pcl::PassThrough<pcl::PointXYZ> passthrough_filter_y;
   pcl::PassThrough<pcl::PointXYZ> passthrough_filter_z;
-  pcl::VoxelGrid<pcl::PointXYZ> voxel_grid_filter;
+  mir_perception_utils::VoxelFilter<pcl::PointXYZ> voxel_grid_filter;
   pcl::SACSegmentation<pcl::PointXYZ> seg;
   pcl::ProjectInliers<pcl::PointXYZ> project_inliers;
   pcl::ConvexHull<pcl::PointXYZ> convex_hull;
@@ -61,8 +63,7 @@ class DrawerHandlePerceiver
   void checkFailure();
   void pcCallback(const sensor_msgs::PointCloud2::ConstPtr &msg);
   void eventInCallback(const std_msgs::String::ConstPtr &msg);
-  bool transformPC(const sensor_msgs::PointCloud2::ConstPtr &msg,
-                   sensor_msgs::PointCloud2 &msg_transformed);
+  bool transformPC(const sensor_msgs::PointCloud2::ConstPtr &msg, PCloudT &pc_transformed);
   void passthroughFilterPC(const PCloudT::Ptr &input, PCloudT::Ptr output);
   void extractPlaneOutlier(const PCloudT::Ptr &input, PCloudT::Ptr dense_input, PCloudT::Ptr output,
                            geometry_msgs::PoseStamped &pose_stamped);
@@ -98,23 +98,24 @@ void DrawerHandlePerceiver::pcCallback(const sensor_msgs::PointCloud2::ConstPtr
         return;
     }
 
-    sensor_msgs::PointCloud2 msg_transformed;
-    bool success = this->transformPC(msg, msg_transformed);
+    PCloudT::Ptr pc_input(new PCloudT);
+    bool success = this->transformPC(msg, *pc_input);
     if (!success) {
         ROS_ERROR("[drawer_handle_perceiver] Could not transform pointcloud.");
         this->checkFailure();
         return;
     }
 
-    PCloudT::Ptr pc_input(new PCloudT);
-    pcl::fromROSMsg(msg_transformed, *pc_input);
-
     PCloudT::Ptr pc_passthrough_filtered(new PCloudT);
     this->passthroughFilterPC(pc_input, pc_passthrough_filtered);
 
     PCloudT::Ptr pc_filtered(new PCloudT);
-    this->voxel_grid_filter.setInputCloud(pc_passthrough_filtered);
-    this->voxel_grid_filter.filter(*pc_filtered);
+    if (!this->voxel_grid_filter.filter(*pc_passthrough_filtered, *pc_filtered)) {
+        ROS_ERROR_STREAM("[drawer_handle_perceiver] Could not downsample pointcloud: "
+                         << this->voxel_grid_filter.getError());
+        this->checkFailure();
+        return;
+    }
 
     PCloudT::Ptr pc_segmented(new PCloudT);
     geometry_msgs::PoseStamped pose_stamped;
@@ -155,9 +156,8 @@ void DrawerHandlePerceiver::pcCallback(const sensor_msgs::PointCloud2::ConstPtr
 }
 
 bool DrawerHandlePerceiver::transformPC(const sensor_msgs::PointCloud2::ConstPtr &msg,
-        sensor_msgs::PointCloud2 &msg_transformed)
+        PCloudT &pc_transformed)
 {
-    msg_transformed.header.frame_id = this->output_frame;
     try {
         ros::Time common_time;
         this->tf_listener.getLatestCommonTime(this->output_frame, msg->header.frame_id, common_time,
@@ -167,7 +167,13 @@ bool DrawerHandlePerceiver::transformPC(const sensor_msgs::PointCloud2::ConstPtr
                 ros::Duration(1.0));
         this->tf_listener.lookupTransform(this->output_frame, msg->header.frame_id, common_time,
                 transform);
-        pcl_ros::transformPointCloud(this->output_frame, transform, *msg, msg_transformed);
+        // transform and convert in one pass, invalid points are dropped
+        Eigen::Matrix4f matrix;
+        pcl_ros::transformAsMatrix(transform, matrix);
+        if (!mir_perception_utils::pointcloud::ingestPointCloudMsg(*msg, matrix, pc_transformed, false)) {
+            return false;
+        }
+        pc_transformed.header.frame_id = this->output_frame;
         return true;
     } catch (tf::TransformException &ex) {
         ROS_WARN("PCL transform error: %s", ex.what());
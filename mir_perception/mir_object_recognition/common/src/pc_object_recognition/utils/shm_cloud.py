@@ -0,0 +1,110 @@
+import mmap
+import os
+import struct
+
+import numpy as np
+
+# Must match SharedMemoryRing and ClusterCloudTransport in cluster_cloud_transport.h
+HANDLE_PREFIX = "shm:"
+RING_MAGIC = 0x4352494d
+RING_VERSION = 1
+# magic, version, capacity, data offset, write position
+RING_HEADER = struct.Struct("<IIQQQ")
+WRITE_POSITION_OFFSET = 24
+
+# PointField datatypes
+NUMPY_TYPES = {1: np.int8, 2: np.uint8, 3: np.int16, 4: np.uint16,
+               5: np.int32, 6: np.uint32, 7: np.float32, 8: np.float64}
+
+
+class SharedMemoryCloudReader(object):
+    """
+    Reads the points of clouds passed as shared memory handles by the multimodal \
+    object recognition node. A handle is a PointCloud2 without data with an additional \
+    field named "shm:<segment>", the position of the points in the ring is stored in \
+    the offset (low 32 bits) and count (high 32 bits) of that field.
+    """
+
+    def __init__(self):
+        self.segments = {}
+
+    @staticmethod
+    def get_handle(pc):
+        """
+        Get the shared memory handle of a pointcloud
+
+        :param pc:      The input pointcloud
+        :type:          sensor_msgs.PointCloud2
+
+        :return:        Segment name and position, None if the cloud carries its data
+        :rtype:         tuple
+        """
+        if pc.data:
+            return None
+        for field in pc.fields:
+            if field.name.startswith(HANDLE_PREFIX):
+                return field.name[len(HANDLE_PREFIX):], field.offset | (field.count << 32)
+        return None
+
+    def _open(self, name):
+        segment = self.segments.get(name)
+        if segment is not None:
+            return segment
+        # the segments of a restarted writer have a new name, drop the old ones
+        self.close()
+        fd = os.open(os.path.join("/dev/shm", name), os.O_RDONLY)
+        try:
+            buf = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+        magic, version, capacity, data_offset, _ = RING_HEADER.unpack_from(buf, 0)
+        if magic != RING_MAGIC or version != RING_VERSION:
+            buf.close()
+            raise ValueError("%s is not a cluster cloud ring" % name)
+        segment = (buf, capacity, data_offset)
+        self.segments[name] = segment
+        return segment
+
+    def close(self):
+        for buf, _, _ in self.segments.values():
+            buf.close()
+        self.segments = {}
+
+    def read_points(self, pc, field_names):
+        """
+        Read the fields of the points of a shared memory handle
+
+        :param pc:            The handle
+        :type:                sensor_msgs.PointCloud2
+        :param field_names:   Names of the fields to read
+        :type:                tuple
+
+        :return:        N x len(field_names) array, None if the segment is not \
+                        available or the points were overwritten in the meantime
+        :rtype:         numpy.array
+        """
+        name, position = self.get_handle(pc)
+        try:
+            buf, capacity, data_offset = self._open(name)
+        except (OSError, ValueError):
+            return None
+        num_points = pc.width * pc.height
+        size = num_points * pc.point_step
+        write_position, = struct.unpack_from("<Q", buf, WRITE_POSITION_OFFSET)
+        if position + size > write_position or write_position > position + capacity:
+            return None
+        start = data_offset + position % capacity
+        data = buf[start:start + size]
+        # the writer reserves before writing, so the copy is intact if the ring did not
+        # advance by more than its capacity
+        write_position, = struct.unpack_from("<Q", buf, WRITE_POSITION_OFFSET)
+        if write_position > position + capacity:
+            return None
+
+        fields = {field.name: field for field in pc.fields}
+        dtype = np.dtype({'names': list(field_names),
+                          'formats': [NUMPY_TYPES[fields[f].datatype] for f in field_names],
+                          'offsets': [fields[f].offset for f in field_names],
+                          'itemsize': pc.point_step})
+        points = np.frombuffer(data, dtype=dtype, count=num_points)
+        return np.stack([points[f].astype(np.float64) for f in field_names], axis=1)
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_BOUNDED_QUEUE_H
+#define MIR_OBJECT_RECOGNITION_BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/** \brief Thread safe FIFO queue with a fixed capacity, used to connect pipeline stages.
+ *
+ * When the queue is full, push() either drops the oldest element (for sources that
+ * should always process the most recent data, e.g. camera frames) or blocks until
+ * the consumer made room (for stages that must not lose work).
+ * close() wakes up all waiting threads, pop() then returns false once the queue is empty.
+ */
+template <typename T>
+class BoundedQueue
+{
+  public:
+    /** \brief Constructor
+     * \param[in] Maximum number of queued elements
+     * \param[in] Drop the oldest element instead of blocking when the queue is full
+     * */
+    BoundedQueue(size_t capacity, bool drop_oldest)
+      : capacity_(capacity > 0 ? capacity : 1), drop_oldest_(drop_oldest), closed_(false)
+    {
+    }
+
+    /** \brief Push an element
+     * \return Number of dropped elements, always 0 for blocking queues
+     * */
+    size_t push(const T &item)
+    {
+      size_t dropped = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (drop_oldest_)
+        {
+          while (queue_.size() >= capacity_)
+          {
+            queue_.pop_front();
+            dropped++;
+          }
+        }
+        else
+        {
+          not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+        }
+        if (closed_)
+          return dropped;
+        queue_.push_back(item);
+      }
+      not_empty_.notify_one();
+      return dropped;
+    }
+
+    /** \brief Pop the oldest element, blocks until an element is available
+     * \return False if the queue was closed and is empty
+     * */
+    bool pop(T &item)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty())
+          return false;
+        item = queue_.front();
+        queue_.pop_front();
+      }
+      not_full_.notify_one();
+      return true;
+    }
+
+    /** \brief Close the queue and wake up all waiting threads */
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+      }
+      not_empty_.notify_all();
+      not_full_.notify_all();
+    }
+
+    /** \brief Remove all elements and reopen the queue */
+    void reset()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.clear();
+      closed_ = false;
+    }
+
+    size_t size()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return queue_.size();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> queue_;
+    size_t capacity_;
+    bool drop_oldest_;
+    bool closed_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_BOUNDED_QUEUE_H
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_CLUSTER_CLOUD_TRANSPORT_H
+#define MIR_OBJECT_RECOGNITION_CLUSTER_CLOUD_TRANSPORT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <sensor_msgs/PointCloud2.h>
+#include <std_msgs/Header.h>
+
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Single writer byte ring in a POSIX shared memory segment.
+ *
+ * Records are addressed by their absolute position, i.e. the number of bytes written to
+ * the ring before them. The writer reserves a record by advancing the write position
+ * before copying the data, so a reader can tell that a record was overwritten after it
+ * copied it: the record is intact as long as the write position is at most
+ * position + capacity. Records never wrap around the end of the ring.
+ *
+ * Segment layout: Header, padded to DATA_OFFSET bytes, followed by capacity bytes of data.
+ */
+class SharedMemoryRing
+{
+  public:
+    static const uint32_t MAGIC = 0x4352494d;  // "MIRC"
+    static const uint32_t VERSION = 1;
+    static const uint64_t DATA_OFFSET = 64;
+
+    struct Header
+    {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t capacity;
+      uint64_t data_offset;
+      std::atomic<uint64_t> write_position;
+    };
+
+    SharedMemoryRing();
+    ~SharedMemoryRing();
+
+    /** \brief Create (or recreate) and map the segment, the segment is unlinked on destruction
+     * \param[in] Segment name, e.g. "/mir_cluster_clouds"
+     * \param[in] Capacity of the ring in bytes
+     * \return False if the segment cannot be created or mapped
+     * */
+    bool create(const std::string &name, size_t capacity);
+
+    bool isOpen() const { return header_ != nullptr; }
+
+    /** \brief Copy a record into the ring
+     * \param[in] Data of the record
+     * \param[in] Size of the record in bytes
+     * \param[out] Absolute position of the record
+     * \return False if the ring is not open or the record is larger than half the ring
+     * */
+    bool write(const void *data, size_t size, uint64_t &position);
+
+    const std::string &name() const { return name_; }
+    size_t capacity() const { return capacity_; }
+
+  private:
+    void close();
+
+    std::string name_;
+    size_t capacity_;
+    size_t mapped_size_;
+    Header *header_;
+    uint8_t *data_;
+};
+
+/** \brief Passes 3D clusters to the pc recognizer through shared memory instead of
+ * serializing the points into the object list.
+ *
+ * The cloud of the object is replaced by a handle: a PointCloud2 with the fields, width,
+ * height and point step of the cluster, but without data. An additional field named
+ * HANDLE_PREFIX + segment name (datatype 0) carries the position of the points in the
+ * ring, low 32 bits in offset and high 32 bits in count. The recognizer reads the points
+ * from the segment and falls back to the data of the message if there is no handle.
+ * Single writer, not thread safe.
+ */
+class ClusterCloudTransport
+{
+  public:
+    static const char HANDLE_PREFIX[];
+
+    ClusterCloudTransport();
+
+    /** \brief Create the shared memory ring
+     * \param[in] Segment name
+     * \param[in] Capacity of the ring in bytes
+     * \return False if shared memory is not available, encode() then always fails
+     * */
+    bool open(const std::string &name, size_t capacity);
+
+    bool isOpen() const { return ring_.isOpen(); }
+
+    /** \brief Write the cluster to the ring and create its handle
+     * \param[in] Cluster
+     * \param[in] Header of the handle
+     * \param[out] Handle, unchanged on failure
+     * \return False if the ring is not open or the cluster does not fit, the caller sends
+     *     the cluster in the message then
+     * */
+    bool encode(const PointCloud &cluster, const std_msgs::Header &header, sensor_msgs::PointCloud2 &handle);
+
+  private:
+    SharedMemoryRing ring_;
+    // Fields and point step of PointT
+    sensor_msgs::PointCloud2 layout_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_CLUSTER_CLOUD_TRANSPORT_H
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_CONTAINER_RIM_ESTIMATOR_H
+#define MIR_OBJECT_RECOGNITION_CONTAINER_RIM_ESTIMATOR_H
+
+#include <Eigen/Dense>
+
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Estimates the center of a container from its segmented cloud, in place of
+ * region growing over freshly estimated normals.
+ *
+ * The points below the floor slice (the lower part of the container, under its rim)
+ * are rasterized into a 2D occupancy grid in x and y. A cell is flat if the height
+ * spread of its points is within the flatness tolerance, and, if normals are given,
+ * its points face up. Neighbouring flat cells of similar height are connected, the
+ * center is the centroid of the points of the largest connected region, which is
+ * the floor of the container. The cloud must be in a frame with z pointing up.
+ */
+class ContainerRimEstimator
+{
+  public:
+    struct Params
+    {
+      Params();
+
+      double cell_size;           // raster cell size in meters
+      double floor_slice;         // fraction of the height of the cloud above its lowest point
+      double flatness_tolerance;  // max height spread in a cell and between neighbours, meters
+      double max_normal_angle;    // max angle of the normals to the z axis, radians
+      int min_points;             // min points of the floor region
+      int max_cells;              // the cell size is increased if the raster has more cells
+    };
+
+    ContainerRimEstimator();
+
+    void setParams(const Params &params);
+
+    /** \brief Estimate the center of the container floor
+     * \param[in] Cloud of the container, with z pointing up
+     * \param[out] Centroid of the floor region
+     * \param[out] Highest point of the cloud, the top of the rim
+     * \param[in] Normals of the cloud from the segmentation, optional, ignored if they do
+     *     not match the size of the cloud
+     * \return False if no flat region with enough points is found
+     * */
+    bool estimate(const PointCloud &cloud, Eigen::Vector3f &center, float &rim_height,
+                  const PointCloudN::ConstPtr &normals = PointCloudN::ConstPtr()) const;
+
+  private:
+    Params params_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_CONTAINER_RIM_ESTIMATOR_H
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_DATASET_WRITER_H
+#define MIR_OBJECT_RECOGNITION_DATASET_WRITER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <sensor_msgs/Image.h>
+
+#include <mir_object_recognition/bounded_queue.h>
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Writes dataset samples (point cloud clusters and raw images) to disk in a
+ * background thread, so that data collection does not stall the perception pipeline.
+ *
+ * Point clouds are written as binary compressed PCD, images as lossless PNG. Samples are
+ * queued in a bounded queue, if the writer falls behind the oldest queued sample is
+ * dropped. Once the disk budget is used up, new samples are rejected.
+ */
+class DatasetWriter
+{
+  public:
+    struct Stats
+    {
+      uint64_t queued;         // samples accepted into the queue
+      uint64_t written;        // samples written to disk
+      uint64_t dropped;        // samples dropped because the queue was full
+      uint64_t over_budget;    // samples rejected because the disk budget is used up
+      uint64_t failed;         // samples which could not be written
+      uint64_t bytes_written;
+      size_t queue_size;       // samples currently waiting
+    };
+
+    /** \brief Constructor
+     * \param[in] Directory the samples are written to
+     * \param[in] Max number of queued samples
+     * \param[in] Disk budget in bytes, 0 for unlimited
+     * */
+    DatasetWriter(const std::string &logdir, size_t queue_size, uint64_t disk_budget);
+
+    /** \brief Destructor, writes the remaining queued samples */
+    virtual ~DatasetWriter();
+
+    /** \brief Queue a point cloud, written as <logdir>/<name>.pcd
+     * \return False if the sample was rejected
+     * */
+    bool savePointCloud(const PointCloud::ConstPtr &cloud, const std::string &name);
+
+    /** \brief Queue an image, converted to BGR8 and written as <logdir>/<name>.png
+     * \return False if the sample was rejected
+     * */
+    bool saveImage(const sensor_msgs::ImageConstPtr &image, const std::string &name);
+
+    Stats getStats();
+
+  private:
+    struct Sample
+    {
+      std::string name;
+      PointCloud::ConstPtr cloud;
+      sensor_msgs::ImageConstPtr image;
+    };
+
+    bool enqueue(const Sample &sample);
+    void writerLoop();
+    bool write(const Sample &sample, std::string &filename);
+
+    std::string logdir_;
+    uint64_t disk_budget_;
+    BoundedQueue<Sample> queue_;
+    std::thread writer_thread_;
+
+    std::mutex stats_mutex_;
+    Stats stats_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_DATASET_WRITER_H
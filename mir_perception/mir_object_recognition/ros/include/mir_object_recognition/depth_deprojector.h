@@ -0,0 +1,101 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_DEPTH_DEPROJECTOR_H
+#define MIR_OBJECT_RECOGNITION_DEPTH_DEPROJECTOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/core/core.hpp>
+#include <sensor_msgs/CameraInfo.h>
+
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Deprojects regions of a depth image into points, with the ray of every pixel
+ * precomputed from the camera info.
+ *
+ * The rays are undistorted once with the distortion of the camera info, a pixel is then
+ * deprojected with its depth and transformed to the target frame in a single pass. This
+ * replaces the organized XYZRGB cloud of the camera, the depth image is a fraction of its
+ * size, and only the pixels which are needed are deprojected. Thread safe, immutable.
+ */
+class DepthDeprojector
+{
+  public:
+    typedef std::shared_ptr<const DepthDeprojector> ConstPtr;
+
+    /** \brief Compute the rays of the camera
+     * \param[in] Camera info of the depth image (aligned depth: of the color camera)
+     * */
+    explicit DepthDeprojector(const sensor_msgs::CameraInfo &camera_info);
+
+    /** \brief Whether the rays were computed for this camera info */
+    bool matches(const sensor_msgs::CameraInfo &camera_info) const;
+
+    /** \brief False if the camera info has no size or no focal length */
+    bool isValid() const { return !rays_.empty(); }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    /** \brief Deproject a region of a depth image
+     * \param[in] Depth image of the camera size, 16UC1 in millimeters or 32FC1 in meters
+     * \param[in] BGR image registered to the depth image, empty for white points
+     * \param[in] Rotation from the camera to the target frame
+     * \param[in] Translation from the camera to the target frame
+     * \param[in] Region of the depth image, clipped to the image
+     * \param[in] Pixel step, 1 deprojects every pixel of the region
+     * \param[in] Keep the region organized with NaN points for invalid depth, or only
+     *            keep the valid points
+     * \param[out] Points in the target frame, the header is not set
+     * \return False if the depth image does not match the camera or has an unknown type
+     * */
+    bool deproject(const cv::Mat &depth, const cv::Mat &color, const Eigen::Matrix3f &rotation,
+                   const Eigen::Vector3f &translation, const cv::Rect &region, int stride,
+                   bool organized, PointCloud &cloud) const;
+
+  private:
+    int width_;
+    int height_;
+    std::vector<double> intrinsics_;
+    std::vector<double> distortion_;
+    // x and y of the ray of every pixel at a depth of 1, row major
+    std::vector<float> rays_;
+};
+
+/** \brief Depth input of a view, kept so that regions of it can be deprojected at full
+ * resolution after the segmentation, e.g. the ROIs of the rgb detections
+ */
+struct DepthView
+{
+  DepthView()
+    : rotation(Eigen::Matrix3f::Identity()), translation(Eigen::Vector3f::Zero()), cloud_stride(1)
+  {
+  }
+
+  /** \brief Deproject a region of the image the rgb detections are found in
+   * \param[in] Region in the pixels of an image of the given size, scaled to the depth image
+   * \param[in] Width of the image of the region
+   * \param[in] Height of the image of the region
+   * \param[out] Valid points of the region in the target frame
+   * */
+  bool deprojectRegion(const cv::Rect &region, int image_width, int image_height,
+                       PointCloud &cloud) const;
+
+  cv_bridge::CvImageConstPtr depth;
+  // BGR image registered to the depth image, null if the sizes differ
+  cv_bridge::CvImageConstPtr color;
+  DepthDeprojector::ConstPtr deprojector;
+  Eigen::Matrix3f rotation;
+  Eigen::Vector3f translation;
+  std::string frame_id;
+  // Pixels of the depth image per point of the view cloud
+  int cloud_stride;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_DEPTH_DEPROJECTOR_H
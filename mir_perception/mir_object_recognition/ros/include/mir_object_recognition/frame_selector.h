@@ -0,0 +1,108 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_FRAME_SELECTOR_H
+#define MIR_OBJECT_RECOGNITION_FRAME_SELECTOR_H
+
+#include <vector>
+
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <mir_object_recognition/stage_latency.h>
+
+/** \brief Collects a short window of synchronized image and pointcloud (or depth image) pairs and selects
+ * the best one, since the first frame after the arm stopped is often motion blurred or
+ * has depth holes.
+ *
+ * Every candidate is scored cheaply:
+ *  - valid depth ratio, fraction of finite points on a subsampled grid of the cloud
+ *  - sharpness, variance of the Laplacian of the downscaled grayscale image, normalized
+ *    by the sharpest candidate of the window
+ *  - depth stability, fraction of grid points whose depth agrees with the previous
+ *    candidate, low while the camera or the scene is still moving
+ * The score is the weighted sum of the three. Not thread safe.
+ */
+class FrameSelector
+{
+  public:
+    struct Params
+    {
+      Params();
+
+      size_t window_size;           // number of candidates, 1 selects the first frame
+      int image_width;              // width of the downscaled image for the sharpness
+      int depth_stride;             // grid step in points for the depth metrics
+      double stability_tolerance;   // max depth difference of a stable point in meters
+      double depth_weight;
+      double sharpness_weight;
+      double stability_weight;
+    };
+
+    struct Quality
+    {
+      Quality() : valid_depth_ratio(0.0), sharpness(0.0), stability(1.0), score(0.0) {}
+
+      double valid_depth_ratio;
+      double sharpness;
+      double stability;
+      double score;
+    };
+
+    FrameSelector();
+
+    void setParams(const Params &params);
+
+    /** \brief Score and add a candidate
+     * \return True if the window is full
+     * */
+    bool add(const sensor_msgs::ImageConstPtr &image, const sensor_msgs::PointCloud2ConstPtr &cloud);
+
+    /** \brief Score and add a candidate with a depth image instead of a pointcloud
+     * \return True if the window is full
+     * */
+    bool add(const sensor_msgs::ImageConstPtr &image, const sensor_msgs::ImageConstPtr &depth);
+
+    /** \brief Select the best candidate and clear the window
+     * \param[out] Image of the best candidate
+     * \param[out] Pointcloud of the best candidate, null for depth candidates
+     * \param[out] Depth image of the best candidate, null for pointcloud candidates
+     * \param[out] Quality of the best candidate
+     * \return False if there are no candidates
+     * */
+    bool select(sensor_msgs::ImageConstPtr &image, sensor_msgs::PointCloud2ConstPtr &cloud,
+                sensor_msgs::ImageConstPtr &depth, Quality &quality);
+
+    /** \brief Drop all candidates */
+    void reset();
+
+    size_t size() const { return candidates_.size(); }
+
+    /** \brief Time since the first candidate of the window in seconds */
+    double age() const { return window_timer_.elapsed(); }
+
+  private:
+    struct Candidate
+    {
+      sensor_msgs::ImageConstPtr image;
+      sensor_msgs::PointCloud2ConstPtr cloud;
+      sensor_msgs::ImageConstPtr depth;
+      Quality quality;
+      std::vector<float> depth_samples;
+    };
+
+    double sharpness(const sensor_msgs::ImageConstPtr &image) const;
+    /** \brief Sample the depth on a grid, NaN for invalid points
+     * \return Valid depth ratio */
+    double sampleDepth(const sensor_msgs::PointCloud2 &cloud, std::vector<float> &samples) const;
+    double sampleDepth(const sensor_msgs::Image &depth, std::vector<float> &samples) const;
+    /** \brief Score the new candidate against the previous one and add it */
+    bool addCandidate(Candidate &candidate);
+    double depthStability(const std::vector<float> &a, const std::vector<float> &b) const;
+
+    Params params_;
+    std::vector<Candidate> candidates_;
+    StageTimer window_timer_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_FRAME_SELECTOR_H
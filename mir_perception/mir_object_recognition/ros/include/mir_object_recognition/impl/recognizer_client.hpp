@@ -0,0 +1,144 @@
+#ifndef RECOGNIZER_CLIENT_HPP
+#define RECOGNIZER_CLIENT_HPP
+
+#include <utility>
+
+namespace recognizer_client
+{
+/** Tag every object of a cloud request with the correlation id. */
+inline void setCorrelationId(mas_perception_msgs::ObjectList &msg, uint32_t id)
+{
+  for (auto &object : msg.objects)
+  {
+    object.pose.header.seq = id;
+  }
+}
+
+/** Tag every image of an image request with the correlation id. */
+inline void setCorrelationId(mas_perception_msgs::ImageList &msg, uint32_t id)
+{
+  for (auto &image : msg.images)
+  {
+    image.header.seq = id;
+  }
+}
+
+/** Correlation id of a reply, 0 if the reply is not tagged. */
+inline uint32_t getCorrelationId(const mas_perception_msgs::ObjectList &msg)
+{
+  if (msg.objects.empty())
+    return 0;
+  return msg.objects[0].pose.header.seq;
+}
+
+/** Pending request a reply answers: the request with its correlation id, or the oldest
+ * request for an untagged reply. The ids are handed out in increasing order starting
+ * after next_id, wrapping around and skipping 0. Returns pending.end() if there is none. */
+template <typename MapT>
+typename MapT::iterator findRequest(MapT &pending, uint32_t id, uint32_t next_id)
+{
+  if (id != 0)
+    return pending.find(id);
+  auto oldest = pending.end();
+  uint32_t max_age = 0;
+  for (auto it = pending.begin(); it != pending.end(); ++it)
+  {
+    // unsigned arithmetic, correct across the wrap-around
+    const uint32_t age = next_id - it->first;
+    if (oldest == pending.end() || age > max_age)
+    {
+      oldest = it;
+      max_age = age;
+    }
+  }
+  return oldest;
+}
+}  // namespace recognizer_client
+
+template <typename RequestT>
+RecognizerClient<RequestT>::RecognizerClient(const ros::NodeHandle &nh,
+                                             const std::string &request_topic,
+                                             const std::string &reply_topic,
+                                             ros::CallbackQueue *callback_queue)
+    : nh_(nh), next_id_(1)
+{
+  nh_.setCallbackQueue(callback_queue);
+  pub_request_ = nh_.advertise<RequestT>(request_topic, 10);
+  sub_reply_ = nh_.subscribe(reply_topic, 10, &RecognizerClient<RequestT>::replyCallback, this);
+}
+
+template <typename RequestT>
+uint32_t RecognizerClient<RequestT>::request(RequestT &msg, std::future<Reply> &reply)
+{
+  uint32_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = next_id_++;
+    // 0 is reserved for untagged replies
+    if (next_id_ == 0)
+      next_id_ = 1;
+    std::promise<Reply> promise;
+    reply = promise.get_future();
+    pending_[id] = std::move(promise);
+  }
+  recognizer_client::setCorrelationId(msg, id);
+  pub_request_.publish(msg);
+  return id;
+}
+
+template <typename RequestT>
+bool RecognizerClient<RequestT>::waitForReply(uint32_t id, std::future<Reply> &future,
+                                              const Clock::time_point &deadline, Reply &reply)
+{
+  if (future.wait_until(deadline) == std::future_status::ready)
+  {
+    try
+    {
+      reply = future.get();
+      return true;
+    }
+    catch (const std::future_error &e)
+    {
+      // the request was cancelled while waiting
+      return false;
+    }
+  }
+  cancel(id);
+  return false;
+}
+
+template <typename RequestT>
+void RecognizerClient<RequestT>::cancel(uint32_t id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.erase(id);
+}
+
+template <typename RequestT>
+void RecognizerClient<RequestT>::cancelAll()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.clear();
+}
+
+template <typename RequestT>
+void RecognizerClient<RequestT>::replyCallback(const Reply::ConstPtr &msg)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pending_.empty())
+  {
+    ROS_DEBUG("[RecognizerClient] Dropping reply, no pending request");
+    return;
+  }
+  uint32_t id = recognizer_client::getCorrelationId(*msg);
+  auto it = recognizer_client::findRequest(pending_, id, next_id_);
+  if (it == pending_.end())
+  {
+    ROS_DEBUG("[RecognizerClient] Dropping stale reply for request %u", id);
+    return;
+  }
+  it->second.set_value(*msg);
+  pending_.erase(it);
+}
+
+#endif /* RECOGNIZER_CLIENT_HPP */
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_JOB_QUEUE_H
+#define MIR_OBJECT_RECOGNITION_JOB_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/** \brief Thread safe priority queue of jobs with ids, feeds the perception job worker.
+ *
+ * Jobs with a higher priority are popped first, jobs of the same priority in the order
+ * they were pushed. Queued jobs can be removed by their id until they are popped.
+ * close() wakes up all waiting threads, pop() then returns false.
+ */
+template <typename T>
+class JobQueue
+{
+  public:
+    JobQueue() : next_id_(1), closed_(false) {}
+
+    /** \brief Queue a job
+     * \param[in] Job
+     * \param[in] Priority, higher is popped first
+     * \return Id of the job, never 0, or 0 if the queue is closed
+     * */
+    uint32_t push(const T &job, int priority)
+    {
+      uint32_t id;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_)
+          return 0;
+        id = next_id_++;
+        if (next_id_ == 0)
+          next_id_ = 1;
+        jobs_.emplace(Key(-static_cast<int64_t>(priority), id), job);
+      }
+      not_empty_.notify_one();
+      return id;
+    }
+
+    /** \brief Pop the next job, blocks until a job is available
+     * \return False if the queue was closed
+     * */
+    bool pop(uint32_t &id, T &job)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this] { return closed_ || !jobs_.empty(); });
+      if (closed_)
+        return false;
+      id = jobs_.begin()->first.second;
+      job = std::move(jobs_.begin()->second);
+      jobs_.erase(jobs_.begin());
+      return true;
+    }
+
+    /** \brief Remove a queued job
+     * \return False if the job is not queued (anymore)
+     * */
+    bool remove(uint32_t id)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto it = jobs_.begin(); it != jobs_.end(); ++it)
+      {
+        if (it->first.second == id)
+        {
+          jobs_.erase(it);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /** \brief Remove all queued jobs
+     * \return The removed jobs, in the order they would have been popped
+     * */
+    std::vector<T> clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::vector<T> removed;
+      removed.reserve(jobs_.size());
+      for (auto &entry : jobs_)
+      {
+        removed.push_back(std::move(entry.second));
+      }
+      jobs_.clear();
+      return removed;
+    }
+
+    /** \brief Number of jobs which are popped before the given one
+     * \return -1 if the job is not queued
+     * */
+    int position(uint32_t id)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      int position = 0;
+      for (const auto &entry : jobs_)
+      {
+        if (entry.first.second == id)
+          return position;
+        position++;
+      }
+      return -1;
+    }
+
+    /** \brief Close the queue and wake up all waiting threads, queued jobs are dropped */
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        jobs_.clear();
+      }
+      not_empty_.notify_all();
+    }
+
+    size_t size()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return jobs_.size();
+    }
+
+  private:
+    // negated priority and id, the first entry is the next job
+    typedef std::pair<int64_t, uint32_t> Key;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::map<Key, T> jobs_;
+    uint32_t next_id_;
+    bool closed_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_JOB_QUEUE_H
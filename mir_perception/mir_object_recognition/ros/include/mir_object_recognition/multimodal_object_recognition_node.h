@@ -8,12 +8,22 @@
 #define MIR_OBJECT_RECOGNITION_MULTIMODAL_OBJECT_RECOGNITION_ROS_H
 
 #include <Eigen/Dense>
+#include <atomic>
+#include <condition_variable>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
+#include <actionlib/server/action_server.h>
+
+#include <geometry_msgs/PoseArray.h>
 #include <ros/ros.h>
+#include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/RegionOfInterest.h>
 
@@ -26,32 +36,82 @@
 #include <pcl_ros/point_cloud.h>
 
 #include <dynamic_reconfigure/server.h>
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <ros/callback_queue.h>
 
+#include <mas_perception_msgs/ImageList.h>
 #include <mas_perception_msgs/ObjectList.h>
 
+#include <mir_object_recognition/RecognizeObjectsAction.h>
 #include <mir_object_recognition/SceneSegmentationConfig.h>
-#include <mir_object_recognition/multimodal_object_recognition_utils.h>
-#include <mir_object_segmentation/scene_segmentation_ros.h>
+#include <mir_object_recognition/bounded_queue.h>
+#include <mir_object_recognition/cluster_cloud_transport.h>
+#include <mir_object_recognition/dataset_writer.h>
+#include <mir_object_recognition/depth_deprojector.h>
+#include <mir_object_recognition/frame_selector.h>
+#include <mir_object_recognition/job_queue.h>
+#include <mir_object_recognition/onnx_detector.h>
+#include <mir_object_recognition/multimodal_object_recognition_pipeline.h>
+#include <mir_object_recognition/perception_frame.h>
+#include <mir_object_recognition/perceived_object_store.h>
+#include <mir_object_recognition/recognition_cache.h>
+#include <mir_object_recognition/stage_latency.h>
+#include <mir_object_recognition/recognizer_client.h>
+#include <mir_perception_utils/bounding_box_visualizer.h>
+#include <mir_perception_utils/clustered_point_cloud_visualizer.h>
+#include <mir_perception_utils/label_visualizer.h>
+#include <mir_perception_utils/lazy_publisher.h>
 #include <mir_perception_utils/object_utils_ros.h>
 #include <mir_perception_utils/pointcloud_utils_ros.h>
 
 /** \brief This node subscribes to pointcloud and image_raw topics synchronously.
  * Inputs:
  * ~event_in:
- *      - e_start:  - starts subscribing to pointcloud and image topics simultaneously,
+ *      - e_start:  - queues a perception job (priority 0), the job worker starts subscribing to
+ *                pointcloud and image topics simultaneously,
+ *              - scores the first frame_selection_window frames (valid depth, sharpness, depth
+ *                stability) and processes the best one
  *              - segments pointcloud, recognize the table top clusters, estimate pose and workspace height
- *              - detects rgb object, find 3D ROI, estimate pose
+ *              - clusters matching a recently recognized cluster (extent, point count, colour
+ *                histogram and position) are labelled from the recognition cache, only the
+ *                other clusters are sent to the pc recognizer, with cluster_shm_transport
+ *                the points are passed in a shared memory ring and the message only carries
+ *                a handle
+ *              - detects rgb object (optionally in the image cropped to the workspace and
+ *                downscaled), find 3D ROI, estimate pose
  *              - adjusts object pose and publish them
- *      - e_stop:   - stop subscribing to the input topics and clear accumulated pointcloud
+ *      - e_add_view: - captures one image and pointcloud pair from the current camera pose and adds
+ *              it to the accumulated scene without running recognition. The next e_start fuses all
+ *              added viewpoints with its own, segments and recognizes the fused scene once, and
+ *              projects every rgb detection into the cloud of the view it was detected in.
+ *      - e_start_continuous: - same as e_start, but keeps processing frames until e_stop.
+ *              The stages run as a pipeline: segmentation of frame N+1 overlaps with recognition
+ *              of frame N and with pose adjustment of frame N-1. Stale frames are dropped when
+ *              the pipeline is busy (continuous_queue_size). Every object list is published with
+ *              the stamp of its frame in the object pose headers.
+ *      - e_stop:   - stop subscribing to the input topics, cancel the perception jobs and clear
+ *                accumulated pointcloud
  *      - e_data_collection -  start dataset collection mode (save dir is defined in launch file).
  *                   If enable, this node will not do any recognition.
+ * ~recognize_objects (mir_object_recognition/RecognizeObjects action):
+ *      - queues a perception job like e_start, with a priority and a delay before the frame is
+ *        captured, so that it can be submitted early (e.g. while the base is still moving) and
+ *        its result collected later. Jobs are processed one at a time by a worker thread, the
+ *        highest priority first. Queued and running jobs can be canceled, the feedback reports
+ *        the job id, its state and its position in the queue. The result holds the object list,
+ *        which is only published on output/object_list if publish_objects is set. Jobs with a
+ *        workstation reuse the objects stored for it if the scene did not change since.
  * Outputs:
  * ~event_out:
  *      - e_done:   - done recognizing pointcloud and image, done pose estimation and done publishing object_list
+ *      - e_view_added: - viewpoint captured and accumulated
+ *      - e_started_continuous: - continuous perception started
  *      - e_stopped:  - done unsubscribing, done clearing accumulated point clouds
  *      - e_data_collection - data collection mode started
  * 
  * Topics output: rgb, pointcloud and multimodal object_lists, workspace_height.
+ * Topics output for instrumentation: stage_latency (per frame, monotonic clock), /diagnostics
+ *      with rolling p50/p95/p99 latency of every stage.
  * Topics output for visualization: pose array, bounding boxes and labels for both rgb and point cloud
  * 
  * \author Mohammad Wasil
@@ -63,15 +123,6 @@ using mpu::visualization::ClusteredPointCloudVisualizer;
 using mpu::visualization::LabelVisualizer;
 using mpu::visualization::Color;
 
-struct Object
-{
-  std::string name;
-  std::string shape;
-  std::string color;
-};
-
-typedef std::vector<Object> ObjectInfo;
-
 class MultimodalObjectRecognitionROS
 {
   public:
@@ -97,21 +148,25 @@ class MultimodalObjectRecognitionROS
     
     dynamic_reconfigure::Server<mir_object_recognition::SceneSegmentationConfig> server_;
 
-    // Publisher for clouds and images recognizer
-    ros::Publisher pub_cloud_to_recognizer_;
-    ros::Publisher pub_image_to_recognizer_;
-    // Subscriber for clouds and images recognizer
-    ros::Subscriber sub_recognized_image_list_;
-    ros::Subscriber sub_recognized_cloud_list_;
+    // Request layer for clouds and images recognizer, replies are handled
+    // on a separate callback queue so they can be awaited from the spin thread
+    ros::CallbackQueue recognizer_callback_queue_;
+    boost::shared_ptr<ros::AsyncSpinner> recognizer_spinner_;
+    boost::shared_ptr<CloudRecognizerClient> cloud_recognizer_client_;
+    boost::shared_ptr<ImageRecognizerClient> image_recognizer_client_;
+    // In-process rgb detector, replaces the rgb recognizer node if set
+    std::unique_ptr<OnnxDetector> rgb_detector_;
+    // Cluster points for the pc recognizer in shared memory, optional (cluster_shm_transport)
+    ClusterCloudTransport cluster_transport_;
     // Publisher object list
     ros::Publisher pub_object_list_;
     ros::Publisher pub_workspace_height_;
-    // Publisher pose array (debug_mode only)
-    ros::Publisher pub_pc_object_pose_array_;
-    ros::Publisher pub_rgb_object_pose_array_;
+    // Publisher pose array (debug_mode only), debug messages are only built if subscribed
+    mpu::LazyPublisher<geometry_msgs::PoseArray> pub_pc_object_pose_array_;
+    mpu::LazyPublisher<geometry_msgs::PoseArray> pub_rgb_object_pose_array_;
     // Publisher debug
-    ros::Publisher pub_debug_cloud_plane_;
-    ros::Publisher pub_filtered_rgb_cloud_plane_;
+    mpu::LazyPublisher<sensor_msgs::PointCloud2> pub_debug_cloud_plane_;
+    mpu::LazyPublisher<sensor_msgs::PointCloud2> pub_filtered_rgb_cloud_plane_;
     std::string horizontal_object_list[9];
 
     // Synchronize callback for image and pointcloud
@@ -122,39 +177,143 @@ class MultimodalObjectRecognitionROS
     void synchronizeCallback(const sensor_msgs::ImageConstPtr &image, 
                  const sensor_msgs::PointCloud2ConstPtr &cloud);
 
-    // Recognize Clouds and Image callback
-    void recognizedImageCallback(const mas_perception_msgs::ObjectList &msg);
-    void recognizedCloudCallback(const mas_perception_msgs::ObjectList &msg);
+    // Synchronize callback for image, depth image and camera info (input_mode "depth")
+    bool depth_input_;
+    int depth_cloud_stride_;
+    message_filters::Subscriber<sensor_msgs::Image> *depth_sub_;
+    message_filters::Subscriber<sensor_msgs::CameraInfo> *camera_info_sub_;
+    typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::Image, sensor_msgs::Image,
+                                                            sensor_msgs::CameraInfo> depthSyncPolicy;
+    message_filters::Synchronizer<depthSyncPolicy> *depth_sync_;
+    // Rays of the depth camera, recomputed only if the camera info changes
+    DepthDeprojector::ConstPtr deprojector_;
+    void synchronizeDepthCallback(const sensor_msgs::ImageConstPtr &image,
+                                  const sensor_msgs::ImageConstPtr &depth,
+                                  const sensor_msgs::CameraInfoConstPtr &camera_info);
+
+    // Frame quality selection, scores the first synchronized frames after e_start
+    FrameSelector frame_selector_;
+    double frame_selection_timeout_;
+    /** \brief Use the best candidate of the frame selector as input */
+    void selectFrame();
+
+    // Correlation ids of the recognizer requests of a frame, to cancel them from another thread
+    struct RecognizerRequests
+    {
+      RecognizerRequests() : cloud_request_id(0) {}
+
+      uint32_t cloud_request_id;
+      std::vector<uint32_t> image_request_ids;
+    };
+
+    // Continuous perception pipeline, the flags below are set in the spin thread and read
+    // by the job worker and the pipeline stages
+    std::atomic<bool> continuous_mode_;
+    int continuous_queue_size_;
+    typedef BoundedQueue<PerceptionFrame::Ptr> FrameQueue;
+    std::unique_ptr<FrameQueue> input_frames_;
+    std::unique_ptr<FrameQueue> segmented_frames_;
+    std::unique_ptr<FrameQueue> recognized_frames_;
+    std::thread segmentation_thread_;
+    std::thread recognition_thread_;
+    std::thread publish_thread_;
+    // Requests of the frames between the segmentation and the recognition stage, no request
+    // is sent once the pipeline is stopping
+    std::mutex pipeline_requests_mutex_;
+    std::atomic<bool> pipeline_stopping_;
+    std::map<const PerceptionFrame *, RecognizerRequests> pipeline_requests_;
+
+    // Multi-viewpoint accumulation, viewpoints added with e_add_view
+    bool capture_view_;
+    // The job worker claims the accumulated views while it processes a job, no view is
+    // added then and a reset (e_stop) is left to the worker
+    std::mutex views_mutex_;
+    bool views_claimed_;
+    bool reset_views_;
+
+    // Perception jobs, submitted with e_start or on the recognize_objects action
+    typedef actionlib::ActionServer<mir_object_recognition::RecognizeObjectsAction> RecognizeObjectsServer;
+    struct PerceptionJob
+    {
+      PerceptionJob() : id(0), capture_delay(0.0), publish_objects(true), has_goal(false), cancelled(false) {}
+
+      uint32_t id;
+      double capture_delay;
+      bool publish_objects;
+      // objects are stored for the workstation and reused while its scene does not change
+      std::string workstation;
+      // known geometry of the workspace, from the goal or the workspace_priors parameter
+      std::shared_ptr<const SceneSegmentation::WorkspacePrior> workspace_prior;
+      // jobs of the action have a goal, jobs of e_start are answered with e_done
+      bool has_goal;
+      RecognizeObjectsServer::GoalHandle goal;
+      std::atomic<bool> cancelled;
+      // requests the job waits for, only these are canceled with the job
+      std::mutex requests_mutex;
+      RecognizerRequests requests;
+    };
+    typedef std::shared_ptr<PerceptionJob> PerceptionJobPtr;
+    std::unique_ptr<RecognizeObjectsServer> recognize_objects_server_;
+    JobQueue<PerceptionJobPtr> job_queue_;
+    std::thread job_thread_;
+    // action jobs by goal id until they are finished, and the job of the worker
+    std::mutex jobs_mutex_;
+    std::map<std::string, PerceptionJobPtr> goal_jobs_;
+    PerceptionJobPtr running_job_;
+
+    // Frame capture of the job worker, the inputs are (un)subscribed in the spin thread
+    enum CaptureState
+    {
+      CAPTURE_IDLE,
+      CAPTURE_REQUESTED,
+      CAPTURING,
+      CAPTURE_DONE,
+      CAPTURE_CANCELLED
+    };
+    std::mutex capture_mutex_;
+    std::condition_variable capture_cv_;
+    CaptureState capture_state_;
+    bool jobs_closed_;
+    sensor_msgs::ImageConstPtr captured_image_;
+    sensor_msgs::PointCloud2ConstPtr captured_cloud_;
+    sensor_msgs::ImageConstPtr captured_depth_;
+    DepthDeprojector::ConstPtr captured_deprojector_;
+
+    // Latency instrumentation
+    ros::Publisher pub_stage_latency_;
+    diagnostic_updater::Updater diagnostic_updater_;
+    std::mutex latency_mutex_;
+    std::vector<LatencyWindow> stage_latency_windows_;
   
   protected:
-    typedef std::shared_ptr<SceneSegmentationROS> SceneSegmentationROSSPtr;
-    SceneSegmentationROSSPtr scene_segmentation_ros_;
-    typedef std::shared_ptr<MultimodalObjectRecognitionUtils> MultimodalObjectRecognitionUtilsSPtr;
-    MultimodalObjectRecognitionUtilsSPtr mm_object_recognition_utils_;
+    // Segmentation, ROI, pose estimation and fusion, shared with the offline replay tool
+    std::unique_ptr<MultimodalObjectRecognitionPipeline> pipeline_;
+    // Labels of recently recognized 3D clusters, skips the pc recognizer on re-perception
+    RecognitionCache recognition_cache_;
+    // Last object list of every workstation, skips the whole perception if the scene did not change
+    PerceivedObjectStore scene_store_;
+    // Fixed frame of the robot pose of the stored scenes and of the recognition cache
+    std::string scene_store_pose_frame_;
+    // Workspace priors by workstation name, in the target frame
+    std::map<std::string, std::shared_ptr<const SceneSegmentation::WorkspacePrior>> workspace_priors_;
 
     // Used to store pointcloud and image received from callback
     sensor_msgs::PointCloud2ConstPtr pointcloud_msg_;
     sensor_msgs::ImageConstPtr image_msg_;
-    PointCloud::Ptr cloud_;
+    // Used instead of pointcloud_msg_ with a depth input
+    sensor_msgs::ImageConstPtr depth_msg_;
 
     // Flags for pointcloud and image subscription
     int pointcloud_msg_received_count_;
     int image_msg_received_count_;
-    
-    // rgb_object_id used to differentiate 2D and 3D objects
-    int rgb_object_id_;
-    
-    // Flags for object recognition
-    bool received_recognized_image_list_flag_;
-    bool received_recognized_cloud_list_flag_;
-
-    //Recognized image list
-    mas_perception_msgs::ObjectList recognized_image_list_;
-    mas_perception_msgs::ObjectList recognized_cloud_list_;
 
     // Enable recognizer
-    bool enable_rgb_recognizer_;
-    bool enable_pc_recognizer_ ;
+    std::atomic<bool> enable_rgb_recognizer_;
+    std::atomic<bool> enable_pc_recognizer_;
+
+    // Recognizer timeouts in seconds
+    double pc_recognizer_timeout_;
+    double rgb_recognizer_timeout_;
 
     // Visualization
     BoundingBoxVisualizer bounding_box_visualizer_pc_;
@@ -167,32 +326,13 @@ class MultimodalObjectRecognitionROS
     bool debug_mode_;
     std::string target_frame_id_;
     std::string pointcloud_source_frame_id_;
-    std::set<std::string> round_objects_;
-    ObjectInfo object_info_;
     std::string object_info_path_;
 
-    // Dynamic parameter
-    double object_height_above_workspace_;
-    double container_height_;
-    int rgb_roi_adjustment_;
-    int rgb_bbox_min_diag_;
-    int rgb_bbox_max_diag_;
-    double rgb_cluster_filter_limit_min_;
-    double rgb_cluster_filter_limit_max_;
-    bool enable_roi_;
-    double roi_base_link_to_laser_distance_;
-    double roi_max_object_pose_x_to_base_link_;
-    double roi_min_bbox_z_;
-    bool rgb_cluster_remove_outliers_;
-
-    //cluster
-    bool center_cluster_;
-    bool pad_cluster_;
-    unsigned int padded_cluster_size_;
-
      // logdir for saving debug image
     std::string logdir_;
-    bool data_collection_;
+    std::atomic<bool> data_collection_;
+    // Writes the data collection samples in the background
+    std::unique_ptr<DatasetWriter> dataset_writer_;
 
   private:
     /** \brief Event in callback
@@ -203,28 +343,115 @@ class MultimodalObjectRecognitionROS
      * */
     void configCallback(mir_object_recognition::SceneSegmentationConfig &config, uint32_t level);
     
+    /** \brief Create subscribers for the synchronized image and pointcloud topics */
+    void subscribeInputs();
+
+    /** \brief Stop the synchronized image and pointcloud subscribers */
+    void unsubscribeInputs();
+
     /** \brief Transform pointcloud to the given frame id ("base_link" by default)
      * \param[in] PointCloud2 input
+     * \param[out] Transformed pointcloud
+     * \return False if the transform failed
     */
-    void preprocessPointCloud(const sensor_msgs::PointCloud2ConstPtr &cloud_msg);
+    bool preprocessPointCloud(const sensor_msgs::PointCloud2ConstPtr &cloud_msg, PointCloud::Ptr &cloud);
+
+    /** \brief Deproject a depth image to an organized cloud in the target frame, with
+     * depth_cloud_stride pixels per point. The depth is kept for the rgb detections.
+     * \param[in] Depth image
+     * \param[in] Image registered to the depth image, colors the points if it has the same size
+     * \param[in] Rays of the depth camera
+     * \param[out] Strided organized cloud
+     * \param[out] Depth of the view
+     * \return False if the transform failed or the depth does not match the camera info
+     * */
+    bool preprocessDepth(const sensor_msgs::ImageConstPtr &depth_msg, const sensor_msgs::ImageConstPtr &image_msg,
+                         const DepthDeprojector::ConstPtr &deprojector, PointCloud::Ptr &cloud,
+                         std::shared_ptr<const DepthView> &depth_view);
 
-    /** \brief Add cloud accumulation, segment accumulated pointcloud, find the plane, 
-     *     clusters table top objects, find object heights.
-     * \param[out] 3D object list with unknown label
-     * \param[out] Table top pointcloud clusters
+    /** \brief Preprocess the pointcloud or depth input of a frame
+     * \return False if the input could not be transformed
+     * */
+    bool preprocessFrame(PerceptionFrame &frame);
+
+    /** \brief Transform a viewpoint and add it to the accumulated scene
+     * \param[in] PointCloud2 of the viewpoint, null with a depth input
+     * \param[in] Depth image of the viewpoint, null with a pointcloud input
+     * \param[in] Image of the viewpoint
+     * \return False if the pointcloud could not be transformed
      **/
-    void segmentPointCloud(mas_perception_msgs::ObjectList &object_list, 
-                 std::vector<PointCloud::Ptr> &clusters,
-                 std::vector<BoundingBox> boxes);
+    bool addView(const sensor_msgs::PointCloud2ConstPtr &cloud_msg, const sensor_msgs::ImageConstPtr &depth_msg,
+                 const sensor_msgs::ImageConstPtr &image_msg);
+
+    /** \brief Reset the accumulated views, or let the job worker reset them when it releases them */
+    void resetViews();
 
-    /** \brief Recognize 2D and 3D objects, estimate their pose, filter them, and publish the object_list*/
-    void recognizeCloudAndImage();
+    /** \brief Claim the accumulated views for the job worker, or release them after the job */
+    void claimViews(bool claim);
+
+    /** \brief Transform, accumulate and segment the pointcloud of a frame
+     * together with the previously added viewpoints, the pointcloud is only
+     * transformed if the frame has no cloud yet
+     * \param[in,out] Frame
+     * \return False if the pointcloud could not be transformed
+     **/
+    bool segmentFrame(PerceptionFrame &frame);
 
-    /** \brief Adjust object pose, make it flat, adjust container, axis and bolt poses.
-     * \param[in] Object_list.pose, .name,
-     * 
+    /** \brief Reuse the stored objects of the workstation if its scene did not change
+     * \param[in] Job with a workstation
+     * \param[in,out] Frame, the pointcloud is transformed here
+     * \param[out] Signature and robot pose of the frame, to store its objects later
+     * \return True if the stored objects were published for the frame
      **/
-    void adjustObjectPose(mas_perception_msgs::ObjectList &object_list);
+    bool reuseStoredScene(const PerceptionJob &job, PerceptionFrame &frame, PerceivedObjectStore::Entry &entry);
+
+    /** \brief Read the workspace_priors parameter, the height and the flat x, y list of the
+     * polygon of each workstation, e.g. WS01: {height: 0.1, polygon: [0.4, -0.4, 0.9, -0.4, ...]}
+     **/
+    void loadWorkspacePriors();
+
+    /** \brief Planar pose of the robot in the fixed frame at the given time */
+    bool lookupRobotPose(const ros::Time &stamp, PerceivedObjectStore::RobotPose &robot_pose);
+
+    /** \brief Run the in-process rgb detector on an image
+     * \param[in] Image, converted to BGR
+     * \return Detections in the same shape as the replies of the rgb recognizer node
+     **/
+    mas_perception_msgs::ObjectList detectImage(const sensor_msgs::ImageConstPtr &image);
+
+    /** \brief Send the 3D clusters and the image of the frame to the recognizers
+     * \param[in,out] Frame, stores the pending requests
+     **/
+    void requestRecognition(PerceptionFrame &frame);
+
+    /** \brief Correlation ids of the requests sent by requestRecognition for a frame */
+    RecognizerRequests pendingRequests(const PerceptionFrame &frame) const;
+
+    /** \brief Cancel recognizer requests, the waits for their replies return at once */
+    void cancelRequests(const RecognizerRequests &requests);
+
+    /** \brief Wait for the recognizers, find 3D ROI and estimate the pose of 2D objects,
+     *    merge and filter 2D and 3D objects into frame.combined_object_list */
+    void recognizeCloudAndImage(PerceptionFrame &frame);
+
+    /** \brief Draw the rgb detections of the frame on the debug image, only the detections
+     * of the current view are drawn */
+    void drawDetections(PerceptionFrame &frame);
+
+    /** \brief Adjust, publish the combined object list and publish debug info
+     * \param[in,out] Frame
+     * \param[in] Publish the object list on output/object_list, it is prepared in any case
+     **/
+    void publishFrame(PerceptionFrame &frame, bool publish_objects = true);
+
+    /** \brief Queue the clusters and the raw image of the frame for the dataset writer
+     * (data collection mode) */
+    void saveFrame(PerceptionFrame &frame);
+
+    /** \brief Drop the clouds of the objects and rename containers to the refbox names
+     * \param[in,out] Object list
+     **/
+    void prepareObjectList(mas_perception_msgs::ObjectList &object_list);
 
     /** \brief Publish object_list to object_list merger 
      * \param[in] Object list to publish
@@ -232,18 +459,71 @@ class MultimodalObjectRecognitionROS
     void publishObjectList(mas_perception_msgs::ObjectList &object_list);
 
     /** \brief Publish debug info such as bbox, poses, labels for both 2D and 3D objects.
-     * \param[in] combined object list
-     * \param[in] 3D pointcloud cluster from 3D object segmentation
-     * \param[in] 3D pointcloud cluster from 2D bounding box proposal
+     * \param[in] Frame with the combined object list, 3D pointcloud cluster from 3D object
+     *     segmentation and 3D pointcloud cluster from 2D bounding box proposal
+     **/
+    void publishDebug(PerceptionFrame &frame);
+
+    /** \brief Publish the stage latencies of a frame and add them to the rolling windows */
+    void recordLatency(PerceptionFrame &frame);
+
+    /** \brief Diagnostics task reporting p50/p95/p99 latency of each stage */
+    void latencyDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
+    /** \brief Start the continuous perception pipeline threads */
+    void startPipeline();
+
+    /** \brief Stop and join the continuous perception pipeline threads */
+    void stopPipeline();
+
+    /** \brief Pipeline stages, each runs in its own thread in continuous mode */
+    void segmentationStage();
+    void recognitionStage();
+    void publishStage();
+
+    /** \brief Queue a perception job
+     * \return Job id, 0 if the node is shutting down
      **/
-    void publishDebug(mas_perception_msgs::ObjectList &combined_object_list,
-              std::vector<PointCloud::Ptr> &clusters_3d,
-              std::vector<PointCloud::Ptr> &clusters_2d);
-
-    /** \brief Load qualitative object info
-     * \param[in] Path to the xml object file
-     * */ 
-    void loadObjectInfo(const std::string &filename);        
+    uint32_t submitJob(const PerceptionJobPtr &job, int priority);
+
+    /** \brief True if a perception job is queued or running */
+    bool jobsPending();
+
+    /** \brief Action callbacks, queue a job for a new goal and cancel the job of a goal */
+    void goalCallback(RecognizeObjectsServer::GoalHandle goal);
+    void cancelCallback(RecognizeObjectsServer::GoalHandle goal);
+
+    /** \brief Stop a job which was already taken by the worker, it finishes as canceled */
+    void cancelRunningJob(PerceptionJob &job);
+
+    /** \brief Cancel all queued jobs and the running one */
+    void cancelAllJobs();
+
+    /** \brief Job worker thread, captures and processes one job at a time */
+    void jobStage();
+
+    /** \brief Wait for the selected frame of the job, subscribing is left to the spin thread
+     * \param[out] Frame with the captured inputs
+     * \return False if the job was canceled before a frame was captured
+     **/
+    bool captureFrame(const PerceptionJob &job, PerceptionFrame &frame);
+
+    /** \brief Segment, recognize and publish the captured frame of a job, or publish
+     * the stored objects of its workstation
+     * \param[out] True if the stored objects were published
+     * \return False if the job was canceled
+     **/
+    bool processJob(PerceptionJob &job, PerceptionFrame &frame, bool &from_store);
+
+    /** \brief Report the result of a job, e_done for the jobs of e_start */
+    void finishJob(PerceptionJob &job, PerceptionFrame &frame, bool done, bool from_store);
+
+    /** \brief Publish the state of an action job as feedback */
+    void publishJobFeedback(PerceptionJob &job, const std::string &state);
+
+    /** \brief Subscribe or unsubscribe the inputs for the frame capture of the job worker,
+     * called from update() */
+    void updateCapture();
 };
 
 #endif  // MIR_OBJECT_RECOGNITION_MULTIMODAL_OBJECT_RECOGNITION_ROS_H
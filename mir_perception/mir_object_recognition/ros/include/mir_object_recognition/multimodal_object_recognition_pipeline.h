@@ -0,0 +1,160 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_MULTIMODAL_OBJECT_RECOGNITION_PIPELINE_H
+#define MIR_OBJECT_RECOGNITION_MULTIMODAL_OBJECT_RECOGNITION_PIPELINE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mas_perception_msgs/ObjectList.h>
+
+#include <mir_object_recognition/SceneSegmentationConfig.h>
+#include <mir_object_recognition/container_rim_estimator.h>
+#include <mir_object_recognition/multimodal_object_recognition_utils.h>
+#include <mir_object_recognition/object_fusion.h>
+#include <mir_object_recognition/perception_frame.h>
+#include <mir_object_catalogue/object_catalogue.h>
+#include <mir_object_segmentation/scene_segmentation_ros.h>
+#include <mir_perception_utils/thread_pool.h>
+
+/** \brief Segmentation -> ROI -> pose -> adjust chain of the multimodal object recognition,
+ * without any ROS communication, so that it can be driven by the ROS node as well as by
+ * offline tools (e.g. multimodal_replay) without a ROS master.
+ *
+ * Input clouds must already be transformed to the target frame. The recognizer replies
+ * are provided by the caller in the frame (recognized_cloud_list, recognized_image_list).
+ * All methods are thread safe, the scene segmentation is shared between frames and guarded
+ * by a mutex.
+ */
+class MultimodalObjectRecognitionPipeline
+{
+  public:
+    /** \brief Constructor
+     * \param[in] Number of workers for the rgb detections, 0 uses all hardware threads
+     * */
+    explicit MultimodalObjectRecognitionPipeline(unsigned int num_workers = 0);
+    virtual ~MultimodalObjectRecognitionPipeline();
+
+    /** \brief Apply the scene segmentation and object recognition parameters */
+    void configure(const mir_object_recognition::SceneSegmentationConfig &config);
+
+    /** \brief Load the object catalogue, decides e.g. which objects get a flat yaw, which
+     * are containers and which long objects get their pose adjusted
+     * \param[in] Path to the xml object file
+     * \return False if the file does not exist or cannot be parsed
+     * */
+    bool loadObjectInfo(const std::string &filename);
+
+    /** \brief Current object catalogue, never null */
+    std::shared_ptr<const ObjectCatalogue> getObjectCatalogue();
+
+    /** \brief Add a viewpoint to the accumulated scene, it is fused with the next segmented frame
+     * \param[in] View, its cloud must be in the target frame
+     * \return Number of accumulated viewpoints
+     * */
+    size_t addView(PerceptionView &view);
+
+    /** \brief Drop the accumulated viewpoints and clouds */
+    void resetViews();
+
+    /** \brief Number of accumulated viewpoints */
+    size_t numViews();
+
+    /** \brief Fuse the accumulated viewpoints with the view of the frame, find the plane and
+     * the table top clusters.
+     * The plane is searched in the workspace prior of the frame first, if it has one.
+     * \param[in,out] Frame with cloud and image_msg, fills views, cloud_object_list, clusters_3d,
+     *     boxes, workspace_height, plane_normal and workspace_hull
+     * \param[out] Debug cloud of the plane
+     * */
+    void segment(PerceptionFrame &frame, PointCloud::Ptr &cloud_debug);
+
+    /** \brief Crop the images of the views to the segmented workspace and downscale them
+     * for the rgb recognizer, if enabled
+     * \param[in,out] Segmented frame, fills request_image and image_crop of the views
+     * */
+    void cropRGBRequests(PerceptionFrame &frame);
+
+    /** \brief Find the 3D ROI and estimate the pose of all rgb detections of the frame,
+     * containers are placed at the center of their floor
+     * \param[in,out] Frame with recognized_image_list and image_detection_views, fills
+     *     rgb_object_list, clusters_2d and filtered_rgb_clouds
+     * */
+    void processRGBDetections(PerceptionFrame &frame);
+
+    /** \brief Fuse recognized 3D and rgb objects into frame.combined_object_list and
+     * mark objects outside of the region of interest as DECOY
+     * \return Number of fused objects
+     * */
+    int fuseObjects(PerceptionFrame &frame);
+
+    /** \brief Adjust object pose, make it flat, adjust container height, axis and bolt poses.
+     * \param[in,out] Object list
+     * \param[in] Workspace height of the frame
+     * */
+    void adjustObjectPose(mas_perception_msgs::ObjectList &object_list, double workspace_height);
+
+  private:
+    /** \brief Parameters of the chain, copied per call so that reconfiguring does not
+     * affect a frame which is being processed */
+    struct Params
+    {
+      Params();
+
+      bool center_cluster;
+      bool pad_cluster;
+      unsigned int padded_cluster_size;
+      double object_height_above_workspace;
+      double container_height;
+      ContainerRimEstimator::Params container;
+      int rgb_roi_adjustment;
+      int rgb_bbox_min_diag;
+      int rgb_bbox_max_diag;
+      double rgb_cluster_filter_limit_min;
+      double rgb_cluster_filter_limit_max;
+      bool rgb_cluster_remove_outliers;
+      bool enable_roi;
+      double roi_base_link_to_laser_distance;
+      double roi_max_object_pose_x_to_base_link;
+      double roi_min_bbox_z;
+      double object_fusion_radius;
+      bool enable_workspace_prior;
+      double workspace_prior_height_tolerance;
+      int workspace_prior_min_points;
+      WorkspaceImageCrop::Params rgb_crop;
+      // shared, so that copying the params does not copy the catalogue
+      std::shared_ptr<const ObjectCatalogue> catalogue;
+    };
+
+    Params getParams();
+
+    void processRGBDetection(const Params &params, const PerceptionView &view,
+                             const mas_perception_msgs::Object &object, const ObjectInfo &info,
+                             int database_id,
+                             mas_perception_msgs::Object &rgb_object, PointCloud::Ptr &cloud_roi,
+                             PointCloud::Ptr &filtered_cloud);
+
+    /** \brief Deproject the roi of a detection from the depth of a view, the roi is
+     * adjusted and its outliers removed as in mpu::pointcloud::getPointCloudROI
+     * */
+    bool getDepthROI(const Params &params, const PerceptionView &view,
+                     const sensor_msgs::RegionOfInterest &roi, PointCloud::Ptr &cloud_roi);
+
+    // rgb_object_id used to differentiate 2D and 3D objects
+    static const int RGB_OBJECT_ID = 100;
+
+    std::mutex segmentation_mutex_;
+    std::unique_ptr<SceneSegmentationROS> scene_segmentation_ros_;
+    std::vector<PerceptionView> accumulated_views_;
+
+    std::mutex params_mutex_;
+    Params params_;
+
+    MultimodalObjectRecognitionUtils mm_object_recognition_utils_;
+    std::unique_ptr<mir_perception_utils::ThreadPool> detection_pool_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_MULTIMODAL_OBJECT_RECOGNITION_PIPELINE_H
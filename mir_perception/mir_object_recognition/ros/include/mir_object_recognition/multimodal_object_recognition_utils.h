@@ -14,6 +14,7 @@
 
 #include <ros/ros.h>
 
+#include <mir_object_catalogue/object_catalogue.h>
 #include <mir_perception_utils/aliases.h>
 #include <mas_perception_msgs/Object.h>
 
@@ -29,11 +30,11 @@ class MultimodalObjectRecognitionUtils
     /** \brief Make adjustment for AXIS and Bolt (M20_100) pose. Adjust it so that the pose
      *     is around to the center of mass (the tip).
      * \param[in] object
-     * 
+     * \param[in] adjustment of the object, see its catalogue entry
     */
-    void adjustAxisBoltPose(mas_perception_msgs::Object &object);
+    void adjustAxisBoltPose(mas_perception_msgs::Object &object, PoseAdjustment adjustment);
 
-    /** \brief Adjust container pose by finding the largest cluster to find the center
+    /** \brief Adjust container pose to the center of its floor, see ContainerRimEstimator
      * \param[in] object.views[0].point_cloud
      * \param[in] the height adjustment of the container, default 10cm
     */
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_OBJECT_FUSION_H
+#define MIR_OBJECT_RECOGNITION_OBJECT_FUSION_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <mas_perception_msgs/Object.h>
+#include <mas_perception_msgs/ObjectList.h>
+
+/** \brief Fuses the objects of the pointcloud and the rgb recognizer, which often
+ * report the same physical object twice (with database ids below and above 100).
+ *
+ * The 3D objects are inserted into a spatial hash over the xy plane of their pose,
+ * with a cell size equal to the association radius. Each rgb object is associated
+ * to the closest unassociated 3D object within the radius (3D distance), looking only
+ * at the 3x3 neighbouring cells, so fusion is linear in the number of objects.
+ *
+ * An associated pair becomes one object. The label with the higher probability wins, and
+ * the object providing it is kept (pose, cloud, dimensions, database id). If both
+ * recognizers agree on the label, the probabilities are merged as independent evidence
+ * (1 - (1 - p1)(1 - p2)). If they disagree, the pair is still reported as one object
+ * with the more probable label and its unchanged probability, since two objects at the
+ * same position cannot both be grasped. DECOY objects are passed through without
+ * association.
+ */
+class ObjectFusion
+{
+  public:
+    /** \brief Constructor
+     * \param[in] Association radius in meters
+     * */
+    explicit ObjectFusion(double radius = 0.03);
+
+    void setRadius(double radius);
+
+    /** \brief Fuse 3D and rgb objects
+     * \param[in] Objects of the pointcloud recognizer
+     * \param[in] Objects of the rgb recognizer
+     * \param[out] One object per physical item, unassociated objects are kept
+     * \return Number of fused pairs
+     * */
+    int fuse(const mas_perception_msgs::ObjectList &cloud_objects,
+             const mas_perception_msgs::ObjectList &rgb_objects,
+             mas_perception_msgs::ObjectList &fused_objects);
+
+  private:
+    int64_t cellKey(int64_t cx, int64_t cy) const;
+    int64_t cellIndex(double value) const;
+
+    double radius_;
+    std::unordered_map<int64_t, std::vector<size_t>> grid_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_OBJECT_FUSION_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_ONNX_DETECTOR_H
+#define MIR_OBJECT_RECOGNITION_ONNX_DETECTOR_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/dnn.hpp>
+
+#include <mas_perception_msgs/ObjectList.h>
+#include <std_msgs/Header.h>
+
+/** \brief In-process rgb object detector, runs an exported ONNX detection model with
+ * OpenCV DNN on the CPU instead of sending the image to the rgb recognizer node.
+ *
+ * The image is letterboxed to the input size of the model. Two output layouts are
+ * decoded: [1, N, 5 + C] with box (cx, cy, w, h), objectness and class scores
+ * (YOLOv5), and the transposed [1, 4 + C, N] without objectness (YOLOv8). The score
+ * of a box is the best class score, times the objectness if there is one. Boxes
+ * below the confidence threshold are dropped, the others are suppressed per class
+ * with the NMS threshold. The detections have the same shape as the replies of the
+ * rgb recognizer node: upper case class name, probability and roi in the pixels of
+ * the given image. Thread safe, the inferences are serialized.
+ */
+class OnnxDetector
+{
+  public:
+    struct Params
+    {
+      Params();
+
+      std::string model_path;
+      int input_width;
+      int input_height;
+      double confidence_threshold;
+      double nms_threshold;
+      int num_threads;  // OpenCV threads for the inference, 0 keeps the OpenCV default
+      // class names by class id, ids without a name are named CLASS_<id>
+      std::vector<std::string> class_names;
+    };
+
+    /** \brief Placement of the image in the letterboxed input of the model */
+    struct Letterbox
+    {
+      double scale;
+      int pad_x;
+      int pad_y;
+      cv::Size scaled_size;
+    };
+
+    /** \brief Box of a class in the pixels of the image */
+    struct Detection
+    {
+      int class_id;
+      float score;
+      cv::Rect box;
+    };
+
+    OnnxDetector();
+
+    /** \brief Load the model
+     * \return False if the model cannot be read
+     * */
+    bool load(const Params &params);
+
+    bool isLoaded() const { return loaded_; }
+
+    /** \brief Detect the objects in an image
+     * \param[in] BGR image
+     * \param[in] Header of the image, copied to the poses of the detections
+     * \param[out] Detections with name, probability and roi
+     * \return False if the model is not loaded or the inference failed
+     * */
+    bool detect(const cv::Mat &image, const std_msgs::Header &header,
+                mas_perception_msgs::ObjectList &detections);
+
+    /** \brief Read class names, one per line in class id order, empty lines and lines
+     * starting with # are skipped
+     * */
+    static bool loadClassNames(const std::string &filename, std::vector<std::string> &class_names);
+
+    /** \brief Scale the image to fit the input of the model, keeping its aspect ratio, and
+     * center it
+     * */
+    static Letterbox letterbox(const cv::Size &image_size, const cv::Size &input_size);
+
+    /** \brief Decode the output of the model and suppress the overlapping boxes per class
+     * \param[in] Output of the model, [1, N, 5 + C] or [1, 4 + C, N]
+     * \param[in] Letterbox of the input
+     * \param[in] Size of the image, the boxes are clipped to it
+     * \param[in] Confidence threshold
+     * \param[in] NMS threshold
+     * \param[out] Detections ordered by score
+     * \return False if the output has an unexpected shape
+     * */
+    static bool decode(const cv::Mat &output, const Letterbox &letterbox, const cv::Size &image_size,
+                       float confidence_threshold, float nms_threshold,
+                       std::vector<Detection> &detections);
+
+  private:
+    std::string className(int class_id) const;
+
+    std::mutex mutex_;
+    Params params_;
+    cv::dnn::Net net_;
+    bool loaded_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_ONNX_DETECTOR_H
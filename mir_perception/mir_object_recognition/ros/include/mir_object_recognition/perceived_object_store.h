@@ -0,0 +1,137 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_PERCEIVED_OBJECT_STORE_H
+#define MIR_OBJECT_RECOGNITION_PERCEIVED_OBJECT_STORE_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mas_perception_msgs/ObjectList.h>
+
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Coarse description of a scene, compared to decide whether a workstation changed */
+struct SceneSignature
+{
+  SceneSignature();
+
+  // Mean height of the points of each block of pixels of the organized cloud, NaN if the
+  // block has too few valid points. Empty for unorganized clouds.
+  int rows;
+  int cols;
+  std::vector<float> heights;
+  // Order independent hash of the occupied cells of the block centroids
+  uint64_t occupancy_hash;
+};
+
+/** \brief Keeps the last fused object list of every workstation, so that perceiving a
+ * workstation again (e.g. after a failed grasp elsewhere) can skip segmentation and
+ * recognition if nothing was manipulated there since.
+ *
+ * An entry is still valid for a new frame if it is younger than the max age, the robot
+ * pose of both frames is known and within the translation and rotation tolerance, and
+ * either the occupancy hashes are equal or at most max_changed_ratio of the blocks differ:
+ * a block differs if it is valid in only one of the signatures or its height changed by
+ * more than the depth tolerance. Both signatures have to be computed from clouds of the
+ * same size in the target frame. The objects are stored in the fixed frame of the robot
+ * poses, so that they can be moved to the robot pose of the frame they are reused in.
+ * Thread safe.
+ */
+class PerceivedObjectStore
+{
+  public:
+    struct Params
+    {
+      Params();
+
+      bool enable;
+      double max_age;              // seconds
+      int block_size;              // pixels of the organized cloud per block side
+      double depth_tolerance;      // max height difference of a block, meters
+      double max_changed_ratio;    // max fraction of changed blocks
+      double occupancy_cell_size;  // cell size of the occupancy hash, meters
+      double max_translation;      // max distance between the robot poses, meters
+      double max_rotation;         // max yaw difference between the robot poses, radians
+      size_t max_entries;
+    };
+
+    /** \brief Planar robot pose in the fixed frame */
+    struct RobotPose
+    {
+      RobotPose() : valid(false), x(0.0), y(0.0), yaw(0.0) {}
+
+      bool valid;
+      double x;
+      double y;
+      double yaw;
+    };
+
+    struct Entry
+    {
+      Entry() : stamp(0.0), workspace_height(0.0) {}
+
+      double stamp;  // seconds, stamp of the frame the objects were perceived in
+      RobotPose robot_pose;
+      SceneSignature signature;
+      mas_perception_msgs::ObjectList object_list;  // poses in the fixed frame
+      double workspace_height;
+    };
+
+    PerceivedObjectStore();
+
+    void setParams(const Params &params);
+
+    /** \brief Compute the signature of a frame, a single pass over the cloud
+     * \param[in] Organized cloud in the target frame
+     * */
+    SceneSignature computeSignature(const PointCloud &cloud) const;
+
+    /** \brief Find the entry of a workstation which is still valid for the current frame
+     * \param[in] Workstation name
+     * \param[in] Signature of the current frame
+     * \param[in] Robot pose of the current frame
+     * \param[in] Stamp of the current frame in seconds
+     * \param[out] Stored entry
+     * \param[out] Fraction of changed blocks, 1 if the entry is not compared
+     * \return False if there is no valid entry or the store is disabled
+     * */
+    bool lookup(const std::string &workstation, const SceneSignature &signature,
+                const RobotPose &robot_pose, double stamp, Entry &entry, double &changed_ratio);
+
+    /** \brief Store the objects of a workstation, replaces its previous entry */
+    void insert(const std::string &workstation, const Entry &entry);
+
+    /** \brief Drop the entry of a workstation, e.g. after objects were placed there */
+    void erase(const std::string &workstation);
+
+    /** \brief Drop all entries */
+    void clear();
+
+    size_t size();
+
+    /** \brief Move the object poses from the robot frame at a robot pose to the fixed frame
+     * \param[in] Robot pose the objects were perceived at
+     * \param[in/out] Objects, the height and the frame id are kept
+     * */
+    static void toFixedFrame(const RobotPose &robot_pose, mas_perception_msgs::ObjectList &object_list);
+
+    /** \brief Move the object poses from the fixed frame to the robot frame at a robot pose
+     * \param[in] Current robot pose
+     * \param[in/out] Objects, the height and the frame id are kept
+     * */
+    static void toRobotFrame(const RobotPose &robot_pose, mas_perception_msgs::ObjectList &object_list);
+
+  private:
+    /** \brief Fraction of the blocks which differ, 1 if the signatures do not match in size */
+    double changedRatio(const SceneSignature &a, const SceneSignature &b) const;
+
+    mutable std::mutex mutex_;
+    Params params_;
+    std::map<std::string, Entry> entries_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_PERCEIVED_OBJECT_STORE_H
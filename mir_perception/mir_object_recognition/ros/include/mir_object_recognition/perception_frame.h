@@ -0,0 +1,129 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_PERCEPTION_FRAME_H
+#define MIR_OBJECT_RECOGNITION_PERCEPTION_FRAME_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <cv_bridge/cv_bridge.h>
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <mas_perception_msgs/ObjectList.h>
+
+#include <mir_object_segmentation/scene_segmentation.h>
+#include <mir_perception_utils/aliases.h>
+#include <mir_perception_utils/bounding_box.h>
+
+#include <mir_object_recognition/depth_deprojector.h>
+#include <mir_object_recognition/recognition_cache.h>
+#include <mir_object_recognition/stage_latency.h>
+#include <mir_object_recognition/workspace_image_crop.h>
+
+/** \brief One camera viewpoint of a (possibly multi-view) frame. The point cloud is
+ * organized and transformed to the target frame, so RGB detections in the image of this
+ * view can be projected back into it. Views from a depth image keep the depth, their
+ * cloud is strided and the RGB detections are deprojected from the depth instead.
+ */
+struct PerceptionView
+{
+  PerceptionView() : image_request_id(0), image_in_process(false) {}
+
+  sensor_msgs::ImageConstPtr image_msg;
+  PointCloud::Ptr cloud;
+  std::shared_ptr<const DepthView> depth;
+
+  // Image sent to the rgb recognizer if it is cropped or downscaled, null to send
+  // image_msg, the detections are mapped back to image_msg with image_crop
+  sensor_msgs::ImagePtr request_image;
+  ImageCrop image_crop;
+
+  // Pending rgb recognizer request, an id of 0 means no request was sent. Images detected
+  // by the in-process detector have no id, their reply is the result of the detection task.
+  uint32_t image_request_id;
+  bool image_in_process;
+  std::future<mas_perception_msgs::ObjectList> image_reply;
+};
+
+/** \brief Everything the multimodal pipeline produces for one synchronized image and
+ * point cloud pair. Each stage reads the outputs of the previous stages from the frame,
+ * so that several frames can be in flight at the same time.
+ */
+struct PerceptionFrame
+{
+  typedef std::shared_ptr<PerceptionFrame> Ptr;
+  typedef std::chrono::steady_clock Clock;
+
+  PerceptionFrame()
+      : workspace_height(-1000.0),
+        plane_normal(Eigen::Vector3f::UnitZ()),
+        cloud_request_id(0)
+  {
+    std::fill(stage_latency, stage_latency + NUM_PERCEPTION_STAGES, -1.0);
+  }
+
+  // Input
+  sensor_msgs::ImageConstPtr image_msg;
+  sensor_msgs::PointCloud2ConstPtr pointcloud_msg;
+  // Depth input instead of pointcloud_msg, with the rays of its camera
+  sensor_msgs::ImageConstPtr depth_msg;
+  DepthDeprojector::ConstPtr deprojector;
+  ros::Time stamp;
+
+  // Point cloud transformed to the target frame
+  PointCloud::Ptr cloud;
+  std::shared_ptr<const DepthView> depth_view;
+  // Known geometry of the workspace in the target frame, optional
+  std::shared_ptr<const SceneSegmentation::WorkspacePrior> workspace_prior;
+
+  // All viewpoints fused into this frame, the last one is the view of the input above
+  std::vector<PerceptionView> views;
+
+  // Segmentation
+  mas_perception_msgs::ObjectList cloud_object_list;
+  std::vector<PointCloud::Ptr> clusters_3d;
+  std::vector<mir_perception_utils::object::BoundingBox> boxes;
+  double workspace_height;
+  Eigen::Vector3f plane_normal;
+  PointCloud::Ptr workspace_hull;
+
+  // Pending pc recognizer request, an id of 0 means no request was sent
+  Clock::time_point request_time;
+  uint32_t cloud_request_id;
+  std::future<mas_perception_msgs::ObjectList> cloud_reply;
+  // Recognition cache, fingerprint and label of every 3D cluster, clusters without a
+  // cached label are sent to the pc recognizer in the order of cloud_request_indices
+  std::vector<ClusterFingerprint> cloud_fingerprints;
+  std::vector<bool> cloud_labelled;
+  std::vector<size_t> cloud_request_indices;
+
+  // Recognition
+  mas_perception_msgs::ObjectList recognized_cloud_list;
+  mas_perception_msgs::ObjectList recognized_image_list;
+  // Index into views of the image each rgb detection was found in
+  std::vector<size_t> image_detection_views;
+  mas_perception_msgs::ObjectList rgb_object_list;
+  std::vector<PointCloud::Ptr> clusters_2d;
+  // Pose estimation input of each rgb detection, null for DECOY objects
+  std::vector<PointCloud::Ptr> filtered_rgb_clouds;
+  cv_bridge::CvImagePtr debug_image;
+
+  // Output
+  mas_perception_msgs::ObjectList combined_object_list;
+
+  // Latency of each stage in seconds, -1 if the stage did not run. The timer runs
+  // from the creation of the frame, its elapsed time is the total latency.
+  StageTimer timer;
+  double stage_latency[NUM_PERCEPTION_STAGES];
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_PERCEPTION_FRAME_H
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_RECOGNITION_CACHE_H
+#define MIR_OBJECT_RECOGNITION_RECOGNITION_CACHE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <Eigen/Dense>
+
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Compact geometric and colour description of a 3D cluster */
+struct ClusterFingerprint
+{
+  static const int BINS_PER_CHANNEL = 4;
+  static const int HISTOGRAM_SIZE = BINS_PER_CHANNEL * BINS_PER_CHANNEL * BINS_PER_CHANNEL;
+
+  ClusterFingerprint();
+
+  /** \brief Compute the fingerprint of a cluster
+   * \param[in] Cluster in the target frame
+   * */
+  explicit ClusterFingerprint(const PointCloud &cluster);
+
+  /** \brief Move the centroid to another frame, e.g. a fixed frame, the extent stays in the
+   * axes of the frame of the cluster */
+  void transform(const Eigen::Affine3f &transform);
+
+  Eigen::Vector3f centroid;
+  Eigen::Vector3f extent;
+  size_t num_points;
+  // Normalized joint RGB histogram
+  std::array<float, HISTOGRAM_SIZE> histogram;
+};
+
+/** \brief Caches the labels of the pointcloud recognizer by cluster fingerprint, so that
+ * clusters which were recognized recently (e.g. when perceiving the same workstation again
+ * after a failed grasp) are labelled without another inference round.
+ *
+ * A cluster matches an entry if the centroids are within the centroid tolerance, the
+ * extents differ by less than the extent tolerance on every axis, the point counts differ
+ * by less than the relative point count tolerance and the colour histograms are closer
+ * than the histogram distance (half the L1 distance, in [0, 1]). Entries are hashed by the
+ * quantized centroid, so only the neighbouring cells are compared. Entries older than the
+ * max age are ignored and evicted, the oldest entry is evicted if the cache is full.
+ * The centroids should be in a fixed frame, otherwise a different object at the same place
+ * relative to the robot is taken for a cached one. Empty labels are not cached.
+ * Thread safe.
+ */
+class RecognitionCache
+{
+  public:
+    struct Params
+    {
+      Params();
+
+      bool enable;
+      double max_age;                  // seconds
+      double centroid_tolerance;       // meters, also the cell size of the hash
+      double extent_tolerance;         // meters
+      double point_count_tolerance;    // relative to the cached point count
+      double max_histogram_distance;
+      size_t max_entries;
+    };
+
+    struct Label
+    {
+      std::string name;
+      double probability;
+    };
+
+    RecognitionCache();
+
+    void setParams(const Params &params);
+
+    bool isEnabled();
+
+    /** \brief Find a fresh entry matching the fingerprint
+     * \param[in] Fingerprint of the cluster
+     * \param[out] Cached label
+     * \return False if there is no match or the cache is disabled
+     * */
+    bool lookup(const ClusterFingerprint &fingerprint, Label &label);
+
+    /** \brief Add a recognized cluster, replaces a matching entry, empty labels are ignored */
+    void insert(const ClusterFingerprint &fingerprint, const Label &label);
+
+    /** \brief Drop all entries */
+    void clear();
+
+    size_t size();
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+      ClusterFingerprint fingerprint;
+      Label label;
+      Clock::time_point time;
+      int64_t key;
+    };
+    typedef std::list<Entry>::iterator EntryIt;
+
+    int64_t cellKey(int64_t cx, int64_t cy, int64_t cz) const;
+    int64_t cellIndex(double value) const;
+    bool matches(const ClusterFingerprint &a, const ClusterFingerprint &b) const;
+    /** \brief Closest fresh entry matching the fingerprint, entries_.end() if none */
+    EntryIt find(const ClusterFingerprint &fingerprint, const Clock::time_point &now);
+    void erase(EntryIt entry);
+    void evictExpired(const Clock::time_point &now);
+
+    std::mutex mutex_;
+    Params params_;
+    // Entries from oldest to newest
+    std::list<Entry> entries_;
+    std::unordered_multimap<int64_t, EntryIt> grid_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_RECOGNITION_CACHE_H
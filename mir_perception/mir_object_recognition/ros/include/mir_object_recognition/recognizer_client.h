@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_RECOGNIZER_CLIENT_H
+#define MIR_OBJECT_RECOGNITION_RECOGNIZER_CLIENT_H
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+
+#include <mas_perception_msgs/ImageList.h>
+#include <mas_perception_msgs/ObjectList.h>
+
+/** \brief Asynchronous request layer for the external (pc and rgb) recognizer nodes.
+ *
+ * Every request is tagged with a correlation id which is written into the nested header
+ * seq of the request (object pose headers for clouds, image headers for images). The
+ * recognizers echo these headers back, so each reply can be matched to the request it
+ * answers. Replies are handled on the given callback queue, which should be serviced
+ * by its own spinner so that waiting on a reply does not block the node's spin thread.
+ *
+ * Replies without a correlation id (an empty object list has no nested header) are
+ * assigned to the oldest pending request, a recognizer answers its requests in order.
+ * Replies to requests that already timed out are dropped.
+ */
+template <typename RequestT>
+class RecognizerClient
+{
+ public:
+  typedef mas_perception_msgs::ObjectList Reply;
+  typedef std::chrono::steady_clock Clock;
+
+  /** \brief Constructor
+   * \param[in] NodeHandle used to advertise and subscribe
+   * \param[in] Topic the request is published to
+   * \param[in] Topic the recognizer publishes its reply to
+   * \param[in] Callback queue on which the replies are handled
+   * */
+  RecognizerClient(const ros::NodeHandle &nh, const std::string &request_topic,
+                   const std::string &reply_topic, ros::CallbackQueue *callback_queue);
+
+  /** \brief Tag and publish a request
+   * \param[in] Request message, its correlation id is set in place
+   * \param[out] Future which is fulfilled when the reply arrives
+   * \return Correlation id of the request
+   * */
+  uint32_t request(RequestT &msg, std::future<Reply> &reply);
+
+  /** \brief Wait for the reply of a request until the deadline
+   * \param[in] Correlation id returned by request()
+   * \param[in] Future returned by request()
+   * \param[in] Deadline
+   * \param[out] Reply
+   * \return True if the reply arrived before the deadline, otherwise the request is
+   * cancelled and false is returned
+   * */
+  bool waitForReply(uint32_t id, std::future<Reply> &future, const Clock::time_point &deadline,
+                    Reply &reply);
+
+  /** \brief Drop a pending request, a late reply to it will be ignored */
+  void cancel(uint32_t id);
+
+  /** \brief Drop all pending requests */
+  void cancelAll();
+
+ private:
+  void replyCallback(const Reply::ConstPtr &msg);
+
+  ros::NodeHandle nh_;
+  ros::Publisher pub_request_;
+  ros::Subscriber sub_reply_;
+
+  std::mutex mutex_;
+  std::map<uint32_t, std::promise<Reply>> pending_;
+  uint32_t next_id_;
+};
+
+typedef RecognizerClient<mas_perception_msgs::ObjectList> CloudRecognizerClient;
+typedef RecognizerClient<mas_perception_msgs::ImageList> ImageRecognizerClient;
+
+#include "impl/recognizer_client.hpp"
+
+#endif  // MIR_OBJECT_RECOGNITION_RECOGNIZER_CLIENT_H
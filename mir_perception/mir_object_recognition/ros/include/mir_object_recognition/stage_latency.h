@@ -0,0 +1,109 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_STAGE_LATENCY_H
+#define MIR_OBJECT_RECOGNITION_STAGE_LATENCY_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/** \brief Stages of the multimodal perception pipeline whose latency is measured */
+enum PerceptionStage
+{
+  STAGE_TRANSFORM = 0,
+  STAGE_ACCUMULATION,
+  STAGE_SEGMENTATION,
+  STAGE_RGB_RECOGNIZER_WAIT,
+  STAGE_ROI_POSE,
+  STAGE_PC_RECOGNIZER_WAIT,
+  STAGE_ADJUST_POSE,
+  STAGE_PUBLISH,
+  STAGE_TOTAL,
+  NUM_PERCEPTION_STAGES
+};
+
+inline const char *perceptionStageName(int stage)
+{
+  static const char *names[NUM_PERCEPTION_STAGES] = {
+    "transform", "accumulation", "segmentation", "rgb_recognizer_wait", "roi_pose",
+    "pc_recognizer_wait", "adjust_pose", "publish", "total"
+  };
+  return (stage >= 0 && stage < NUM_PERCEPTION_STAGES) ? names[stage] : "unknown";
+}
+
+/** \brief Measures elapsed time with a monotonic clock, unaffected by sim time or
+ * wall clock jumps.
+ */
+class StageTimer
+{
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    StageTimer() : start_(Clock::now()) {}
+
+    void restart() { start_ = Clock::now(); }
+
+    /** \brief Elapsed time since construction or the last restart in seconds */
+    double elapsed() const
+    {
+      return std::chrono::duration<double>(Clock::now() - start_).count();
+    }
+
+  private:
+    Clock::time_point start_;
+};
+
+/** \brief Rolling window of latency samples with percentile queries.
+ * Not thread safe.
+ */
+class LatencyWindow
+{
+  public:
+    explicit LatencyWindow(size_t window_size = 200)
+      : window_size_(std::max<size_t>(1, window_size)), next_(0), count_(0)
+    {
+      samples_.reserve(window_size_);
+    }
+
+    void add(double sample)
+    {
+      if (samples_.size() < window_size_)
+      {
+        samples_.push_back(sample);
+      }
+      else
+      {
+        samples_[next_] = sample;
+      }
+      next_ = (next_ + 1) % window_size_;
+      count_++;
+    }
+
+    /** \brief Nearest rank percentile of the samples in the window
+     * \param[in] Percentile in [0, 100]
+     * \return Percentile, or NaN if there are no samples
+     */
+    double percentile(double p) const
+    {
+      if (samples_.empty()) return std::nan("");
+      std::vector<double> sorted(samples_);
+      size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+      rank = std::min(std::max<size_t>(rank, 1), sorted.size()) - 1;
+      std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+      return sorted[rank];
+    }
+
+    /** \brief Total number of samples added, including the ones which left the window */
+    size_t count() const { return count_; }
+
+  private:
+    size_t window_size_;
+    std::vector<double> samples_;
+    size_t next_;
+    size_t count_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_STAGE_LATENCY_H
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_OBJECT_RECOGNITION_WORKSPACE_IMAGE_CROP_H
+#define MIR_OBJECT_RECOGNITION_WORKSPACE_IMAGE_CROP_H
+
+#include <Eigen/Dense>
+
+#include <opencv2/core/core.hpp>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/RegionOfInterest.h>
+
+#include <mir_perception_utils/aliases.h>
+
+/** \brief Maps regions of a cropped and downscaled image back to the full image */
+struct ImageCrop
+{
+  ImageCrop() : x_offset(0), y_offset(0), scale(1.0), full_width(0), full_height(0) {}
+
+  /** \brief Map a region of the cropped image to the full image, clipped to the image */
+  void toFullFrame(sensor_msgs::RegionOfInterest &roi) const;
+
+  int x_offset;
+  int y_offset;
+  // Size of the cropped image divided by the size of the crop in the full image
+  double scale;
+  int full_width;
+  int full_height;
+};
+
+/** \brief Crops the image of a view to the workspace before it is sent to the rgb
+ * recognizer, and optionally downscales it to the input size of the detector.
+ *
+ * The workspace is the prism of max_height above and below the convex hull of the plane.
+ * Since the view cloud is organized and registered to the image, the workspace is
+ * projected into the image by testing the points of a subsampled pixel grid against the
+ * prism, no camera intrinsics are needed. The crop is the bounding rectangle of these
+ * pixels plus a margin.
+ */
+class WorkspaceImageCrop
+{
+  public:
+    struct Params
+    {
+      Params();
+
+      bool crop_to_workspace;
+      int margin;          // pixels added around the workspace
+      int max_size;        // max width and height of the sent image, 0 disables downscaling
+      double max_height;   // meters above the plane
+      int stride;          // grid step in pixels
+    };
+
+    WorkspaceImageCrop();
+
+    void setParams(const Params &params);
+
+    /** \brief Crop and downscale the image of a view
+     * \param[in] Image of the view
+     * \param[in] Organized cloud of the view, in the frame of the hull
+     * \param[in] Convex hull of the workspace plane, may be empty
+     * \param[in] Normal of the workspace plane
+     * \param[out] Cropped image with the header of the input image
+     * \param[out] Mapping of the cropped image to the full image
+     * \param[in] Pixels of the image per point of the cloud, for clouds deprojected from
+     *     a depth image with a stride
+     * \return False if the image is sent as it is (no workspace found, nothing to crop
+     *     or downscale)
+     * */
+    bool crop(const sensor_msgs::ImageConstPtr &image, const PointCloud &cloud, const PointCloud &hull,
+              const Eigen::Vector3f &normal, sensor_msgs::ImagePtr &cropped, ImageCrop &image_crop,
+              int cloud_stride = 1) const;
+
+    /** \brief Bounding rectangle of the workspace in the image of an organized cloud
+     * \return False if the cloud is not organized or no point lies in the workspace
+     * */
+    bool workspaceRect(const PointCloud &cloud, const PointCloud &hull, const Eigen::Vector3f &normal,
+                       cv::Rect &rect) const;
+
+  private:
+    Params params_;
+};
+
+#endif  // MIR_OBJECT_RECOGNITION_WORKSPACE_IMAGE_CROP_H
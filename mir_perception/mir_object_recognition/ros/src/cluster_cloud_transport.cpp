@@ -0,0 +1,149 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <pcl_conversions/pcl_conversions.h>
+#include <ros/ros.h>
+
+#include <mir_object_recognition/cluster_cloud_transport.h>
+
+const uint32_t SharedMemoryRing::MAGIC;
+const uint32_t SharedMemoryRing::VERSION;
+const uint64_t SharedMemoryRing::DATA_OFFSET;
+
+SharedMemoryRing::SharedMemoryRing() : capacity_(0), mapped_size_(0), header_(nullptr), data_(nullptr) {}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+  close();
+}
+
+bool SharedMemoryRing::create(const std::string &name, size_t capacity)
+{
+  static_assert(sizeof(Header) <= DATA_OFFSET, "ring header does not fit in the data offset");
+  close();
+  if (capacity == 0)
+    return false;
+
+  // a segment left over by a crashed writer with the same name is reused
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0660);
+  if (fd < 0)
+  {
+    ROS_WARN("[SharedMemoryRing] Cannot open %s: %s", name.c_str(), std::strerror(errno));
+    return false;
+  }
+  const size_t mapped_size = DATA_OFFSET + capacity;
+  if (ftruncate(fd, mapped_size) != 0)
+  {
+    ROS_WARN("[SharedMemoryRing] Cannot resize %s: %s", name.c_str(), std::strerror(errno));
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void *address = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED)
+  {
+    ROS_WARN("[SharedMemoryRing] Cannot map %s: %s", name.c_str(), std::strerror(errno));
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  name_ = name;
+  capacity_ = capacity;
+  mapped_size_ = mapped_size;
+  header_ = new (address) Header;
+  header_->magic = MAGIC;
+  header_->version = VERSION;
+  header_->capacity = capacity;
+  header_->data_offset = DATA_OFFSET;
+  header_->write_position.store(0);
+  data_ = static_cast<uint8_t *>(address) + DATA_OFFSET;
+  return true;
+}
+
+void SharedMemoryRing::close()
+{
+  if (!header_)
+    return;
+  munmap(header_, mapped_size_);
+  shm_unlink(name_.c_str());
+  header_ = nullptr;
+  data_ = nullptr;
+  capacity_ = 0;
+  mapped_size_ = 0;
+}
+
+bool SharedMemoryRing::write(const void *data, size_t size, uint64_t &position)
+{
+  if (!header_ || size == 0 || size > capacity_ / 2)
+    return false;
+
+  // 8 byte aligned records, a record which does not fit before the end of the ring starts
+  // at the beginning of the next lap
+  uint64_t start = (header_->write_position.load(std::memory_order_relaxed) + 7) & ~uint64_t(7);
+  uint64_t offset = start % capacity_;
+  if (offset + size > capacity_)
+  {
+    start += capacity_ - offset;
+    offset = 0;
+  }
+  // reserve before copying, readers of the overwritten records see the new write position
+  header_->write_position.store(start + size, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(data_ + offset, data, size);
+  position = start;
+  return true;
+}
+
+const char ClusterCloudTransport::HANDLE_PREFIX[] = "shm:";
+
+ClusterCloudTransport::ClusterCloudTransport()
+{
+  PointCloud empty;
+  pcl::toROSMsg(empty, layout_);
+}
+
+bool ClusterCloudTransport::open(const std::string &name, size_t capacity)
+{
+  return ring_.create(name, capacity);
+}
+
+bool ClusterCloudTransport::encode(const PointCloud &cluster, const std_msgs::Header &header,
+                                   sensor_msgs::PointCloud2 &handle)
+{
+  const size_t size = cluster.points.size() * sizeof(PointT);
+  uint64_t position;
+  if (!ring_.write(cluster.points.data(), size, position))
+    return false;
+
+  handle.header = header;
+  handle.height = 1;
+  handle.width = cluster.points.size();
+  handle.fields = layout_.fields;
+  handle.is_bigendian = layout_.is_bigendian;
+  handle.point_step = sizeof(PointT);
+  handle.row_step = size;
+  handle.is_dense = cluster.is_dense;
+  handle.data.clear();
+
+  sensor_msgs::PointField field;
+  // the segment name without the leading slash, as it appears in /dev/shm
+  std::string segment = ring_.name();
+  if (!segment.empty() && segment[0] == '/')
+    segment.erase(0, 1);
+  field.name = HANDLE_PREFIX + segment;
+  field.offset = static_cast<uint32_t>(position & 0xffffffff);
+  field.count = static_cast<uint32_t>(position >> 32);
+  field.datatype = 0;
+  handle.fields.push_back(field);
+  return true;
+}
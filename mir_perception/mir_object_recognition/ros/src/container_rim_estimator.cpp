@@ -0,0 +1,154 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <mir_object_recognition/container_rim_estimator.h>
+
+namespace
+{
+struct RasterCell
+{
+  RasterCell()
+    : count(0), sum_x(0.0), sum_y(0.0), sum_z(0.0),
+      min_z(std::numeric_limits<float>::max()), max_z(-std::numeric_limits<float>::max())
+  {
+  }
+
+  float meanZ() const { return static_cast<float>(sum_z / count); }
+
+  int count;
+  double sum_x;
+  double sum_y;
+  double sum_z;
+  float min_z;
+  float max_z;
+};
+}  // namespace
+
+ContainerRimEstimator::Params::Params()
+  : cell_size(0.005), floor_slice(0.5), flatness_tolerance(0.01), max_normal_angle(0.26),
+    min_points(300), max_cells(1 << 18)
+{
+}
+
+ContainerRimEstimator::ContainerRimEstimator() {}
+
+void ContainerRimEstimator::setParams(const Params &params)
+{
+  params_ = params;
+  params_.cell_size = std::max(params_.cell_size, 0.001);
+  params_.floor_slice = std::min(std::max(params_.floor_slice, 0.0), 1.0);
+  params_.flatness_tolerance = std::max(params_.flatness_tolerance, 0.0);
+  params_.min_points = std::max(params_.min_points, 1);
+  params_.max_cells = std::max(params_.max_cells, 1);
+}
+
+bool ContainerRimEstimator::estimate(const PointCloud &cloud, Eigen::Vector3f &center, float &rim_height,
+                                     const PointCloudN::ConstPtr &normals) const
+{
+  Eigen::Vector3f min_pt = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max_pt = -min_pt;
+  int num_finite = 0;
+  for (const auto &point : cloud.points)
+  {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+      continue;
+    min_pt = min_pt.cwiseMin(point.getVector3fMap());
+    max_pt = max_pt.cwiseMax(point.getVector3fMap());
+    num_finite++;
+  }
+  if (num_finite < params_.min_points)
+    return false;
+
+  // raster of the floor slice, coarser if the cloud spans too many cells
+  double cell_size = params_.cell_size;
+  int width = static_cast<int>((max_pt.x() - min_pt.x()) / cell_size) + 1;
+  int height = static_cast<int>((max_pt.y() - min_pt.y()) / cell_size) + 1;
+  while (static_cast<int64_t>(width) * height > params_.max_cells)
+  {
+    cell_size *= 2.0;
+    width = static_cast<int>((max_pt.x() - min_pt.x()) / cell_size) + 1;
+    height = static_cast<int>((max_pt.y() - min_pt.y()) / cell_size) + 1;
+  }
+  const float slice_top = min_pt.z() + params_.floor_slice * (max_pt.z() - min_pt.z());
+  const bool use_normals = normals && normals->points.size() == cloud.points.size();
+  const float min_normal_z = std::cos(params_.max_normal_angle);
+
+  std::vector<RasterCell> raster(width * height);
+  for (size_t i = 0; i < cloud.points.size(); i++)
+  {
+    const PointT &point = cloud.points[i];
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z) ||
+        point.z > slice_top)
+      continue;
+    // walls and edges, points without a normal are kept
+    if (use_normals && std::isfinite(normals->points[i].normal_z) &&
+        std::abs(normals->points[i].normal_z) < min_normal_z)
+      continue;
+    const int col = std::min(static_cast<int>((point.x - min_pt.x()) / cell_size), width - 1);
+    const int row = std::min(static_cast<int>((point.y - min_pt.y()) / cell_size), height - 1);
+    RasterCell &cell = raster[row * width + col];
+    cell.count++;
+    cell.sum_x += point.x;
+    cell.sum_y += point.y;
+    cell.sum_z += point.z;
+    cell.min_z = std::min(cell.min_z, point.z);
+    cell.max_z = std::max(cell.max_z, point.z);
+  }
+
+  const float tolerance = params_.flatness_tolerance;
+  auto isFlat = [&](const RasterCell &cell)
+  {
+    return cell.count > 0 && cell.max_z - cell.min_z <= tolerance;
+  };
+
+  // 8-connected components of the flat cells
+  std::vector<bool> visited(raster.size(), false);
+  std::vector<int> stack;
+  RasterCell best;
+  for (int seed = 0; seed < static_cast<int>(raster.size()); seed++)
+  {
+    if (visited[seed] || !isFlat(raster[seed]))
+      continue;
+    RasterCell region;
+    visited[seed] = true;
+    stack.push_back(seed);
+    while (!stack.empty())
+    {
+      const int index = stack.back();
+      stack.pop_back();
+      const RasterCell &cell = raster[index];
+      region.count += cell.count;
+      region.sum_x += cell.sum_x;
+      region.sum_y += cell.sum_y;
+      region.sum_z += cell.sum_z;
+      const int row = index / width;
+      const int col = index % width;
+      for (int r = std::max(row - 1, 0); r <= std::min(row + 1, height - 1); r++)
+      {
+        for (int c = std::max(col - 1, 0); c <= std::min(col + 1, width - 1); c++)
+        {
+          const int neighbour = r * width + c;
+          if (visited[neighbour] || !isFlat(raster[neighbour]) ||
+              std::abs(raster[neighbour].meanZ() - cell.meanZ()) > tolerance)
+            continue;
+          visited[neighbour] = true;
+          stack.push_back(neighbour);
+        }
+      }
+    }
+    if (region.count >= best.count)
+      best = region;
+  }
+  if (best.count < params_.min_points)
+    return false;
+
+  center = Eigen::Vector3f(best.sum_x / best.count, best.sum_y / best.count, best.sum_z / best.count);
+  rim_height = max_pt.z();
+  return true;
+}
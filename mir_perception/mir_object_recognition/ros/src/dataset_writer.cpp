@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/imgcodecs.hpp>
+#include <pcl/io/pcd_io.h>
+#include <ros/ros.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <mir_object_recognition/dataset_writer.h>
+
+DatasetWriter::DatasetWriter(const std::string &logdir, size_t queue_size, uint64_t disk_budget)
+  : logdir_(logdir), disk_budget_(disk_budget), queue_(queue_size, true), stats_()
+{
+  writer_thread_ = std::thread(&DatasetWriter::writerLoop, this);
+}
+
+DatasetWriter::~DatasetWriter()
+{
+  queue_.close();
+  writer_thread_.join();
+}
+
+bool DatasetWriter::savePointCloud(const PointCloud::ConstPtr &cloud, const std::string &name)
+{
+  Sample sample;
+  sample.name = name;
+  sample.cloud = cloud;
+  return enqueue(sample);
+}
+
+bool DatasetWriter::saveImage(const sensor_msgs::ImageConstPtr &image, const std::string &name)
+{
+  Sample sample;
+  sample.name = name;
+  sample.image = image;
+  return enqueue(sample);
+}
+
+DatasetWriter::Stats DatasetWriter::getStats()
+{
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  Stats stats = stats_;
+  stats.queue_size = queue_.size();
+  return stats;
+}
+
+bool DatasetWriter::enqueue(const Sample &sample)
+{
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (disk_budget_ > 0 && stats_.bytes_written >= disk_budget_)
+    {
+      stats_.over_budget++;
+      ROS_WARN_THROTTLE(10.0, "[DatasetWriter] Disk budget of %lu bytes used up, rejecting samples",
+                        (unsigned long)disk_budget_);
+      return false;
+    }
+    stats_.queued++;
+  }
+  size_t dropped = queue_.push(sample);
+  if (dropped > 0)
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.dropped += dropped;
+    ROS_WARN_THROTTLE(10.0, "[DatasetWriter] Writer falls behind, dropped %lu samples so far",
+                      (unsigned long)stats_.dropped);
+  }
+  return true;
+}
+
+void DatasetWriter::writerLoop()
+{
+  Sample sample;
+  while (queue_.pop(sample))
+  {
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      if (disk_budget_ > 0 && stats_.bytes_written >= disk_budget_)
+      {
+        stats_.over_budget++;
+        continue;
+      }
+    }
+    std::string filename;
+    bool success = write(sample, filename);
+    boost::system::error_code ec;
+    uint64_t file_size = success ? boost::filesystem::file_size(filename, ec) : 0;
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (success && !ec)
+    {
+      stats_.written++;
+      stats_.bytes_written += file_size;
+      ROS_DEBUG_STREAM("[DatasetWriter] Saved " << filename);
+    }
+    else
+    {
+      stats_.failed++;
+      ROS_ERROR_STREAM("[DatasetWriter] Cannot save " << filename);
+    }
+  }
+}
+
+bool DatasetWriter::write(const Sample &sample, std::string &filename)
+{
+  boost::filesystem::path path = boost::filesystem::path(logdir_) / sample.name;
+  if (sample.cloud)
+  {
+    filename = path.string() + ".pcd";
+    return pcl::io::savePCDFileBinaryCompressed(filename, *sample.cloud) == 0;
+  }
+
+  filename = path.string() + ".png";
+  cv_bridge::CvImageConstPtr cv_image;
+  try
+  {
+    cv_image = cv_bridge::toCvShare(sample.image, sensor_msgs::image_encodings::BGR8);
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+    return false;
+  }
+  // fastest png compression, the images are large and written often
+  std::vector<int> params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+  return cv::imwrite(filename, cv_image->image, params);
+}
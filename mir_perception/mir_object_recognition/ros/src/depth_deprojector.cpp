@@ -0,0 +1,159 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <opencv2/calib3d/calib3d.hpp>
+
+#include <mir_object_recognition/depth_deprojector.h>
+
+DepthDeprojector::DepthDeprojector(const sensor_msgs::CameraInfo &camera_info)
+  : width_(camera_info.width),
+    height_(camera_info.height),
+    intrinsics_(camera_info.K.begin(), camera_info.K.end()),
+    distortion_(camera_info.D.begin(), camera_info.D.end())
+{
+  const double fx = camera_info.K[0];
+  const double fy = camera_info.K[4];
+  const double cx = camera_info.K[2];
+  const double cy = camera_info.K[5];
+  if (width_ <= 0 || height_ <= 0 || fx <= 0.0 || fy <= 0.0)
+    return;
+
+  rays_.resize(2 * static_cast<size_t>(width_) * height_);
+  const bool distorted = std::any_of(distortion_.begin(), distortion_.end(),
+                                     [](double d) { return d != 0.0; });
+  if (!distorted)
+  {
+    // rectified images, e.g. depth aligned to the color camera
+    for (int v = 0; v < height_; v++)
+    {
+      float *ray = &rays_[2 * static_cast<size_t>(v) * width_];
+      const float y = static_cast<float>((v - cy) / fy);
+      for (int u = 0; u < width_; u++)
+      {
+        ray[2 * u] = static_cast<float>((u - cx) / fx);
+        ray[2 * u + 1] = y;
+      }
+    }
+    return;
+  }
+
+  std::vector<cv::Point2f> pixels;
+  pixels.reserve(static_cast<size_t>(width_) * height_);
+  for (int v = 0; v < height_; v++)
+  {
+    for (int u = 0; u < width_; u++)
+    {
+      pixels.emplace_back(static_cast<float>(u), static_cast<float>(v));
+    }
+  }
+  std::vector<cv::Point2f> normalized;
+  cv::Mat K(3, 3, CV_64F, intrinsics_.data());
+  cv::Mat D(1, static_cast<int>(distortion_.size()), CV_64F, distortion_.data());
+  cv::undistortPoints(pixels, normalized, K, D);
+  for (size_t i = 0; i < normalized.size(); i++)
+  {
+    rays_[2 * i] = normalized[i].x;
+    rays_[2 * i + 1] = normalized[i].y;
+  }
+}
+
+bool DepthDeprojector::matches(const sensor_msgs::CameraInfo &camera_info) const
+{
+  return static_cast<int>(camera_info.width) == width_ &&
+         static_cast<int>(camera_info.height) == height_ &&
+         std::equal(camera_info.K.begin(), camera_info.K.end(), intrinsics_.begin()) &&
+         camera_info.D.size() == distortion_.size() &&
+         std::equal(camera_info.D.begin(), camera_info.D.end(), distortion_.begin());
+}
+
+bool DepthDeprojector::deproject(const cv::Mat &depth, const cv::Mat &color,
+                                 const Eigen::Matrix3f &rotation, const Eigen::Vector3f &translation,
+                                 const cv::Rect &region, int stride, bool organized,
+                                 PointCloud &cloud) const
+{
+  cloud.clear();
+  if (rays_.empty() || depth.cols != width_ || depth.rows != height_ ||
+      (depth.type() != CV_16UC1 && depth.type() != CV_32FC1))
+    return false;
+  const cv::Rect rect = region & cv::Rect(0, 0, width_, height_);
+  stride = std::max(stride, 1);
+  const bool colored = !color.empty() && color.cols == width_ && color.rows == height_ &&
+                       color.type() == CV_8UC3;
+  const bool millimeters = depth.type() == CV_16UC1;
+
+  const int cols = (rect.width + stride - 1) / stride;
+  const int rows = (rect.height + stride - 1) / stride;
+  cloud.points.reserve(static_cast<size_t>(cols) * rows);
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (int v = rect.y; v < rect.y + rect.height; v += stride)
+  {
+    const float *ray_row = &rays_[2 * static_cast<size_t>(v) * width_];
+    const uint16_t *depth_mm = millimeters ? depth.ptr<uint16_t>(v) : nullptr;
+    const float *depth_m = millimeters ? nullptr : depth.ptr<float>(v);
+    const cv::Vec3b *color_row = colored ? color.ptr<cv::Vec3b>(v) : nullptr;
+    for (int u = rect.x; u < rect.x + rect.width; u += stride)
+    {
+      const float z = millimeters ? depth_mm[u] * 0.001f : depth_m[u];
+      PointT point;
+      if (!(z > 0.0f) || !std::isfinite(z))
+      {
+        if (!organized)
+          continue;
+        point.x = point.y = point.z = nan;
+      }
+      else
+      {
+        const Eigen::Vector3f p(ray_row[2 * u] * z, ray_row[2 * u + 1] * z, z);
+        point.getVector3fMap() = rotation * p + translation;
+      }
+      if (colored)
+      {
+        point.b = color_row[u][0];
+        point.g = color_row[u][1];
+        point.r = color_row[u][2];
+      }
+      else
+      {
+        point.r = point.g = point.b = 255;
+      }
+      cloud.points.push_back(point);
+    }
+  }
+  if (organized)
+  {
+    cloud.width = cols;
+    cloud.height = rows;
+    cloud.is_dense = false;
+  }
+  else
+  {
+    cloud.width = cloud.points.size();
+    cloud.height = 1;
+    cloud.is_dense = true;
+  }
+  return true;
+}
+
+bool DepthView::deprojectRegion(const cv::Rect &region, int image_width, int image_height,
+                                PointCloud &cloud) const
+{
+  if (!depth || !deprojector || image_width <= 0 || image_height <= 0)
+    return false;
+  // aligned depth usually has the size of the image, scale the region otherwise
+  const double sx = static_cast<double>(deprojector->width()) / image_width;
+  const double sy = static_cast<double>(deprojector->height()) / image_height;
+  const int x_min = static_cast<int>(std::floor(region.x * sx));
+  const int y_min = static_cast<int>(std::floor(region.y * sy));
+  const int x_max = static_cast<int>(std::ceil((region.x + region.width) * sx));
+  const int y_max = static_cast<int>(std::ceil((region.y + region.height) * sy));
+  const cv::Rect depth_region(x_min, y_min, x_max - x_min, y_max - y_min);
+  if (!deprojector->deproject(depth->image, color ? color->image : cv::Mat(), rotation, translation,
+                              depth_region, 1, false, cloud))
+    return false;
+  cloud.header.frame_id = frame_id;
+  return true;
+}
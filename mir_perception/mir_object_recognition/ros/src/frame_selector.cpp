@@ -0,0 +1,260 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <ros/ros.h>
+
+#include <mir_object_recognition/frame_selector.h>
+
+FrameSelector::Params::Params()
+  : window_size(3),
+    image_width(160),
+    depth_stride(4),
+    stability_tolerance(0.005),
+    depth_weight(0.4),
+    sharpness_weight(0.4),
+    stability_weight(0.2)
+{
+}
+
+FrameSelector::FrameSelector() {}
+
+void FrameSelector::setParams(const Params &params)
+{
+  params_ = params;
+  params_.window_size = std::max<size_t>(params_.window_size, 1);
+  params_.image_width = std::max(params_.image_width, 16);
+  params_.depth_stride = std::max(params_.depth_stride, 1);
+}
+
+bool FrameSelector::add(const sensor_msgs::ImageConstPtr &image,
+                        const sensor_msgs::PointCloud2ConstPtr &cloud)
+{
+  if (candidates_.empty())
+  {
+    window_timer_.restart();
+  }
+  Candidate candidate;
+  candidate.image = image;
+  candidate.cloud = cloud;
+  // a single candidate is selected anyway, skip the scoring
+  if (params_.window_size > 1)
+  {
+    candidate.quality.valid_depth_ratio = sampleDepth(*cloud, candidate.depth_samples);
+  }
+  return addCandidate(candidate);
+}
+
+bool FrameSelector::add(const sensor_msgs::ImageConstPtr &image,
+                        const sensor_msgs::ImageConstPtr &depth)
+{
+  if (candidates_.empty())
+  {
+    window_timer_.restart();
+  }
+  Candidate candidate;
+  candidate.image = image;
+  candidate.depth = depth;
+  if (params_.window_size > 1)
+  {
+    candidate.quality.valid_depth_ratio = sampleDepth(*depth, candidate.depth_samples);
+  }
+  return addCandidate(candidate);
+}
+
+bool FrameSelector::addCandidate(Candidate &candidate)
+{
+  if (params_.window_size > 1)
+  {
+    candidate.quality.sharpness = sharpness(candidate.image);
+    if (!candidates_.empty())
+    {
+      candidate.quality.stability = depthStability(candidate.depth_samples,
+                                                   candidates_.back().depth_samples);
+      // the first candidate has no predecessor, it is as stable as its successor
+      if (candidates_.size() == 1)
+      {
+        candidates_.front().quality.stability = candidate.quality.stability;
+      }
+    }
+  }
+  candidates_.push_back(candidate);
+  return candidates_.size() >= params_.window_size;
+}
+
+bool FrameSelector::select(sensor_msgs::ImageConstPtr &image, sensor_msgs::PointCloud2ConstPtr &cloud,
+                           sensor_msgs::ImageConstPtr &depth, Quality &quality)
+{
+  if (candidates_.empty())
+    return false;
+
+  double max_sharpness = 0.0;
+  for (const auto &candidate : candidates_)
+  {
+    max_sharpness = std::max(max_sharpness, candidate.quality.sharpness);
+  }
+  size_t best = 0;
+  for (size_t i = 0; i < candidates_.size(); i++)
+  {
+    Quality &q = candidates_[i].quality;
+    double normalized_sharpness = max_sharpness > 0.0 ? q.sharpness / max_sharpness : 1.0;
+    q.score = params_.depth_weight * q.valid_depth_ratio +
+              params_.sharpness_weight * normalized_sharpness +
+              params_.stability_weight * q.stability;
+    ROS_DEBUG("[FrameSelector] Candidate %lu: valid depth %.3f, sharpness %.1f, stability %.3f, score %.3f",
+              (unsigned long)i, q.valid_depth_ratio, q.sharpness, q.stability, q.score);
+    // later candidates win ties, the camera had more time to settle
+    if (q.score >= candidates_[best].quality.score)
+    {
+      best = i;
+    }
+  }
+  image = candidates_[best].image;
+  cloud = candidates_[best].cloud;
+  depth = candidates_[best].depth;
+  quality = candidates_[best].quality;
+  reset();
+  return true;
+}
+
+void FrameSelector::reset()
+{
+  candidates_.clear();
+}
+
+double FrameSelector::sharpness(const sensor_msgs::ImageConstPtr &image) const
+{
+  cv_bridge::CvImageConstPtr cv_image;
+  try
+  {
+    cv_image = cv_bridge::toCvShare(image);
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+    return 0.0;
+  }
+  const cv::Mat &full = cv_image->image;
+  if (full.empty())
+    return 0.0;
+
+  // downscale first, the sharpness only needs the coarse edges
+  cv::Mat small;
+  double scale = std::min(1.0, static_cast<double>(params_.image_width) / full.cols);
+  cv::resize(full, small, cv::Size(), scale, scale, cv::INTER_AREA);
+  cv::Mat gray;
+  if (small.channels() == 3)
+    cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+  else if (small.channels() == 4)
+    cv::cvtColor(small, gray, cv::COLOR_BGRA2GRAY);
+  else
+    gray = small;
+
+  cv::Mat laplacian;
+  cv::Laplacian(gray, laplacian, CV_64F);
+  cv::Scalar mean, stddev;
+  cv::meanStdDev(laplacian, mean, stddev);
+  return stddev[0] * stddev[0];
+}
+
+double FrameSelector::sampleDepth(const sensor_msgs::PointCloud2 &cloud, std::vector<float> &samples) const
+{
+  samples.clear();
+  int z_offset = -1;
+  for (const auto &field : cloud.fields)
+  {
+    if (field.name == "z" && field.datatype == sensor_msgs::PointField::FLOAT32)
+      z_offset = field.offset;
+  }
+  if (z_offset < 0 || cloud.width == 0 || cloud.height == 0)
+    return 0.0;
+  if (z_offset + sizeof(float) > cloud.point_step ||
+      cloud.row_step < static_cast<size_t>(cloud.point_step) * cloud.width ||
+      cloud.data.size() < static_cast<size_t>(cloud.row_step) * cloud.height)
+  {
+    ROS_WARN("[FrameSelector] Pointcloud data size does not match its width, height and steps");
+    return 0.0;
+  }
+
+  const size_t stride = params_.depth_stride;
+  size_t num_valid = 0;
+  samples.reserve((cloud.width / stride + 1) * (cloud.height / stride + 1));
+  for (size_t row = 0; row < cloud.height; row += stride)
+  {
+    const uint8_t *row_data = &cloud.data[row * cloud.row_step];
+    for (size_t col = 0; col < cloud.width; col += stride)
+    {
+      float z;
+      std::memcpy(&z, row_data + col * cloud.point_step + z_offset, sizeof(float));
+      if (std::isfinite(z))
+        num_valid++;
+      else
+        z = std::numeric_limits<float>::quiet_NaN();
+      samples.push_back(z);
+    }
+  }
+  return samples.empty() ? 0.0 : static_cast<double>(num_valid) / samples.size();
+}
+
+double FrameSelector::sampleDepth(const sensor_msgs::Image &depth, std::vector<float> &samples) const
+{
+  samples.clear();
+  cv_bridge::CvImageConstPtr cv_depth;
+  try
+  {
+    cv_depth = cv_bridge::toCvShare(depth, std::string());
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+    return 0.0;
+  }
+  const cv::Mat &image = cv_depth->image;
+  if (image.empty() || (image.type() != CV_16UC1 && image.type() != CV_32FC1))
+    return 0.0;
+
+  // the same grid as for the clouds, in meters
+  const int stride = params_.depth_stride;
+  const bool millimeters = image.type() == CV_16UC1;
+  size_t num_valid = 0;
+  samples.reserve((image.cols / stride + 1) * (image.rows / stride + 1));
+  for (int row = 0; row < image.rows; row += stride)
+  {
+    for (int col = 0; col < image.cols; col += stride)
+    {
+      float z = millimeters ? image.ptr<uint16_t>(row)[col] * 0.001f : image.ptr<float>(row)[col];
+      if (std::isfinite(z) && z > 0.0f)
+        num_valid++;
+      else
+        z = std::numeric_limits<float>::quiet_NaN();
+      samples.push_back(z);
+    }
+  }
+  return samples.empty() ? 0.0 : static_cast<double>(num_valid) / samples.size();
+}
+
+double FrameSelector::depthStability(const std::vector<float> &a, const std::vector<float> &b) const
+{
+  if (a.size() != b.size() || a.empty())
+    return 0.0;
+  size_t num_compared = 0;
+  size_t num_stable = 0;
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    const bool valid_a = std::isfinite(a[i]);
+    const bool valid_b = std::isfinite(b[i]);
+    if (!valid_a && !valid_b)
+      continue;
+    num_compared++;
+    // a point which appears or disappears is unstable
+    if (valid_a && valid_b && std::abs(a[i] - b[i]) <= params_.stability_tolerance)
+      num_stable++;
+  }
+  return num_compared > 0 ? static_cast<double>(num_stable) / num_compared : 0.0;
+}
@@ -5,10 +5,13 @@
  *
  */
 #include <algorithm>
+#include <chrono>
+#include <future>
+#include <string>
 
-#include <boost/filesystem.hpp>
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
+#include <unistd.h>
+
+#include <boost/make_shared.hpp>
 
 #include <cv_bridge/cv_bridge.h>
 #include <opencv2/core/core.hpp>
@@ -18,6 +21,8 @@
 #include <std_msgs/String.h>
 #include <std_msgs/Float64.h>
 #include <geometry_msgs/PoseArray.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <diagnostic_msgs/KeyValue.h>
 
 #include <mas_perception_msgs/ImageList.h>
 #include <mas_perception_msgs/BoundingBoxList.h>
@@ -31,30 +36,39 @@
 
 MultimodalObjectRecognitionROS::MultimodalObjectRecognitionROS(ros::NodeHandle nh):
   nh_(nh),
+  server_(nh),
+  image_sub_(NULL),
+  cloud_sub_(NULL),
+  msg_sync_(NULL),
+  depth_input_(false),
+  depth_cloud_stride_(2),
+  depth_sub_(NULL),
+  camera_info_sub_(NULL),
+  depth_sync_(NULL),
+  continuous_mode_(false),
+  pipeline_stopping_(false),
+  capture_view_(false),
+  views_claimed_(false),
+  reset_views_(false),
+  capture_state_(CAPTURE_IDLE),
+  jobs_closed_(false),
+  diagnostic_updater_(nh, nh, nh.getNamespace()),
   pointcloud_msg_received_count_(0),
   image_msg_received_count_(0),
-  received_recognized_cloud_list_flag_(false),
-  received_recognized_image_list_flag_(false),
-  rgb_object_id_(100),
-  container_height_(0.05),
-  rgb_roi_adjustment_(2),
-  rgb_bbox_min_diag_(21),
-  rgb_bbox_max_diag_(250),
-  roi_min_bbox_z_(0.03),
-  bounding_box_visualizer_pc_("output/bounding_boxes", Color(Color::IVORY)),
-  cluster_visualizer_rgb_("output/tabletop_cluster_rgb"),
-  cluster_visualizer_pc_("output/tabletop_cluster_pc"),
-  label_visualizer_rgb_("output/rgb_labels", Color(Color::SEA_GREEN)),
-  label_visualizer_pc_("output/pc_labels", Color(Color::IVORY)),
+  bounding_box_visualizer_pc_(&nh_, "output/bounding_boxes", Color(Color::IVORY)),
+  cluster_visualizer_rgb_(boost::make_shared<ros::NodeHandle>(nh), "output/tabletop_cluster_rgb"),
+  cluster_visualizer_pc_(boost::make_shared<ros::NodeHandle>(nh), "output/tabletop_cluster_pc"),
+  label_visualizer_rgb_(nh, "output/rgb_labels", Color(Color::SEA_GREEN)),
+  label_visualizer_pc_(nh, "output/pc_labels", Color(Color::IVORY)),
   data_collection_(false),
-  enable_roi_(true),
-  rgb_cluster_remove_outliers_(true),
   enable_rgb_recognizer_(true),
   enable_pc_recognizer_(true)
 {
   tf_listener_.reset(new tf::TransformListener);
-  scene_segmentation_ros_ = SceneSegmentationROSSPtr(new SceneSegmentationROS());
-  mm_object_recognition_utils_ = MultimodalObjectRecognitionUtilsSPtr(new MultimodalObjectRecognitionUtils());
+  // The segmentation, ROI, pose and adjustment chain, the rgb detections are processed in parallel
+  int rgb_detection_workers;
+  nh_.param<int>("rgb_detection_workers", rgb_detection_workers, 0);
+  pipeline_.reset(new MultimodalObjectRecognitionPipeline(std::max(0, rgb_detection_workers)));
 
   dynamic_reconfigure::Server<mir_object_recognition::SceneSegmentationConfig>::CallbackType f =
               boost::bind(&MultimodalObjectRecognitionROS::configCallback, this, _1, _2);
@@ -63,17 +77,89 @@ MultimodalObjectRecognitionROS::MultimodalObjectRecognitionROS(ros::NodeHandle n
   sub_event_in_ = nh_.subscribe("event_in", 1, &MultimodalObjectRecognitionROS::eventCallback, this);
   pub_event_out_ = nh_.advertise<std_msgs::String>("event_out", 1);
 
-  // Publish cloud and images to cloud and rgb recognition topics
-  pub_cloud_to_recognizer_  = nh_.advertise<mas_perception_msgs::ObjectList>(
-                "recognizer/pc/input/object_list", 1);
-  pub_image_to_recognizer_  = nh_.advertise<mas_perception_msgs::ImageList>(
-                "recognizer/rgb/input/images", 1);
+  // Publish cloud and images to cloud and rgb recognition topics and
+  // receive their replies on a dedicated callback queue
+  cloud_recognizer_client_ = boost::make_shared<CloudRecognizerClient>(nh_,
+                "recognizer/pc/input/object_list", "recognizer/pc/output/object_list",
+                &recognizer_callback_queue_);
+  image_recognizer_client_ = boost::make_shared<ImageRecognizerClient>(nh_,
+                "recognizer/rgb/input/images", "recognizer/rgb/output/object_list",
+                &recognizer_callback_queue_);
+  recognizer_spinner_ = boost::make_shared<ros::AsyncSpinner>(1, &recognizer_callback_queue_);
+  recognizer_spinner_->start();
+
+  // rgb_backend onnx runs an exported detection model in this process instead of the rgb
+  // recognizer node, the images are then neither serialized nor sent
+  std::string rgb_backend;
+  nh_.param<std::string>("rgb_backend", rgb_backend, "recognizer");
+  if (rgb_backend == "onnx")
+  {
+    OnnxDetector::Params detector_params;
+    std::string classes_file;
+    nh_.param<std::string>("rgb_onnx_model", detector_params.model_path, "");
+    nh_.param<std::string>("rgb_onnx_classes_file", classes_file, "");
+    nh_.param<int>("rgb_onnx_input_width", detector_params.input_width, 640);
+    nh_.param<int>("rgb_onnx_input_height", detector_params.input_height, 640);
+    nh_.param<double>("rgb_onnx_confidence_threshold", detector_params.confidence_threshold, 0.7);
+    nh_.param<double>("rgb_onnx_nms_threshold", detector_params.nms_threshold, 0.45);
+    nh_.param<int>("rgb_onnx_threads", detector_params.num_threads, 0);
+    if (!classes_file.empty() && !OnnxDetector::loadClassNames(classes_file, detector_params.class_names))
+    {
+      ROS_ERROR_STREAM("[multimodal_object_recognition] Cannot read the rgb classes " << classes_file);
+    }
+    rgb_detector_.reset(new OnnxDetector);
+    if (rgb_detector_->load(detector_params))
+    {
+      ROS_INFO_STREAM("[multimodal_object_recognition] RGB detection in process with " << detector_params.model_path);
+    }
+    else
+    {
+      ROS_ERROR_STREAM("[multimodal_object_recognition] Cannot load " << detector_params.model_path
+                       << ", using the rgb recognizer node");
+      rgb_detector_.reset();
+    }
+  }
+
+  // Cluster points are written to shared memory instead of the request message, the
+  // recognizer reads them by the handle in the cloud fields. Falls back to the message
+  // if shared memory is not available.
+  bool cluster_shm_transport;
+  int cluster_shm_size_mb;
+  nh_.param<bool>("cluster_shm_transport", cluster_shm_transport, false);
+  nh_.param<int>("cluster_shm_size_mb", cluster_shm_size_mb, 32);
+  if (cluster_shm_transport)
+  {
+    const std::string segment = "/mir_cluster_clouds_" + std::to_string(getpid());
+    if (cluster_transport_.open(segment, static_cast<size_t>(std::max(1, cluster_shm_size_mb)) * 1024 * 1024))
+    {
+      ROS_INFO_STREAM("[multimodal_object_recognition] Cluster clouds are passed in shared memory " << segment);
+    }
+    else
+    {
+      ROS_WARN("[multimodal_object_recognition] Shared memory not available, cluster clouds are sent in the message");
+    }
+  }
 
-  // Subscribe to cloud and rgb recognition topics
-  sub_recognized_cloud_list_ = nh_.subscribe("recognizer/pc/output/object_list", 1,
-              &MultimodalObjectRecognitionROS::recognizedCloudCallback, this);
-  sub_recognized_image_list_ = nh_.subscribe("recognizer/rgb/output/object_list", 1,
-              &MultimodalObjectRecognitionROS::recognizedImageCallback, this);
+  nh_.param<double>("pc_recognizer_timeout", pc_recognizer_timeout_, 10.0);
+  nh_.param<double>("rgb_recognizer_timeout", rgb_recognizer_timeout_, 3.0);
+  nh_.param<int>("continuous_queue_size", continuous_queue_size_, 2);
+  // Frame quality selection, the best of frame_selection_window frames is processed
+  FrameSelector::Params frame_selector_params;
+  int frame_selection_window;
+  nh_.param<int>("frame_selection_window", frame_selection_window, 3);
+  nh_.param<double>("frame_selection_timeout", frame_selection_timeout_, 0.5);
+  frame_selector_params.window_size = std::max(1, frame_selection_window);
+  frame_selector_.setParams(frame_selector_params);
+  // Input of the segmentation, the organized cloud of the camera or its depth image
+  std::string input_mode;
+  nh_.param<std::string>("input_mode", input_mode, "cloud");
+  nh_.param<int>("depth_cloud_stride", depth_cloud_stride_, 2);
+  depth_cloud_stride_ = std::max(1, depth_cloud_stride_);
+  depth_input_ = input_mode == "depth";
+  if (!depth_input_ && input_mode != "cloud")
+  {
+    ROS_ERROR_STREAM("[multimodal_object_recognition] Unknown input_mode " << input_mode << ", using cloud");
+  }
 
   // Pub combined object_list to object_list merger
   pub_object_list_  = nh_.advertise<mas_perception_msgs::ObjectList>("output/object_list", 10);
@@ -82,67 +168,146 @@ MultimodalObjectRecognitionROS::MultimodalObjectRecognitionROS(ros::NodeHandle n
   pub_workspace_height_ = nh_.advertise<std_msgs::Float64>("output/workspace_height", 1);
 
   // debug topics
-  pub_debug_cloud_plane_ = nh_.advertise<sensor_msgs::PointCloud2>("output/debug_cloud_plane", 1);
+  pub_debug_cloud_plane_ = mpu::LazyPublisher<sensor_msgs::PointCloud2>(nh_, "output/debug_cloud_plane", 1);
 
   nh_.param<bool>("debug_mode", debug_mode_, false);
   ROS_WARN_STREAM("[multimodal_object_recognition] Debug mode: " <<debug_mode_);
   // Pub pose array
-  pub_pc_object_pose_array_  = nh_.advertise<geometry_msgs::PoseArray>("output/pc_object_pose_array", 10);
-  pub_rgb_object_pose_array_  = nh_.advertise<geometry_msgs::PoseArray>("output/rgb_object_pose_array", 10);
+  pub_pc_object_pose_array_ = mpu::LazyPublisher<geometry_msgs::PoseArray>(nh_, "output/pc_object_pose_array", 10);
+  pub_rgb_object_pose_array_ = mpu::LazyPublisher<geometry_msgs::PoseArray>(nh_, "output/rgb_object_pose_array", 10);
 
   nh_.param<std::string>("target_frame_id", target_frame_id_, "base_link");
   ROS_WARN_STREAM("[multimodal_object_recognition] target frame: " <<target_frame_id_);
   nh_.param<std::string>("pointcloud_source_frame_id", pointcloud_source_frame_id_, "fixed_camera_link");
+  nh_.param<std::string>("scene_store_pose_frame_id", scene_store_pose_frame_, "map");
+  loadWorkspacePriors();
 
   nh_.param<std::string>("logdir", logdir_, "/tmp/");
   nh_.param<std::string>("object_info", object_info_path_, "None");
-  loadObjectInfo(object_info_path_);
+  int dataset_queue_size;
+  double dataset_disk_budget_mb;
+  nh_.param<int>("dataset_queue_size", dataset_queue_size, 32);
+  nh_.param<double>("dataset_disk_budget_mb", dataset_disk_budget_mb, 4096.0);
+  dataset_writer_.reset(new DatasetWriter(logdir_, std::max(1, dataset_queue_size),
+                                          static_cast<uint64_t>(std::max(0.0, dataset_disk_budget_mb) * 1024 * 1024)));
+  pipeline_->loadObjectInfo(object_info_path_);
 
   pub_filtered_rgb_cloud_plane_ =
-      nh_.advertise<sensor_msgs::PointCloud2>("filtered_rgb_cloud_plane", 1);
+      mpu::LazyPublisher<sensor_msgs::PointCloud2>(nh_, "filtered_rgb_cloud_plane", 1);
+
+  // Per-stage latency of every frame and rolling percentiles on /diagnostics
+  pub_stage_latency_ = nh_.advertise<diagnostic_msgs::DiagnosticStatus>("output/stage_latency", 10);
+  int latency_window_size;
+  nh_.param<int>("latency_window_size", latency_window_size, 200);
+  stage_latency_windows_.assign(NUM_PERCEPTION_STAGES, LatencyWindow(std::max(1, latency_window_size)));
+  diagnostic_updater_.setHardwareID("none");
+  diagnostic_updater_.add("Stage latency", this, &MultimodalObjectRecognitionROS::latencyDiagnostics);
+
+  // Perception jobs of e_start and of the action are processed one at a time by the job worker
+  recognize_objects_server_.reset(new RecognizeObjectsServer(nh_, "recognize_objects",
+                boost::bind(&MultimodalObjectRecognitionROS::goalCallback, this, _1),
+                boost::bind(&MultimodalObjectRecognitionROS::cancelCallback, this, _1), false));
+  job_thread_ = std::thread(&MultimodalObjectRecognitionROS::jobStage, this);
+  recognize_objects_server_->start();
 }
 
 MultimodalObjectRecognitionROS::~MultimodalObjectRecognitionROS()
 {
+  {
+    std::lock_guard<std::mutex> lock(capture_mutex_);
+    jobs_closed_ = true;
+  }
+  capture_cv_.notify_all();
+  cancelAllJobs();
+  job_queue_.close();
+  job_thread_.join();
+  recognize_objects_server_.reset();
+  stopPipeline();
+  recognizer_spinner_->stop();
 }
 
 void MultimodalObjectRecognitionROS::synchronizeCallback(const sensor_msgs::ImageConstPtr &image,
                       const sensor_msgs::PointCloud2ConstPtr &cloud)
 {
+  if (continuous_mode_)
+  {
+    PerceptionFrame::Ptr frame = std::make_shared<PerceptionFrame>();
+    frame->pointcloud_msg = cloud;
+    frame->image_msg = image;
+    frame->stamp = image->header.stamp;
+    if (input_frames_->push(frame) > 0)
+    {
+      ROS_DEBUG("[multimodal_object_recognition_ros] Pipeline busy, dropped stale frame");
+    }
+    return;
+  }
   if (pointcloud_msg_received_count_ < 1)
   {
-    ROS_INFO("[multimodal_object_recognition_ros] Received enough messages");
-    pointcloud_msg_ = cloud;
-    pointcloud_msg_->header.frame_id = pointcloud_source_frame_id_;
-    pointcloud_msg_received_count_ += 1;
-
-    image_msg_ = image;
-    image_msg_received_count_ += 1;
+    // collect a few candidates and process the best one
+    if (frame_selector_.add(image, cloud))
+    {
+      selectFrame();
+    }
   }
 }
 
-void MultimodalObjectRecognitionROS::recognizedCloudCallback(const mas_perception_msgs::ObjectList &msg)
+void MultimodalObjectRecognitionROS::synchronizeDepthCallback(const sensor_msgs::ImageConstPtr &image,
+                                                              const sensor_msgs::ImageConstPtr &depth,
+                                                              const sensor_msgs::CameraInfoConstPtr &camera_info)
 {
-  ROS_INFO("Received recognized cloud callback ");
-  if (!received_recognized_cloud_list_flag_)
+  if (!deprojector_ || !deprojector_->matches(*camera_info))
   {
-    recognized_cloud_list_ = msg;
-    received_recognized_cloud_list_flag_ = true;
+    deprojector_ = std::make_shared<const DepthDeprojector>(*camera_info);
+    if (!deprojector_->isValid())
+    {
+      ROS_ERROR_THROTTLE(2.0, "[multimodal_object_recognition_ros] Invalid camera info of the depth image");
+      deprojector_.reset();
+      return;
+    }
+  }
+  if (continuous_mode_)
+  {
+    PerceptionFrame::Ptr frame = std::make_shared<PerceptionFrame>();
+    frame->depth_msg = depth;
+    frame->deprojector = deprojector_;
+    frame->image_msg = image;
+    frame->stamp = image->header.stamp;
+    if (input_frames_->push(frame) > 0)
+    {
+      ROS_DEBUG("[multimodal_object_recognition_ros] Pipeline busy, dropped stale frame");
+    }
+    return;
+  }
+  if (pointcloud_msg_received_count_ < 1)
+  {
+    if (frame_selector_.add(image, depth))
+    {
+      selectFrame();
+    }
   }
 }
 
-void MultimodalObjectRecognitionROS::recognizedImageCallback(const mas_perception_msgs::ObjectList &msg)
+void MultimodalObjectRecognitionROS::selectFrame()
 {
-  ROS_INFO("Received recognized image callback ");
-  if (!received_recognized_image_list_flag_)
-  {
-    recognized_image_list_ = msg;
-    received_recognized_image_list_flag_ = true;
-  }
+  FrameSelector::Quality quality;
+  if (!frame_selector_.select(image_msg_, pointcloud_msg_, depth_msg_, quality))
+    return;
+  ROS_INFO("[multimodal_object_recognition_ros] Received enough messages, selected frame with "
+           "valid depth %.2f, sharpness %.1f, stability %.2f", quality.valid_depth_ratio,
+           quality.sharpness, quality.stability);
+  pointcloud_msg_received_count_ += 1;
+  image_msg_received_count_ += 1;
 }
 
 void MultimodalObjectRecognitionROS::update()
 {
+  diagnostic_updater_.update();
+  updateCapture();
+  // the camera stopped sending before the selection window is full
+  if (frame_selector_.size() > 0 && frame_selector_.age() > frame_selection_timeout_)
+  {
+    selectFrame();
+  }
   if (pointcloud_msg_received_count_ > 0 && image_msg_received_count_ > 0)
   {
     ROS_WARN("Received %d images and pointclouds", pointcloud_msg_received_count_);
@@ -150,375 +315,601 @@ void MultimodalObjectRecognitionROS::update()
     pointcloud_msg_received_count_ = 0;
     image_msg_received_count_ = 0;
 
-    image_sub_->unsubscribe();
-    cloud_sub_->unsubscribe();
+    unsubscribeInputs();
 
-    ROS_WARN_STREAM("Starting multimodal object recognition");
-    double start_time = ros::Time::now().toSec();
-    // transform pointcloud to the given frame_id
-    preprocessPointCloud(pointcloud_msg_);
-    scene_segmentation_ros_->addCloudAccumulation(cloud_);  // Extend this to work with multiple viewpoints
-    recognizeCloudAndImage();
-    double end_time = ros::Time::now().toSec();
-    ROS_INFO_STREAM("Total processing time: "<< end_time - start_time);
-
-    // Reset received recognized cloud and image
-    received_recognized_cloud_list_flag_ = false;
-    received_recognized_image_list_flag_ = false;
-
-    // reset object id
-    rgb_object_id_ = 100;
-    scene_segmentation_ros_->resetPclObjectId();
-
-    // clear recognized image and cloud list
-    recognized_image_list_.objects.clear();
-    recognized_cloud_list_.objects.clear();
-
-    scene_segmentation_ros_->resetCloudAccumulation();
-    // pub e_done
-    std_msgs::String event_out;
-    event_out.data = "e_done";
-    pub_event_out_.publish(event_out);
+    if (capture_view_)
+    {
+      capture_view_ = false;
+      std::lock_guard<std::mutex> lock(views_mutex_);
+      if (views_claimed_)
+      {
+        ROS_WARN("[multimodal_object_recognition_ros] A perception job is processing the views, dropping the view");
+        return;
+      }
+      addView(pointcloud_msg_, depth_msg_, image_msg_);
+      std_msgs::String event_out;
+      event_out.data = "e_view_added";
+      pub_event_out_.publish(event_out);
+      return;
+    }
+
+    // hand the frame over to the job worker, it is processed there
+    {
+      std::lock_guard<std::mutex> lock(capture_mutex_);
+      if (capture_state_ != CAPTURING)
+        return;
+      captured_cloud_ = pointcloud_msg_;
+      captured_depth_ = depth_msg_;
+      captured_deprojector_ = deprojector_;
+      captured_image_ = image_msg_;
+      capture_state_ = CAPTURE_DONE;
+    }
+    capture_cv_.notify_all();
   }
 }
 
-void MultimodalObjectRecognitionROS::preprocessPointCloud(const sensor_msgs::PointCloud2ConstPtr &cloud_msg)
+void MultimodalObjectRecognitionROS::updateCapture()
 {
-  sensor_msgs::PointCloud2 msg_transformed;
-  msg_transformed.header.frame_id = target_frame_id_;
-  if (!mpu::pointcloud::transformPointCloudMsg(tf_listener_, target_frame_id_, *cloud_msg, msg_transformed))
+  std::lock_guard<std::mutex> lock(capture_mutex_);
+  if (capture_state_ == CAPTURE_REQUESTED && !capture_view_)
+  {
+    capture_state_ = CAPTURING;
+    subscribeInputs();
+  }
+  else if (capture_state_ == CAPTURE_CANCELLED)
+  {
+    capture_state_ = CAPTURE_IDLE;
+    unsubscribeInputs();
+    pointcloud_msg_received_count_ = 0;
+    image_msg_received_count_ = 0;
+  }
+}
+
+void MultimodalObjectRecognitionROS::subscribeInputs()
+{
+  frame_selector_.reset();
+  // Synchronize callback
+  image_sub_ = new message_filters::Subscriber<sensor_msgs::Image> (nh_, "input_image_topic", 1);
+  if (depth_input_)
+  {
+    depth_sub_ = new message_filters::Subscriber<sensor_msgs::Image> (nh_, "input_depth_topic", 1);
+    camera_info_sub_ = new message_filters::Subscriber<sensor_msgs::CameraInfo> (nh_, "input_camera_info_topic", 1);
+    depth_sync_ = new message_filters::Synchronizer<depthSyncPolicy> (depthSyncPolicy(10), *image_sub_, *depth_sub_,
+                                                                      *camera_info_sub_);
+    depth_sync_->registerCallback(boost::bind(&MultimodalObjectRecognitionROS::synchronizeDepthCallback,
+                                              this, _1, _2, _3));
     return;
+  }
+  cloud_sub_ = new message_filters::Subscriber<sensor_msgs::PointCloud2> (nh_, "input_cloud_topic", 1);
+  msg_sync_ = new message_filters::Synchronizer<msgSyncPolicy> (msgSyncPolicy(10), *image_sub_, *cloud_sub_);
+  msg_sync_->registerCallback(boost::bind(&MultimodalObjectRecognitionROS::synchronizeCallback, this, _1, _2));
+}
 
-  pcl::PCLPointCloud2::Ptr pc2(new pcl::PCLPointCloud2);
-  pcl_conversions::toPCL(msg_transformed, *pc2);
-  pc2->header.frame_id = msg_transformed.header.frame_id;
+void MultimodalObjectRecognitionROS::unsubscribeInputs()
+{
+  if (image_sub_ && cloud_sub_)
+  {
+    image_sub_->unsubscribe();
+    cloud_sub_->unsubscribe();
+  }
+  if (image_sub_ && depth_sub_ && camera_info_sub_)
+  {
+    image_sub_->unsubscribe();
+    depth_sub_->unsubscribe();
+    camera_info_sub_->unsubscribe();
+  }
+  frame_selector_.reset();
+}
 
-  cloud_ = PointCloud::Ptr(new PointCloud);
-  pcl::fromPCLPointCloud2(*pc2, *cloud_);
+bool MultimodalObjectRecognitionROS::preprocessPointCloud(const sensor_msgs::PointCloud2ConstPtr &cloud_msg,
+                                                          PointCloud::Ptr &cloud)
+{
+  // the frame id of the cloud is replaced by pointcloud_source_frame_id, the message
+  // itself is shared with the camera driver and other subscribers and is not modified.
+  // The cloud stays organized, rgb detections are projected into it by pixel.
+  cloud = PointCloud::Ptr(new PointCloud);
+  return mpu::pointcloud::ingestPointCloudMsg(tf_listener_, target_frame_id_, *cloud_msg, *cloud, true,
+                                              pointcloud_source_frame_id_);
 }
 
-void MultimodalObjectRecognitionROS::segmentPointCloud(mas_perception_msgs::ObjectList &object_list,
-                             std::vector<PointCloud::Ptr> &clusters,
-                             std::vector<mpu::object::BoundingBox> boxes)
+bool MultimodalObjectRecognitionROS::preprocessDepth(const sensor_msgs::ImageConstPtr &depth_msg,
+                                                     const sensor_msgs::ImageConstPtr &image_msg,
+                                                     const DepthDeprojector::ConstPtr &deprojector,
+                                                     PointCloud::Ptr &cloud,
+                                                     std::shared_ptr<const DepthView> &depth_view)
 {
-  PointCloud::Ptr cloud(new PointCloud);
+  if (!deprojector)
+    return false;
+  std::shared_ptr<DepthView> view = std::make_shared<DepthView>();
+  ros::Time common_time;
+  try
+  {
+    const std::string &frame_id = pointcloud_source_frame_id_.empty() ? depth_msg->header.frame_id :
+                                                                         pointcloud_source_frame_id_;
+    tf::StampedTransform transform;
+    tf_listener_->getLatestCommonTime(target_frame_id_, frame_id, common_time, NULL);
+    tf_listener_->waitForTransform(target_frame_id_, frame_id, ros::Time::now(), ros::Duration(1.0));
+    tf_listener_->lookupTransform(target_frame_id_, frame_id, common_time, transform);
+    Eigen::Matrix4f matrix;
+    pcl_ros::transformAsMatrix(transform, matrix);
+    view->rotation = matrix.topLeftCorner<3, 3>();
+    view->translation = matrix.topRightCorner<3, 1>();
+  }
+  catch (tf::TransformException &ex)
+  {
+    ROS_ERROR("PCL transform error: %s", ex.what());
+    return false;
+  }
+
+  try
+  {
+    view->depth = cv_bridge::toCvShare(depth_msg);
+    // the color is only used if it is registered to the depth image
+    if (image_msg && image_msg->width == depth_msg->width && image_msg->height == depth_msg->height)
+    {
+      view->color = cv_bridge::toCvShare(image_msg, sensor_msgs::image_encodings::BGR8);
+    }
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+    return false;
+  }
+  view->deprojector = deprojector;
+  view->frame_id = target_frame_id_;
+  view->cloud_stride = depth_cloud_stride_;
+
+  // the segmentation only needs a coarse cloud, the rgb rois are deprojected at full resolution
+  cloud = PointCloud::Ptr(new PointCloud);
+  if (!deprojector->deproject(view->depth->image, view->color ? view->color->image : cv::Mat(), view->rotation,
+                              view->translation, cv::Rect(0, 0, deprojector->width(), deprojector->height()),
+                              depth_cloud_stride_, true, *cloud))
+  {
+    ROS_ERROR_STREAM("[multimodal_object_recognition_ros] Depth image " << depth_msg->width << "x"
+                     << depth_msg->height << " (" << depth_msg->encoding << ") does not match the camera info");
+    return false;
+  }
+  pcl_conversions::toPCL(common_time, cloud->header.stamp);
   cloud->header.frame_id = target_frame_id_;
-  scene_segmentation_ros_->getCloudAccumulation(cloud);
+  // the camera pose, the normals of the organized plane search are computed in the camera frame
+  cloud->sensor_origin_ << view->translation, 0.0f;
+  cloud->sensor_orientation_ = Eigen::Quaternionf(view->rotation);
+  depth_view = view;
+  return true;
+}
+
+bool MultimodalObjectRecognitionROS::preprocessFrame(PerceptionFrame &frame)
+{
+  if (frame.depth_msg)
+    return preprocessDepth(frame.depth_msg, frame.image_msg, frame.deprojector, frame.cloud, frame.depth_view);
+  return preprocessPointCloud(frame.pointcloud_msg, frame.cloud);
+}
+
+bool MultimodalObjectRecognitionROS::addView(const sensor_msgs::PointCloud2ConstPtr &cloud_msg,
+                                             const sensor_msgs::ImageConstPtr &depth_msg,
+                                             const sensor_msgs::ImageConstPtr &image_msg)
+{
+  PerceptionView view;
+  view.image_msg = image_msg;
+  if (depth_msg)
+  {
+    if (!preprocessDepth(depth_msg, image_msg, deprojector_, view.cloud, view.depth))
+      return false;
+  }
+  else if (!preprocessPointCloud(cloud_msg, view.cloud))
+  {
+    return false;
+  }
 
-  // if the cluster is centered,it looses the correct location of the object
-  scene_segmentation_ros_->segmentCloud(cloud, object_list, clusters, boxes,
-                      center_cluster_ = false, pad_cluster_, padded_cluster_size_);
+  size_t num_views = pipeline_->addView(view);
+  ROS_INFO_STREAM("[multimodal_object_recognition_ros] Accumulated " << num_views << " viewpoint(s)");
+  return true;
+}
+
+void MultimodalObjectRecognitionROS::resetViews()
+{
+  std::lock_guard<std::mutex> lock(views_mutex_);
+  if (views_claimed_)
+  {
+    reset_views_ = true;
+    return;
+  }
+  pipeline_->resetViews();
+}
+
+void MultimodalObjectRecognitionROS::claimViews(bool claim)
+{
+  std::lock_guard<std::mutex> lock(views_mutex_);
+  views_claimed_ = claim;
+  if (!claim && reset_views_)
+  {
+    reset_views_ = false;
+    pipeline_->resetViews();
+  }
+}
+
+bool MultimodalObjectRecognitionROS::segmentFrame(PerceptionFrame &frame)
+{
+  // transform pointcloud to the given frame_id, unless the scene store did already
+  if (!frame.cloud)
+  {
+    StageTimer timer;
+    if (!preprocessFrame(frame))
+      return false;
+    frame.stage_latency[STAGE_TRANSFORM] = timer.elapsed();
+  }
+
+  PointCloud::Ptr cloud_debug;
+  pipeline_->segment(frame, cloud_debug);
 
   // get workspace height
   std_msgs::Float64 workspace_height_msg;
-  workspace_height_msg.data = scene_segmentation_ros_->getWorkspaceHeight();
+  workspace_height_msg.data = frame.workspace_height;
   pub_workspace_height_.publish(workspace_height_msg);
 
-  if (debug_mode_)
+  if (debug_mode_ && cloud_debug)
   {
-    PointCloud::Ptr cloud_debug(new PointCloud);
-    cloud_debug = scene_segmentation_ros_->getCloudDebug();
-    sensor_msgs::PointCloud2 ros_pc2;
-    pcl::toROSMsg(*cloud_debug, ros_pc2);
-    ros_pc2.header.frame_id = target_frame_id_;
-    pub_debug_cloud_plane_.publish(ros_pc2);
+    pub_debug_cloud_plane_.publish([&] {
+      sensor_msgs::PointCloud2 ros_pc2;
+      pcl::toROSMsg(*cloud_debug, ros_pc2);
+      ros_pc2.header.frame_id = target_frame_id_;
+      return ros_pc2;
+    });
   }
+  return true;
 }
 
-void MultimodalObjectRecognitionROS::recognizeCloudAndImage()
+void MultimodalObjectRecognitionROS::saveFrame(PerceptionFrame &frame)
 {
-  mas_perception_msgs::ObjectList cloud_object_list;
-  std::vector<PointCloud::Ptr> clusters_3d;
-  std::vector<mpu::object::BoundingBox> boxes;
+  // The samples are written by the dataset writer thread
+  std::string stamp = std::to_string(frame.stamp.toSec());
 
-  segmentPointCloud(cloud_object_list, clusters_3d, boxes);
-
-  if (data_collection_)
+  // Save PCD (point cloud) cluster 
+  for (size_t i = 0; i < frame.clusters_3d.size(); i++)
   {
-    std::string filename;
-    
-    // Save PCD (point cloud) cluster 
-    for (auto& cluster : clusters_3d)
-    {
-      filename = "";
-      filename.append("pcd_cluster_");
-      filename.append(std::to_string(ros::Time::now().toSec()));
-      mpu::object::savePcd(cluster, logdir_, filename);
-      ROS_INFO_STREAM("\033[1;35mSaving point cloud to \033[0m" << logdir_);
-    }
-    
-    // Save raw image
-    cv_bridge::CvImagePtr raw_cv_image;
-    if (mpu::object::getCVImage(image_msg_, raw_cv_image))
-    {
-      std::string filename = "";
-      filename = "";
-      filename.append("rgb_raw_");
-      filename.append(std::to_string(ros::Time::now().toSec()));
-      mpu::object::saveCVImage(raw_cv_image, logdir_, filename);
-      ROS_INFO_STREAM("Image:" << filename << " saved to " << logdir_);
-    }
-    else
-    {
-      ROS_ERROR("Cannot generate cv image...");
-    }
-
-    return;
+    dataset_writer_->savePointCloud(frame.clusters_3d[i],
+                                    "pcd_cluster_" + stamp + "_" + std::to_string(i));
   }
 
-  // Publish 3D object cluster for recognition
-  if (!cloud_object_list.objects.empty() && enable_pc_recognizer_)
+  // Save raw image
+  dataset_writer_->saveImage(frame.image_msg, "rgb_raw_" + stamp);
+
+  DatasetWriter::Stats stats = dataset_writer_->getStats();
+  ROS_INFO_STREAM("\033[1;35mDataset: \033[0m" << stats.written << " samples, "
+                  << stats.bytes_written / (1024 * 1024) << " MB written to " << logdir_
+                  << ", queued: " << stats.queue_size << ", dropped: " << stats.dropped
+                  << ", over budget: " << stats.over_budget << ", failed: " << stats.failed);
+}
+
+mas_perception_msgs::ObjectList MultimodalObjectRecognitionROS::detectImage(const sensor_msgs::ImageConstPtr &image)
+{
+  mas_perception_msgs::ObjectList detections;
+  cv_bridge::CvImageConstPtr cv_image;
+  try
   {
-    ROS_INFO_STREAM("Publishing clouds for recognition");
-    pub_cloud_to_recognizer_.publish(cloud_object_list);
+    cv_image = cv_bridge::toCvShare(image, sensor_msgs::image_encodings::BGR8);
   }
-
-  // Pub Image to recognizer
-  mas_perception_msgs::ImageList image_list;
-  image_list.images.resize(1);
-  image_list.images[0] = *image_msg_;
-  if (!image_list.images.empty() && enable_rgb_recognizer_)
+  catch (cv_bridge::Exception &e)
   {
-    ROS_INFO_STREAM("Publishing images for recognition");
-    pub_image_to_recognizer_.publish(image_list);
+    ROS_ERROR("[RGB] cv_bridge exception: %s", e.what());
+    return detections;
   }
-  ROS_INFO_STREAM("Waiting for message from Cloud and Image recognizer");
-  // loop till it received the message from the 3d and rgb recognition
-  int loop_rate_hz = 30;
-  int timeout_wait = 10;  // secs
-  ros::Rate loop_rate(loop_rate_hz);
-  int loop_rate_count = 0;
-  if (cloud_object_list.objects.size() > 0 && enable_pc_recognizer_)
+  rgb_detector_->detect(cv_image->image, image->header, detections);
+  return detections;
+}
+
+void MultimodalObjectRecognitionROS::requestRecognition(PerceptionFrame &frame)
+{
+  // Publish 3D object cluster and image for recognition. Both recognizers run
+  // concurrently, the deadlines are counted from the time the requests are sent.
+  frame.request_time = PerceptionFrame::Clock::now();
+  if (!frame.cloud_object_list.objects.empty() && enable_pc_recognizer_)
   {
-    ROS_INFO_STREAM("[Cloud] Waiting message from PCL recognizer node");
-    while (!received_recognized_cloud_list_flag_)
+    // Label the clusters recognized recently from the cache, only the misses are sent
+    const size_t num_clusters = frame.cloud_object_list.objects.size();
+    frame.recognized_cloud_list.objects = frame.cloud_object_list.objects;
+    frame.cloud_fingerprints.assign(num_clusters, ClusterFingerprint());
+    frame.cloud_labelled.assign(num_clusters, false);
+    // the cache is keyed in the fixed frame, a cluster at the same place relative to the robot
+    // at another workstation is another object. Without the robot pose the fingerprints are left
+    // empty, they neither match nor are inserted.
+    PerceivedObjectStore::RobotPose robot_pose;
+    const bool use_cache = recognition_cache_.isEnabled() && lookupRobotPose(frame.stamp, robot_pose);
+    const Eigen::Affine3f to_fixed_frame = Eigen::Translation3f(robot_pose.x, robot_pose.y, 0.0f) *
+                                           Eigen::AngleAxisf(robot_pose.yaw, Eigen::Vector3f::UnitZ());
+    mas_perception_msgs::ObjectList request_list;
+    for (size_t i = 0; i < num_clusters; i++)
     {
-      loop_rate_count += 1;
-      ros::spinOnce();
-      loop_rate.sleep();
-      if (received_recognized_cloud_list_flag_ == true)
+      if (use_cache && i < frame.clusters_3d.size())
       {
-        ROS_INFO("[Cloud] Received %d objects from pcl recognizer", recognized_cloud_list_.objects.size());
+        frame.cloud_fingerprints[i] = ClusterFingerprint(*frame.clusters_3d[i]);
+        frame.cloud_fingerprints[i].transform(to_fixed_frame);
       }
-      if (loop_rate_count > loop_rate_hz * timeout_wait)
+      RecognitionCache::Label label;
+      if (recognition_cache_.lookup(frame.cloud_fingerprints[i], label))
       {
-        received_recognized_cloud_list_flag_ = false;
-        ROS_WARN("[Cloud] No message received from PCL recognizer. ");
-        break;
+        frame.recognized_cloud_list.objects[i].name = label.name;
+        frame.recognized_cloud_list.objects[i].probability = label.probability;
+        frame.cloud_labelled[i] = true;
+      }
+      else
+      {
+        frame.cloud_request_indices.push_back(i);
+        request_list.objects.push_back(frame.cloud_object_list.objects[i]);
+        mas_perception_msgs::Object &request = request_list.objects.back();
+        sensor_msgs::PointCloud2 handle;
+        if (cluster_transport_.isOpen() && i < frame.clusters_3d.size() && !request.views.empty() &&
+            cluster_transport_.encode(*frame.clusters_3d[i], request.views[0].point_cloud.header, handle))
+        {
+          request.views[0].point_cloud = handle;
+        }
       }
     }
+    ROS_INFO_STREAM("[Cloud] " << num_clusters - request_list.objects.size() << " of " << num_clusters
+                    << " clusters labelled from the recognition cache");
+    if (!request_list.objects.empty())
+    {
+      ROS_INFO_STREAM("Publishing clouds for recognition");
+      frame.cloud_request_id = cloud_recognizer_client_->request(request_list, frame.cloud_reply);
+    }
   }
 
-  // Merge recognized_cloud_list and rgb_object_list
-  mas_perception_msgs::ObjectList combined_object_list;
-  if (!recognized_cloud_list_.objects.empty())
-  {
-    combined_object_list.objects.insert(combined_object_list.objects.end(),
-                    recognized_cloud_list_.objects.begin(),
-                    recognized_cloud_list_.objects.end());
-  }
-
-  loop_rate_count = 0;
-  timeout_wait = 3;  //  secs
-  if (image_list.images.size() > 0)
+  // Pub Image to recognizer, one request per view so that every detection
+  // can be projected into the cloud of the view it was found in
+  if (enable_rgb_recognizer_)
   {
-  ROS_INFO_STREAM("[RGB] Waiting message from RGB recognizer node");
-    while (!received_recognized_image_list_flag_)
+    // images cropped to the workspace and downscaled, if enabled
+    pipeline_->cropRGBRequests(frame);
+    ROS_INFO_STREAM("Publishing " << frame.views.size() << " image(s) for recognition");
+    for (auto &view : frame.views)
     {
-      loop_rate_count += 1;
-      ros::spinOnce();
-      loop_rate.sleep();
-      if (received_recognized_image_list_flag_ == true)
-      {
-        ROS_INFO("[RGB] Received %d objects from rgb recognizer", (int)(recognized_image_list_.objects.size()));
-      }
-      if (loop_rate_count > loop_rate_hz * timeout_wait)
+      if (rgb_detector_)
       {
-        received_recognized_image_list_flag_ = false;
-        ROS_WARN("[RGB] No message received from RGB recognizer. ");
-        break;
+        // detected in a task of its own, in parallel with the pc recognizer
+        sensor_msgs::ImageConstPtr image = view.request_image ? sensor_msgs::ImageConstPtr(view.request_image)
+                                                              : view.image_msg;
+        view.image_in_process = true;
+        view.image_reply = std::async(std::launch::async, [this, image] { return detectImage(image); });
+        continue;
       }
+      mas_perception_msgs::ImageList image_list;
+      image_list.images.resize(1);
+      image_list.images[0] = view.request_image ? *view.request_image : *view.image_msg;
+      view.image_request_id = image_recognizer_client_->request(image_list, view.image_reply);
     }
   }
-  // Reset recognition callback flags
-  received_recognized_cloud_list_flag_ = false;
-  received_recognized_image_list_flag_ = false;
-
-  mas_perception_msgs::ObjectList rgb_object_list;
-  mas_perception_msgs::BoundingBoxList bounding_boxes;
-  std::vector<PointCloud::Ptr> clusters_2d;
+}
 
-  cv_bridge::CvImagePtr cv_image;
-  if (recognized_image_list_.objects.size() > 0)
+MultimodalObjectRecognitionROS::RecognizerRequests
+MultimodalObjectRecognitionROS::pendingRequests(const PerceptionFrame &frame) const
+{
+  RecognizerRequests requests;
+  requests.cloud_request_id = frame.cloud_request_id;
+  for (const auto &view : frame.views)
   {
-    try
-    {
-      cv_image = cv_bridge::toCvCopy(image_msg_, sensor_msgs::image_encodings::BGR8);
-    }
-    catch (cv_bridge::Exception& e)
+    if (view.image_request_id > 0)
     {
-      ROS_ERROR("cv_bridge exception: %s", e.what());
-      return;
+      requests.image_request_ids.push_back(view.image_request_id);
     }
+  }
+  return requests;
+}
 
-    bounding_boxes.bounding_boxes.resize(recognized_image_list_.objects.size());
-    rgb_object_list.objects.resize(recognized_image_list_.objects.size());
+void MultimodalObjectRecognitionROS::cancelRequests(const RecognizerRequests &requests)
+{
+  if (requests.cloud_request_id > 0)
+  {
+    cloud_recognizer_client_->cancel(requests.cloud_request_id);
+  }
+  for (uint32_t id : requests.image_request_ids)
+  {
+    image_recognizer_client_->cancel(id);
+  }
+}
 
-    for (int i = 0; i < recognized_image_list_.objects.size(); i++)
+void MultimodalObjectRecognitionROS::recognizeCloudAndImage(PerceptionFrame &frame)
+{
+  typedef PerceptionFrame::Clock Clock;
+
+  // Wait for the rgb recognizer first, so that the ROI extraction and pose estimation
+  // of the rgb detections overlap with the (usually slower) pc recognizer
+  const Clock::time_point rgb_deadline = frame.request_time +
+      std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(rgb_recognizer_timeout_));
+  StageTimer timer;
+  for (size_t v = 0; v < frame.views.size(); v++)
+  {
+    PerceptionView &view = frame.views[v];
+    if (view.image_request_id == 0 && !view.image_in_process)
+      continue;
+    ROS_INFO_STREAM("[RGB] Waiting message from RGB recognizer node");
+    mas_perception_msgs::ObjectList view_image_list;
+    bool received;
+    if (view.image_in_process)
     {
-      mas_perception_msgs::Object object = recognized_image_list_.objects[i];
-      // Check qualitative info of the object
-      if (round_objects_.count(recognized_image_list_.objects[i].name))
+      // a detection which misses the deadline still finishes, the frame waits for it when released
+      received = view.image_reply.wait_until(rgb_deadline) == std::future_status::ready;
+      if (received)
       {
-        object.shape.shape = object.shape.SPHERE;
+        view_image_list = view.image_reply.get();
       }
-      else
+    }
+    else
+    {
+      received = image_recognizer_client_->waitForReply(view.image_request_id, view.image_reply,
+                                                        rgb_deadline, view_image_list);
+    }
+    if (received)
+    {
+      ROS_INFO("[RGB] Received %d objects from rgb recognizer", (int)(view_image_list.objects.size()));
+      // the ROI extraction needs the detections in the full image
+      if (view.request_image)
       {
-        object.shape.shape = object.shape.OTHER;
+        for (auto &object : view_image_list.objects)
+        {
+          view.image_crop.toFullFrame(object.roi);
+        }
       }
-      // Get ROI
-      sensor_msgs::RegionOfInterest roi_2d = object.roi;
-      const cv::Rect2d rect2d(roi_2d.x_offset, roi_2d.y_offset, roi_2d.width, roi_2d.height);
+      frame.recognized_image_list.objects.insert(frame.recognized_image_list.objects.end(),
+                                                 view_image_list.objects.begin(),
+                                                 view_image_list.objects.end());
+      frame.image_detection_views.insert(frame.image_detection_views.end(),
+                                         view_image_list.objects.size(), v);
+    }
+    else
+    {
+      ROS_WARN("[RGB] No message received from RGB recognizer. ");
+    }
+  }
+  if (!frame.views.empty() && (frame.views.front().image_request_id > 0 || frame.views.front().image_in_process))
+  {
+    frame.stage_latency[STAGE_RGB_RECOGNIZER_WAIT] = timer.elapsed();
+  }
+
+  pipeline_->processRGBDetections(frame);
+
+  // ************************************************
+  // Publish filtered point cloud from RGB recognizer
+  // ************************************************
+  for (const auto &filtered_rgb_pointcloud : frame.filtered_rgb_clouds)
+  {
+    if (!filtered_rgb_pointcloud)
+      continue;
+    pub_filtered_rgb_cloud_plane_.publish([&] {
+      sensor_msgs::PointCloud2 ros_filtered_rgb_pointcloud;
+      pcl::toROSMsg(*filtered_rgb_pointcloud, ros_filtered_rgb_pointcloud);
+      ros_filtered_rgb_pointcloud.header.frame_id = target_frame_id_;
+      return ros_filtered_rgb_pointcloud;
+    });
+  }
 
-      if (debug_mode_)
+  if (frame.cloud_request_id > 0)
+  {
+    ROS_INFO_STREAM("[Cloud] Waiting message from PCL recognizer node");
+    timer.restart();
+    mas_perception_msgs::ObjectList reply_list;
+    if (cloud_recognizer_client_->waitForReply(frame.cloud_request_id, frame.cloud_reply,
+          frame.request_time + std::chrono::duration_cast<Clock::duration>(
+              std::chrono::duration<double>(pc_recognizer_timeout_)),
+          reply_list))
+    {
+      ROS_INFO("[Cloud] Received %d objects from pcl recognizer", (int)(reply_list.objects.size()));
+      if (reply_list.objects.size() != frame.cloud_request_indices.size())
       {
-        cv::Point pt1;
-        cv::Point pt2;
-
-        pt1.x = roi_2d.x_offset;
-        pt1.y = roi_2d.y_offset;
-        pt2.x = roi_2d.x_offset + roi_2d.width;
-        pt2.y = roi_2d.y_offset + roi_2d.height;
-
-        // draw bbox
-        cv::rectangle(cv_image->image, pt1, pt2, cv::Scalar(0, 255, 0), 1, 8, 0);
-        // add label
-        cv::putText(cv_image->image, object.name, cv::Point(pt1.x, pt2.y),
-              cv::FONT_HERSHEY_SIMPLEX, 0.3, cv::Scalar(0, 255, 0), 1);
+        ROS_WARN("[Cloud] Sent %d clusters to the pcl recognizer, received %d objects",
+                 (int)frame.cloud_request_indices.size(), (int)reply_list.objects.size());
       }
-      // Remove large 2d misdetected bbox (misdetection)
-      double len_diag = sqrt(powf(roi_2d.width, 2) + powf(roi_2d.height, 2));
-
-      if (len_diag > rgb_bbox_min_diag_ && len_diag < rgb_bbox_max_diag_)
+      const std::shared_ptr<const ObjectCatalogue> catalogue = pipeline_->getObjectCatalogue();
+      // the recognizer keeps the order of the request
+      for (size_t k = 0; k < reply_list.objects.size() && k < frame.cloud_request_indices.size(); k++)
       {
-        PointCloud::Ptr cloud_roi(new PointCloud);
-        bool getROISuccess = mpu::pointcloud::getPointCloudROI(roi_2d, cloud_, cloud_roi, 
-                                                         rgb_roi_adjustment_, 
-                                                         rgb_cluster_remove_outliers_);
-        // ToDo: Filter big objects from 2d proposal, if the height is less than 3 mm
-        // pcl::PointXYZRGB min_pt;
-        // pcl::PointXYZRGB max_pt;
-        // pcl::getMinMax3D(*cloud_roi, min_pt, max_pt);
-        // float obj_height = max_pt.z - scene_segmentation_ros_->getWorkspaceHeight();
-        
-        if (getROISuccess)
-        {
-          sensor_msgs::PointCloud2 ros_pc2;
-          pcl::PCLPointCloud2::Ptr pc2(new pcl::PCLPointCloud2);
-          pcl::toPCLPointCloud2(*cloud_roi, *pc2);
-          pcl_conversions::fromPCL(*pc2, ros_pc2);
-          ros_pc2.header.frame_id = target_frame_id_;
-          ros_pc2.header.stamp = ros::Time::now();
-
-          rgb_object_list.objects[i].views.resize(1);
-          rgb_object_list.objects[i].views[0].point_cloud = ros_pc2;
-
-          clusters_2d.push_back(cloud_roi);
-          // Get pose
-          geometry_msgs::PoseStamped pose;
-
-          // ************************************************
-          // Publish filtered point cloud from RGB recognizer
-          // ************************************************
-          
-          PointCloud filtered_rgb_pointcloud;
-          filtered_rgb_pointcloud = mpu::object::estimatePose(cloud_roi, pose, object.shape.shape,
-                                                              rgb_cluster_filter_limit_min_,
-                                                              rgb_cluster_filter_limit_max_);
-
-          PointT min_pt;
-          PointT max_pt;
-          pcl::getMinMax3D(*cloud_roi, min_pt, max_pt);
-
-          rgb_object_list.objects[i].dimensions.vector.z = max_pt.z - min_pt.z;
-          ROS_INFO("[RGB Object Height] Object %s length: %f", object.name.c_str(), rgb_object_list.objects[i].dimensions.vector.z);
-
-          if (max_pt.z > 0.09)
-          {
-            ROS_INFO("[RGB Object Height] Object %s length is greater than 9cm: %f", object.name.c_str(), max_pt.z);
-          }
-
-          sensor_msgs::PointCloud2 ros_filtered_rgb_pointcloud;
-          pcl::toROSMsg(filtered_rgb_pointcloud, ros_filtered_rgb_pointcloud);
-          ros_filtered_rgb_pointcloud.header.frame_id = target_frame_id_;
-
-          pub_filtered_rgb_cloud_plane_.publish(ros_filtered_rgb_pointcloud);
-
-          // To visualize the filtered point cloud, sleep for 3 seconds after every point cloud
-          // ros::Duration(3.0).sleep();
-
-          //*********************************
-
-          // Transform pose
-          std::string frame_id = cloud_->header.frame_id;
-          pose.header.stamp = ros::Time::now();
-          pose.header.frame_id = frame_id;
-          if (frame_id != target_frame_id_)
-          {
-            mpu::object::transformPose(tf_listener_, target_frame_id_,
-                           pose, rgb_object_list.objects[i].pose);
-          }
-          else
-          {
-            rgb_object_list.objects[i].pose = pose;
-          }
-          rgb_object_list.objects[i].probability = recognized_image_list_.objects[i].probability;
-          rgb_object_list.objects[i].database_id = rgb_object_id_;
-          rgb_object_list.objects[i].name = recognized_image_list_.objects[i].name;
-        }
-        else
+        const size_t i = frame.cloud_request_indices[k];
+        // only the label is taken, the cloud of the reply may be a shared memory handle
+        frame.recognized_cloud_list.objects[i].name = reply_list.objects[k].name;
+        frame.recognized_cloud_list.objects[i].probability = reply_list.objects[k].probability;
+        frame.cloud_labelled[i] = true;
+        // unknown objects are recognized again next time
+        if (catalogue->empty() || catalogue->find(reply_list.objects[k].name) != ObjectCatalogue::UNKNOWN_ID)
         {
-          ROS_DEBUG("[RGB] DECOY");
-          rgb_object_list.objects[i].name = "DECOY";
-          rgb_object_list.objects[i].database_id = rgb_object_id_;
-        
+          RecognitionCache::Label label;
+          label.name = reply_list.objects[k].name;
+          label.probability = reply_list.objects[k].probability;
+          recognition_cache_.insert(frame.cloud_fingerprints[i], label);
         }
       }
-      else
+    }
+    else
+    {
+      ROS_WARN("[Cloud] No message received from PCL recognizer. ");
+    }
+    frame.stage_latency[STAGE_PC_RECOGNIZER_WAIT] = timer.elapsed();
+  }
+
+  // Keep the clusters labelled by the recognizer or the cache, in cluster order
+  if (!frame.cloud_labelled.empty())
+  {
+    mas_perception_msgs::ObjectList &recognized_cloud_list = frame.recognized_cloud_list;
+    size_t num_labelled = 0;
+    for (size_t i = 0; i < recognized_cloud_list.objects.size(); i++)
+    {
+      if (frame.cloud_labelled[i])
       {
-        ROS_DEBUG("[RGB] DECOY");
-        rgb_object_list.objects[i].name = "DECOY";
-        rgb_object_list.objects[i].database_id = rgb_object_id_;
+        recognized_cloud_list.objects[num_labelled++] = recognized_cloud_list.objects[i];
       }
-      rgb_object_id_++;
     }
-    combined_object_list.objects.insert(combined_object_list.objects.end(),
-                    rgb_object_list.objects.begin(),
-                    rgb_object_list.objects.end());
+    recognized_cloud_list.objects.resize(num_labelled);
+  }
+
+  // Merge recognized_cloud_list and rgb_object_list, objects seen by both recognizers are fused
+  int num_fused = pipeline_->fuseObjects(frame);
+  if (num_fused > 0)
+  {
+    ROS_INFO("Fused %d objects recognized by both pc and rgb recognizers", num_fused);
+  }
+}
+
+void MultimodalObjectRecognitionROS::drawDetections(PerceptionFrame &frame)
+{
+  cv_bridge::CvImagePtr &cv_image = frame.debug_image;
+  try
+  {
+    cv_image = cv_bridge::toCvCopy(frame.image_msg, sensor_msgs::image_encodings::BGR8);
+  }
+  catch (cv_bridge::Exception& e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+    return;
+  }
+
+  const mas_perception_msgs::ObjectList &recognized_image_list = frame.recognized_image_list;
+  for (int i = 0; i < recognized_image_list.objects.size(); i++)
+  {
+    // the debug image shows the current view only
+    const PerceptionView &view = frame.views[frame.image_detection_views[i]];
+    if (view.image_msg != frame.image_msg)
+      continue;
+    const mas_perception_msgs::Object &object = recognized_image_list.objects[i];
+    const sensor_msgs::RegionOfInterest &roi_2d = object.roi;
+    cv::Point pt1;
+    cv::Point pt2;
+
+    pt1.x = roi_2d.x_offset;
+    pt1.y = roi_2d.y_offset;
+    pt2.x = roi_2d.x_offset + roi_2d.width;
+    pt2.y = roi_2d.y_offset + roi_2d.height;
+
+    // draw bbox
+    cv::rectangle(cv_image->image, pt1, pt2, cv::Scalar(0, 255, 0), 1, 8, 0);
+    // add label
+    cv::putText(cv_image->image, object.name, cv::Point(pt1.x, pt2.y),
+          cv::FONT_HERSHEY_SIMPLEX, 0.3, cv::Scalar(0, 255, 0), 1);
   }
+}
 
+void MultimodalObjectRecognitionROS::publishFrame(PerceptionFrame &frame, bool publish_objects)
+{
+  mas_perception_msgs::ObjectList &combined_object_list = frame.combined_object_list;
+  StageTimer timer;
   if (!combined_object_list.objects.empty())
   {
-    if (enable_roi_)
+    // Adjust RPY to make pose flat, adjust container pose
+    // Adjust Axis and Bolt pose
+    pipeline_->adjustObjectPose(combined_object_list, frame.workspace_height);
+    frame.stage_latency[STAGE_ADJUST_POSE] = timer.elapsed();
+    timer.restart();
+    if (continuous_mode_)
     {
-      for (int i = 0; i < combined_object_list.objects.size(); i++)
+      // Stamp the objects with their frame so that consumers can pick the most recent result
+      for (auto &object : combined_object_list.objects)
       {
-        double current_object_pose_x = combined_object_list.objects[i].pose.pose.position.x;
-        if (current_object_pose_x < roi_base_link_to_laser_distance_ ||
-            current_object_pose_x > roi_max_object_pose_x_to_base_link_)
-          /* combined_object_list.objects[i].pose.pose.position.z < scene_segmentation_ros_ */
-          /* ->object_height_above_workspace_ - 0.05) */
-        {
-          ROS_WARN_STREAM("This object " << combined_object_list.objects[i].name << " out of RoI");
-          combined_object_list.objects[i].name = "DECOY";
-        }
+        object.pose.header.stamp = frame.stamp;
       }
     }
-    // Adjust RPY to make pose flat, adjust container pose
-    // Adjust Axis and Bolt pose
-    adjustObjectPose(combined_object_list);
-    // Publish object to object list merger
-    publishObjectList(combined_object_list);
+    // Publish object to object list merger, action jobs may only return it in their result
+    prepareObjectList(combined_object_list);
+    if (publish_objects)
+    {
+      publishObjectList(combined_object_list);
+    }
   }
   else
   {
@@ -529,17 +920,21 @@ void MultimodalObjectRecognitionROS::recognizeCloudAndImage()
   if (debug_mode_)
   {
     ROS_WARN_STREAM("Debug mode: publishing object information");
-    publishDebug(combined_object_list, clusters_3d, clusters_2d);
+    publishDebug(frame);
 
     ros::Time time_now = ros::Time::now();
 
-    // Save debug image
-    if(recognized_image_list_.objects.size() > 0)
+    // Save debug image, drawn only now that the frame is known to be published
+    if (frame.recognized_image_list.objects.size() > 0)
+    {
+      drawDetections(frame);
+    }
+    if(frame.recognized_image_list.objects.size() > 0 && frame.debug_image)
     {
       std::string filename = "";
       filename.append("rgb_debug_");
       filename.append(std::to_string(time_now.toSec()));
-      mpu::object::saveCVImage(cv_image, logdir_, filename);
+      mpu::object::saveCVImage(frame.debug_image, logdir_, filename);
       ROS_INFO_STREAM("Image:" << filename << " saved to " << logdir_);
     }
     else
@@ -548,7 +943,7 @@ void MultimodalObjectRecognitionROS::recognizeCloudAndImage()
     }
     // Save raw image
     cv_bridge::CvImagePtr raw_cv_image;
-    if (mpu::object::getCVImage(image_msg_, raw_cv_image))
+    if (mpu::object::getCVImage(frame.image_msg, raw_cv_image))
     {
       std::string filename = "";
       filename = "";
@@ -563,7 +958,7 @@ void MultimodalObjectRecognitionROS::recognizeCloudAndImage()
     }
 
     // Save pointcloud debug
-    for (auto& cluster : clusters_3d)
+    for (auto& cluster : frame.clusters_3d)
     {
       std::string filename = "";
       filename = "";
@@ -573,34 +968,587 @@ void MultimodalObjectRecognitionROS::recognizeCloudAndImage()
       ROS_INFO_STREAM("Point cloud:" << filename << " saved to " << logdir_);
     }
   }
+  frame.stage_latency[STAGE_PUBLISH] = timer.elapsed();
+}
+
+void MultimodalObjectRecognitionROS::recordLatency(PerceptionFrame &frame)
+{
+  frame.stage_latency[STAGE_TOTAL] = frame.timer.elapsed();
+
+  diagnostic_msgs::DiagnosticStatus status;
+  status.level = diagnostic_msgs::DiagnosticStatus::OK;
+  status.name = "multimodal_object_recognition/stage_latency";
+  status.hardware_id = std::to_string(frame.stamp.toSec());
+  status.message = "Stage latencies in seconds";
+  std::lock_guard<std::mutex> lock(latency_mutex_);
+  for (int i = 0; i < NUM_PERCEPTION_STAGES; i++)
+  {
+    if (frame.stage_latency[i] < 0.0)
+      continue;
+    stage_latency_windows_[i].add(frame.stage_latency[i]);
+    diagnostic_msgs::KeyValue value;
+    value.key = perceptionStageName(i);
+    value.value = std::to_string(frame.stage_latency[i]);
+    status.values.push_back(value);
+  }
+  pub_stage_latency_.publish(status);
+}
+
+void MultimodalObjectRecognitionROS::latencyDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat)
+{
+  std::lock_guard<std::mutex> lock(latency_mutex_);
+  const LatencyWindow &total = stage_latency_windows_[STAGE_TOTAL];
+  if (total.count() == 0)
+  {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "No frames processed yet");
+    return;
+  }
+  stat.summaryf(diagnostic_msgs::DiagnosticStatus::OK, "Total latency p50 %.3f s, p99 %.3f s",
+                total.percentile(50), total.percentile(99));
+  for (int i = 0; i < NUM_PERCEPTION_STAGES; i++)
+  {
+    const LatencyWindow &window = stage_latency_windows_[i];
+    if (window.count() == 0)
+      continue;
+    const std::string name = perceptionStageName(i);
+    stat.add(name + " p50", window.percentile(50));
+    stat.add(name + " p95", window.percentile(95));
+    stat.add(name + " p99", window.percentile(99));
+  }
+  stat.add("frames", total.count());
+}
+
+void MultimodalObjectRecognitionROS::startPipeline()
+{
+  input_frames_.reset(new FrameQueue(continuous_queue_size_, true));
+  segmented_frames_.reset(new FrameQueue(1, false));
+  recognized_frames_.reset(new FrameQueue(1, false));
+  {
+    std::lock_guard<std::mutex> lock(pipeline_requests_mutex_);
+    pipeline_stopping_ = false;
+    pipeline_requests_.clear();
+  }
+  continuous_mode_ = true;
+  segmentation_thread_ = std::thread(&MultimodalObjectRecognitionROS::segmentationStage, this);
+  recognition_thread_ = std::thread(&MultimodalObjectRecognitionROS::recognitionStage, this);
+  publish_thread_ = std::thread(&MultimodalObjectRecognitionROS::publishStage, this);
+}
+
+void MultimodalObjectRecognitionROS::stopPipeline()
+{
+  if (!continuous_mode_)
+    return;
+  continuous_mode_ = false;
+  input_frames_->close();
+  segmented_frames_->close();
+  recognized_frames_->close();
+  // no stage sends a request once the flag is set, the pending requests of the pipeline are
+  // canceled so that a stage waiting for a reply returns at once
+  {
+    std::lock_guard<std::mutex> lock(pipeline_requests_mutex_);
+    pipeline_stopping_ = true;
+    for (const auto &requests : pipeline_requests_)
+    {
+      cancelRequests(requests.second);
+    }
+    pipeline_requests_.clear();
+  }
+  segmentation_thread_.join();
+  recognition_thread_.join();
+  publish_thread_.join();
+}
+
+void MultimodalObjectRecognitionROS::segmentationStage()
+{
+  PerceptionFrame::Ptr frame;
+  while (input_frames_->pop(frame))
+  {
+    if (pipeline_stopping_ || !segmentFrame(*frame))
+      continue;
+    {
+      std::lock_guard<std::mutex> lock(pipeline_requests_mutex_);
+      if (pipeline_stopping_)
+        break;
+      requestRecognition(*frame);
+      pipeline_requests_[frame.get()] = pendingRequests(*frame);
+    }
+    segmented_frames_->push(frame);
+  }
+}
+
+void MultimodalObjectRecognitionROS::recognitionStage()
+{
+  PerceptionFrame::Ptr frame;
+  while (segmented_frames_->pop(frame))
+  {
+    // the frames left in the queues are dropped when the pipeline stops
+    if (!pipeline_stopping_)
+    {
+      recognizeCloudAndImage(*frame);
+      recognized_frames_->push(frame);
+    }
+    std::lock_guard<std::mutex> lock(pipeline_requests_mutex_);
+    pipeline_requests_.erase(frame.get());
+  }
+}
+
+void MultimodalObjectRecognitionROS::publishStage()
+{
+  PerceptionFrame::Ptr frame;
+  while (recognized_frames_->pop(frame))
+  {
+    if (pipeline_stopping_)
+      continue;
+    publishFrame(*frame);
+    recordLatency(*frame);
+    ROS_INFO_STREAM("[Continuous] Published frame " << frame->stamp << ", latency: "
+                    << frame->stage_latency[STAGE_TOTAL]);
+  }
+}
+
+uint32_t MultimodalObjectRecognitionROS::submitJob(const PerceptionJobPtr &job, int priority)
+{
+  std::lock_guard<std::mutex> lock(jobs_mutex_);
+  // the id is set before the worker can pop the job
+  job->id = job_queue_.push(job, priority);
+  if (job->id == 0)
+    return 0;
+  if (job->has_goal)
+  {
+    goal_jobs_[job->goal.getGoalID().id] = job;
+  }
+  ROS_INFO_STREAM("[multimodal_object_recognition_ros] Queued perception job " << job->id
+                  << " with priority " << priority);
+  return job->id;
+}
+
+bool MultimodalObjectRecognitionROS::jobsPending()
+{
+  std::lock_guard<std::mutex> lock(jobs_mutex_);
+  return running_job_ || job_queue_.size() > 0;
+}
+
+void MultimodalObjectRecognitionROS::goalCallback(RecognizeObjectsServer::GoalHandle goal)
+{
+  if (continuous_mode_)
+  {
+    mir_object_recognition::RecognizeObjectsResult result;
+    goal.setRejected(result, "Continuous perception is running");
+    return;
+  }
+  const mir_object_recognition::RecognizeObjectsGoalConstPtr request = goal.getGoal();
+  PerceptionJobPtr job = std::make_shared<PerceptionJob>();
+  job->capture_delay = std::max(0.0, request->capture_delay);
+  job->publish_objects = request->publish_objects;
+  job->workstation = request->workstation;
+  if (!request->workspace_prior.points.empty())
+  {
+    std::shared_ptr<SceneSegmentation::WorkspacePrior> prior = std::make_shared<SceneSegmentation::WorkspacePrior>();
+    for (const auto &point : request->workspace_prior.points)
+    {
+      prior->plane_height += point.z;
+      prior->polygon.push_back(Eigen::Vector2f(point.x, point.y));
+    }
+    prior->plane_height /= request->workspace_prior.points.size();
+    job->workspace_prior = prior;
+  }
+  else if (workspace_priors_.count(job->workstation) > 0)
+  {
+    job->workspace_prior = workspace_priors_[job->workstation];
+  }
+  job->has_goal = true;
+  job->goal = goal;
+  goal.setAccepted();
+  if (submitJob(job, request->priority) == 0)
+  {
+    mir_object_recognition::RecognizeObjectsResult result;
+    goal.setAborted(result, "Shutting down");
+    return;
+  }
+  publishJobFeedback(*job, "queued");
+}
+
+void MultimodalObjectRecognitionROS::cancelCallback(RecognizeObjectsServer::GoalHandle goal)
+{
+  PerceptionJobPtr job;
+  bool dequeued = false;
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    auto it = goal_jobs_.find(goal.getGoalID().id);
+    if (it == goal_jobs_.end())
+      return;
+    job = it->second;
+    dequeued = job_queue_.remove(job->id);
+    if (dequeued)
+    {
+      goal_jobs_.erase(it);
+    }
+  }
+  if (dequeued)
+  {
+    mir_object_recognition::RecognizeObjectsResult result;
+    result.job_id = job->id;
+    goal.setCanceled(result);
+  }
+  else
+  {
+    // taken by the worker, it finishes the goal
+    cancelRunningJob(*job);
+  }
+}
+
+void MultimodalObjectRecognitionROS::cancelRunningJob(PerceptionJob &job)
+{
+  {
+    std::lock_guard<std::mutex> lock(capture_mutex_);
+    job.cancelled = true;
+  }
+  capture_cv_.notify_all();
+  // wake up the worker if it is waiting for a recognizer reply, the requests of
+  // other frames stay pending
+  std::lock_guard<std::mutex> lock(job.requests_mutex);
+  cancelRequests(job.requests);
+}
+
+void MultimodalObjectRecognitionROS::cancelAllJobs()
+{
+  // goal handles are not used with jobs_mutex_ held, the action server calls
+  // goalCallback and cancelCallback with its own lock held
+  std::vector<PerceptionJobPtr> queued = job_queue_.clear();
+  PerceptionJobPtr running;
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    for (const auto &job : queued)
+    {
+      if (job->has_goal)
+      {
+        goal_jobs_.erase(job->goal.getGoalID().id);
+      }
+    }
+    running = running_job_;
+  }
+  for (const auto &job : queued)
+  {
+    if (job->has_goal)
+    {
+      mir_object_recognition::RecognizeObjectsResult result;
+      result.job_id = job->id;
+      job->goal.setCanceled(result);
+    }
+  }
+  if (running)
+  {
+    cancelRunningJob(*running);
+  }
+}
+
+void MultimodalObjectRecognitionROS::jobStage()
+{
+  uint32_t id;
+  PerceptionJobPtr job;
+  while (job_queue_.pop(id, job))
+  {
+    {
+      std::lock_guard<std::mutex> lock(jobs_mutex_);
+      running_job_ = job;
+    }
+    ROS_INFO_STREAM("[multimodal_object_recognition_ros] Starting perception job " << id);
+    publishJobFeedback(*job, "capturing");
+
+    bool done = false;
+    bool from_store = false;
+    PerceptionFrame frame;
+    if (captureFrame(*job, frame))
+    {
+      // the latency of the frame is counted from the capture, not from the submission
+      frame.timer.restart();
+      frame.stamp = frame.image_msg->header.stamp;
+      frame.workspace_prior = job->workspace_prior;
+      claimViews(true);
+      done = processJob(*job, frame, from_store);
+      claimViews(false);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(jobs_mutex_);
+      running_job_.reset();
+      if (job->has_goal)
+      {
+        goal_jobs_.erase(job->goal.getGoalID().id);
+      }
+    }
+    finishJob(*job, frame, done, from_store);
+    job.reset();
+  }
+}
+
+bool MultimodalObjectRecognitionROS::captureFrame(const PerceptionJob &job, PerceptionFrame &frame)
+{
+  std::unique_lock<std::mutex> lock(capture_mutex_);
+  auto aborted = [&] { return job.cancelled || jobs_closed_; };
+  if (job.capture_delay > 0.0 &&
+      capture_cv_.wait_for(lock, std::chrono::duration<double>(job.capture_delay), aborted))
+  {
+    return false;
+  }
+  // the spin thread subscribes the inputs and hands over the selected frame
+  capture_state_ = CAPTURE_REQUESTED;
+  capture_cv_.wait(lock, [&] { return capture_state_ == CAPTURE_DONE || aborted(); });
+  if (capture_state_ != CAPTURE_DONE)
+  {
+    // the inputs are unsubscribed by the spin thread if they were subscribed already
+    capture_state_ = capture_state_ == CAPTURING ? CAPTURE_CANCELLED : CAPTURE_IDLE;
+    return false;
+  }
+  frame.image_msg = captured_image_;
+  frame.pointcloud_msg = captured_cloud_;
+  frame.depth_msg = captured_depth_;
+  frame.deprojector = captured_deprojector_;
+  captured_image_.reset();
+  captured_cloud_.reset();
+  captured_depth_.reset();
+  captured_deprojector_.reset();
+  capture_state_ = CAPTURE_IDLE;
+  return !aborted();
+}
+
+bool MultimodalObjectRecognitionROS::processJob(PerceptionJob &job, PerceptionFrame &frame, bool &from_store)
+{
+  // an accumulated multi-viewpoint scene is not comparable to a single frame
+  const bool data_collection = data_collection_;
+  const bool use_store = !job.workstation.empty() && !data_collection && pipeline_->numViews() == 0;
+  PerceivedObjectStore::Entry entry;
+  if (use_store && reuseStoredScene(job, frame, entry))
+  {
+    from_store = true;
+    recordLatency(frame);
+    ROS_INFO_STREAM("Total processing time: "<< frame.timer.elapsed());
+    return !job.cancelled;
+  }
+
+  publishJobFeedback(job, "segmenting");
+  bool done = segmentFrame(frame);
+  if (done)
+  {
+    if (data_collection)
+    {
+      saveFrame(frame);
+    }
+    else
+    {
+      requestRecognition(frame);
+      {
+        std::lock_guard<std::mutex> lock(job.requests_mutex);
+        job.requests = pendingRequests(frame);
+      }
+      // canceled while the requests were sent, before they could be canceled with the job
+      if (job.cancelled)
+      {
+        cancelRequests(pendingRequests(frame));
+      }
+      publishJobFeedback(job, "recognizing");
+      recognizeCloudAndImage(frame);
+      if (job.cancelled)
+        return false;
+      publishJobFeedback(job, "publishing");
+      publishFrame(frame, job.publish_objects);
+      // without a robot pose the entry could never be reused
+      if (use_store && !entry.signature.heights.empty() && entry.robot_pose.valid)
+      {
+        entry.object_list = frame.combined_object_list;
+        PerceivedObjectStore::toFixedFrame(entry.robot_pose, entry.object_list);
+        entry.workspace_height = frame.workspace_height;
+        scene_store_.insert(job.workstation, entry);
+      }
+    }
+    recordLatency(frame);
+  }
+  ROS_INFO_STREAM("Total processing time: "<< frame.timer.elapsed());
+  return done && !job.cancelled;
+}
+
+bool MultimodalObjectRecognitionROS::reuseStoredScene(const PerceptionJob &job, PerceptionFrame &frame,
+                                                      PerceivedObjectStore::Entry &entry)
+{
+  StageTimer timer;
+  if (!preprocessFrame(frame))
+  {
+    frame.cloud.reset();
+    frame.depth_view.reset();
+    return false;
+  }
+  frame.stage_latency[STAGE_TRANSFORM] = timer.elapsed();
+
+  // the signature and pose are kept to store the objects of a full run
+  entry.stamp = frame.stamp.toSec();
+  entry.signature = scene_store_.computeSignature(*frame.cloud);
+  lookupRobotPose(frame.stamp, entry.robot_pose);
+  PerceivedObjectStore::Entry stored;
+  double changed_ratio;
+  if (!scene_store_.lookup(job.workstation, entry.signature, entry.robot_pose, entry.stamp, stored,
+                           changed_ratio))
+  {
+    ROS_INFO_STREAM("[multimodal_object_recognition_ros] Perceiving " << job.workstation
+                    << ", changed blocks: " << changed_ratio);
+    return false;
+  }
+  ROS_INFO_STREAM("[multimodal_object_recognition_ros] Scene of " << job.workstation
+                  << " did not change, reusing " << stored.object_list.objects.size()
+                  << " objects perceived " << entry.stamp - stored.stamp << " s ago");
+
+  timer.restart();
+  // the robot may have moved within the tolerance since, the poses are relative to the current one
+  frame.combined_object_list = stored.object_list;
+  PerceivedObjectStore::toRobotFrame(entry.robot_pose, frame.combined_object_list);
+  for (auto &object : frame.combined_object_list.objects)
+  {
+    object.pose.header.stamp = frame.stamp;
+  }
+  frame.workspace_height = stored.workspace_height;
+  std_msgs::Float64 workspace_height_msg;
+  workspace_height_msg.data = frame.workspace_height;
+  pub_workspace_height_.publish(workspace_height_msg);
+  publishJobFeedback(job, "publishing");
+  if (job.publish_objects && !frame.combined_object_list.objects.empty())
+  {
+    publishObjectList(frame.combined_object_list);
+  }
+  frame.stage_latency[STAGE_PUBLISH] = timer.elapsed();
+  return true;
 }
 
-void MultimodalObjectRecognitionROS::publishDebug(mas_perception_msgs::ObjectList &combined_object_list,
-                          std::vector<PointCloud::Ptr> &clusters_3d,
-                          std::vector<PointCloud::Ptr> &clusters_2d)
+void MultimodalObjectRecognitionROS::loadWorkspacePriors()
 {
-  ROS_INFO_STREAM("Cloud list: " << recognized_cloud_list_.objects.size());
-  ROS_INFO_STREAM("RGB list: " << recognized_image_list_.objects.size());
+  XmlRpc::XmlRpcValue priors;
+  if (!nh_.getParam("workspace_priors", priors))
+    return;
+  if (priors.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    ROS_ERROR("[multimodal_object_recognition_ros] workspace_priors must map workstation names to priors");
+    return;
+  }
+  auto toDouble = [](XmlRpc::XmlRpcValue &value)
+  {
+    return value.getType() == XmlRpc::XmlRpcValue::TypeInt ? static_cast<double>(static_cast<int>(value))
+                                                             : static_cast<double>(value);
+  };
+  for (auto &workstation : priors)
+  {
+    XmlRpc::XmlRpcValue &value = workstation.second;
+    try
+    {
+      std::shared_ptr<SceneSegmentation::WorkspacePrior> prior = std::make_shared<SceneSegmentation::WorkspacePrior>();
+      prior->plane_height = toDouble(value["height"]);
+      if (value.hasMember("polygon"))
+      {
+        XmlRpc::XmlRpcValue &polygon = value["polygon"];
+        for (int i = 0; i + 1 < polygon.size(); i += 2)
+        {
+          prior->polygon.push_back(Eigen::Vector2f(toDouble(polygon[i]), toDouble(polygon[i + 1])));
+        }
+      }
+      workspace_priors_[workstation.first] = prior;
+    }
+    catch (XmlRpc::XmlRpcException &ex)
+    {
+      ROS_ERROR_STREAM("[multimodal_object_recognition_ros] Invalid workspace prior of "
+                       << workstation.first << ": " << ex.getMessage());
+    }
+  }
+  ROS_INFO_STREAM("[multimodal_object_recognition_ros] Loaded " << workspace_priors_.size() << " workspace priors");
+}
+
+bool MultimodalObjectRecognitionROS::lookupRobotPose(const ros::Time &stamp, PerceivedObjectStore::RobotPose &robot_pose)
+{
+  robot_pose.valid = false;
+  try
+  {
+    tf::StampedTransform transform;
+    tf_listener_->waitForTransform(scene_store_pose_frame_, target_frame_id_, stamp, ros::Duration(0.1));
+    tf_listener_->lookupTransform(scene_store_pose_frame_, target_frame_id_, stamp, transform);
+    robot_pose.x = transform.getOrigin().x();
+    robot_pose.y = transform.getOrigin().y();
+    robot_pose.yaw = tf::getYaw(transform.getRotation());
+    robot_pose.valid = true;
+  }
+  catch (tf::TransformException &ex)
+  {
+    ROS_WARN_STREAM_THROTTLE(5.0, "[multimodal_object_recognition_ros] No robot pose in " << scene_store_pose_frame_
+                             << ": " << ex.what());
+  }
+  return robot_pose.valid;
+}
+
+void MultimodalObjectRecognitionROS::finishJob(PerceptionJob &job, PerceptionFrame &frame, bool done, bool from_store)
+{
+  if (!job.has_goal)
+  {
+    // e_stop answers the canceled jobs
+    if (!job.cancelled)
+    {
+      std_msgs::String event_out;
+      event_out.data = "e_done";
+      pub_event_out_.publish(event_out);
+    }
+    return;
+  }
+  mir_object_recognition::RecognizeObjectsResult result;
+  result.job_id = job.id;
+  result.from_store = from_store;
+  if (job.cancelled)
+  {
+    job.goal.setCanceled(result);
+  }
+  else if (!done)
+  {
+    job.goal.setAborted(result, "Segmentation failed");
+  }
+  else
+  {
+    result.object_list = frame.combined_object_list;
+    result.workspace_height = frame.workspace_height;
+    job.goal.setSucceeded(result);
+  }
+}
+
+void MultimodalObjectRecognitionROS::publishJobFeedback(PerceptionJob &job, const std::string &state)
+{
+  if (!job.has_goal)
+    return;
+  mir_object_recognition::RecognizeObjectsFeedback feedback;
+  feedback.job_id = job.id;
+  feedback.state = state;
+  feedback.queue_position = std::max(0, job_queue_.position(job.id));
+  job.goal.publishFeedback(feedback);
+}
+
+void MultimodalObjectRecognitionROS::publishDebug(PerceptionFrame &frame)
+{
+  const mas_perception_msgs::ObjectList &combined_object_list = frame.combined_object_list;
+  const std::vector<PointCloud::Ptr> &clusters_3d = frame.clusters_3d;
+  const std::vector<PointCloud::Ptr> &clusters_2d = frame.clusters_2d;
+  ROS_INFO_STREAM("Cloud list: " << frame.recognized_cloud_list.objects.size());
+  ROS_INFO_STREAM("RGB list: " << frame.recognized_image_list.objects.size());
   ROS_INFO_STREAM("Combined object list: "<< combined_object_list.objects.size());
   // Compute normal to generate parallel BBOX to the plane
-  const Eigen::Vector3f normal = scene_segmentation_ros_->getPlaneNormal();
+  const Eigen::Vector3f normal = frame.plane_normal;
 
   std::string names = "";
-  if (recognized_cloud_list_.objects.size() > 0)
+  if (frame.recognized_cloud_list.objects.size() > 0)
   {
-    // Bounding boxes
+    // Bounding boxes, only computed if they are visualized
     if (clusters_3d.size() > 0)
     {
-      mas_perception_msgs::BoundingBoxList bounding_boxes;
       cluster_visualizer_pc_.publish<PointT>(clusters_3d, target_frame_id_);
-      bounding_boxes.bounding_boxes.resize(clusters_3d.size());
-      for (int i=0; i < clusters_3d.size(); i++)
-      {
-        mpu::object::BoundingBox bbox;
-        mpu::object::get3DBoundingBox(clusters_3d[i], normal, bbox, bounding_boxes.bounding_boxes[i]);
-      }
-      if (bounding_boxes.bounding_boxes.size() > 0)
+      if (bounding_box_visualizer_pc_.isActive())
       {
+        mas_perception_msgs::BoundingBoxList bounding_boxes;
+        bounding_boxes.bounding_boxes.resize(clusters_3d.size());
+        for (int i=0; i < clusters_3d.size(); i++)
+        {
+          mpu::object::BoundingBox bbox;
+          mpu::object::get3DBoundingBox(clusters_3d[i], normal, bbox, bounding_boxes.bounding_boxes[i]);
+        }
         bounding_box_visualizer_pc_.publish(bounding_boxes.bounding_boxes, target_frame_id_);
       }
     }
@@ -608,24 +1556,22 @@ void MultimodalObjectRecognitionROS::publishDebug(mas_perception_msgs::ObjectLis
     geometry_msgs::PoseArray pcl_object_pose_array;
     pcl_object_pose_array.header.frame_id = target_frame_id_;
     pcl_object_pose_array.header.stamp = ros::Time::now();
-    pcl_object_pose_array.poses.resize(recognized_cloud_list_.objects.size());
     std::vector<std::string> pcl_labels;
-    int pcl_count = 0;
     for (int i=0; i < combined_object_list.objects.size(); i++)
     {
       if (combined_object_list.objects[i].database_id < 99)
       {
         names += combined_object_list.objects[i].name + ", ";
-        pcl_object_pose_array.poses[pcl_count] = combined_object_list.objects[i].pose.pose;
+        // fused objects appear only once, with the database id of the recognizer they were kept from
+        pcl_object_pose_array.poses.push_back(combined_object_list.objects[i].pose.pose);
         pcl_labels.push_back(combined_object_list.objects[i].name);
-        pcl_count++;
       }
     }
     ROS_INFO_STREAM("[Cloud] Objects: " << names);
     // Publish pose array
     if (pcl_object_pose_array.poses.size() > 0)
     {
-      pub_pc_object_pose_array_.publish(pcl_object_pose_array);
+      pub_pc_object_pose_array_.publish([&]() -> const geometry_msgs::PoseArray & { return pcl_object_pose_array; });
     }
     // Publish label visualizer
     if ((pcl_labels.size() == pcl_object_pose_array.poses.size()) &&
@@ -641,25 +1587,22 @@ void MultimodalObjectRecognitionROS::publishDebug(mas_perception_msgs::ObjectLis
     geometry_msgs::PoseArray rgb_object_pose_array;
     rgb_object_pose_array.header.frame_id = target_frame_id_;
     rgb_object_pose_array.header.stamp = ros::Time::now();
-    rgb_object_pose_array.poses.resize(recognized_image_list_.objects.size());
     std::vector<std::string> rgb_labels;
-    int rgb_count = 0;
     names = "";
     for (int i = 0; i < combined_object_list.objects.size(); i++)
     {
       if (combined_object_list.objects[i].database_id > 99)
       {
         names += combined_object_list.objects[i].name + ", ";
-        rgb_object_pose_array.poses[rgb_count] = combined_object_list.objects[i].pose.pose;
+        rgb_object_pose_array.poses.push_back(combined_object_list.objects[i].pose.pose);
         rgb_labels.push_back(combined_object_list.objects[i].name);
-        rgb_count++;
       }
     }
     ROS_INFO_STREAM("[RGB] Objects: "<< names);
     // Publish pose array
     if (rgb_object_pose_array.poses.size() > 0)
     {
-      pub_rgb_object_pose_array_.publish(rgb_object_pose_array);
+      pub_rgb_object_pose_array_.publish([&]() -> const geometry_msgs::PoseArray & { return rgb_object_pose_array; });
     }
     // Publish label visualizer
     if ((rgb_labels.size() == rgb_object_pose_array.poses.size()) &&
@@ -670,148 +1613,82 @@ void MultimodalObjectRecognitionROS::publishDebug(mas_perception_msgs::ObjectLis
   }
 }
 
-void MultimodalObjectRecognitionROS::publishObjectList(mas_perception_msgs::ObjectList &object_list)
+void MultimodalObjectRecognitionROS::prepareObjectList(mas_perception_msgs::ObjectList &object_list)
 {
+  const std::shared_ptr<const ObjectCatalogue> catalogue = pipeline_->getObjectCatalogue();
   for (int i = 0; i < object_list.objects.size(); i++)
   {
     // Empty cloud
     sensor_msgs::PointCloud2 empty_ros_cloud;
     object_list.objects[i].views.resize(1);
     object_list.objects[i].views[0].point_cloud = empty_ros_cloud;
-    // Rename container to match refbox naming
-    if (object_list.objects[i].name == "BLUE_CONTAINER")
-    {
-      object_list.objects[i].name = "CONTAINER_BOX_BLUE";
-    }
-    else if (object_list.objects[i].name == "RED_CONTAINER")
+    // Rename aliases (e.g. BLUE_CONTAINER) to match refbox naming
+    const ObjectInfo &info = catalogue->info(object_list.objects[i].name);
+    if (info.id != ObjectCatalogue::UNKNOWN_ID && object_list.objects[i].name != info.name)
     {
-      object_list.objects[i].name = "CONTAINER_BOX_RED";
+      object_list.objects[i].name = info.name;
     }
   }
+}
+
+void MultimodalObjectRecognitionROS::publishObjectList(mas_perception_msgs::ObjectList &object_list)
+{
   // Publish object list to object list merger
   pub_object_list_.publish(object_list);
 }
 
-void MultimodalObjectRecognitionROS::adjustObjectPose(mas_perception_msgs::ObjectList &object_list)
+void MultimodalObjectRecognitionROS::eventCallback(const std_msgs::String::ConstPtr &msg)
 {
-  for (int i = 0; i < object_list.objects.size(); i++)
+  std_msgs::String event_out;
+  if (msg->data == "e_start")
   {
-    tf::Quaternion q(
-        object_list.objects[i].pose.pose.orientation.x,
-        object_list.objects[i].pose.pose.orientation.y,
-        object_list.objects[i].pose.pose.orientation.z,
-        object_list.objects[i].pose.pose.orientation.w);
-    tf::Matrix3x3 m(q);
-    double roll, pitch, yaw;
-    m.getRPY(roll, pitch, yaw);
-    double change_in_pitch = 0.0;
-    if (round_objects_.count(object_list.objects[i].name))
-    {
-      yaw = 0.0;
-    }
-
-    // Update container pose
-    if (object_list.objects[i].name == "CONTAINER_BOX_RED" ||
-        object_list.objects[i].name == "CONTAINER_BOX_BLUE")
+    if (continuous_mode_)
     {
-      if (object_list.objects[i].database_id > 100)
-      {
-        ROS_DEBUG_STREAM("Updating RGB container pose");
-        mm_object_recognition_utils_->adjustContainerPose(object_list.objects[i], container_height_);
-      }
-    }
-    
-    if (object_list.objects[i].dimensions.vector.z > 0.09)
-    {
-      tf::Quaternion q2;
-      q2.setRPY(0.0, -1.57, 0.0);
-      object_list.objects[i].pose.pose.orientation.x = q2.x();
-      object_list.objects[i].pose.pose.orientation.y = q2.y();
-      object_list.objects[i].pose.pose.orientation.z = q2.z();
-      object_list.objects[i].pose.pose.orientation.w = q2.w();
+      ROS_WARN("[multimodal_object_recognition_ros] Continuous perception is running, ignoring e_start");
+      return;
     }
-    else
+    submitJob(std::make_shared<PerceptionJob>(), 0);
+  }
+  else if (msg->data == "e_add_view")
+  {
+    if (continuous_mode_)
     {
-      // Make pose flat
-      tf::Quaternion q2 = tf::createQuaternionFromRPY(0.0, change_in_pitch , yaw);
-      object_list.objects[i].pose.pose.orientation.x = q2.x();
-      object_list.objects[i].pose.pose.orientation.y = q2.y();
-      object_list.objects[i].pose.pose.orientation.z = q2.z();
-      object_list.objects[i].pose.pose.orientation.w = q2.w(); 
-
-      object_list.objects[i].pose.pose.position.z = scene_segmentation_ros_->getWorkspaceHeight() +
-                              object_height_above_workspace_;      
+      ROS_WARN("[multimodal_object_recognition_ros] Continuous perception is running, ignoring e_add_view");
+      return;
     }
-
-    // Update workspace height
-    if (scene_segmentation_ros_->getWorkspaceHeight() != -1000.0)
     {
-      if (object_list.objects[i].name == "CONTAINER_BOX_RED" ||
-          object_list.objects[i].name == "CONTAINER_BOX_BLUE")
+      // a job which is done capturing leaves the capture idle, it holds the views instead
+      std::lock_guard<std::mutex> views_lock(views_mutex_);
+      std::lock_guard<std::mutex> lock(capture_mutex_);
+      if (capture_state_ != CAPTURE_IDLE || views_claimed_ || jobsPending())
       {
-
-        object_list.objects[i].pose.pose.position.z = scene_segmentation_ros_->getWorkspaceHeight() +
-                              container_height_;
-        ROS_WARN_STREAM("Updated container height: " << object_list.objects[i].pose.pose.position.z );
+        ROS_WARN("[multimodal_object_recognition_ros] A perception job is pending, ignoring e_add_view");
+        return;
       }
     }
-    
-    // Update axis or bolt pose
-    if (object_list.objects[i].name == "M20_100" || object_list.objects[i].name == "AXIS")
-    {
-      mm_object_recognition_utils_->adjustAxisBoltPose(object_list.objects[i]);
-    }
+    capture_view_ = true;
+    subscribeInputs();
   }
-}
-
-void MultimodalObjectRecognitionROS::loadObjectInfo(const std::string &filename)
-{
-  if (boost::filesystem::is_regular_file(filename))
+  else if (msg->data == "e_start_continuous")
   {
-    using boost::property_tree::ptree;
-    mas_perception_msgs::Object object;
-    ptree pt;
-    read_xml(filename, pt);
-
-    BOOST_FOREACH(ptree::value_type const& v, pt.get_child("object_info"))
+    if (continuous_mode_ || data_collection_ || jobsPending())
     {
-      if (v.first == "object") 
-      {
-        Object f;
-        f.name = v.second.get<std::string>("name");
-        f.shape = v.second.get<std::string>("shape");
-        f.color = v.second.get<std::string>("color");
-        if (f.shape == object.shape.SPHERE)
-        {
-          round_objects_.insert(f.name);
-        }
-        object_info_.push_back(f);
-      }
+      ROS_WARN("[multimodal_object_recognition_ros] Cannot start continuous perception");
+      return;
     }
-    ROS_INFO("Object info is loaded!");
-  }
-  else
-  {
-    ROS_WARN("No object info is provided!");
-    return;
-  }
-
-}
-
-void MultimodalObjectRecognitionROS::eventCallback(const std_msgs::String::ConstPtr &msg)
-{
-  std_msgs::String event_out;
-  if (msg->data == "e_start")
-  {
-    // Synchronize callback
-    image_sub_ = new message_filters::Subscriber<sensor_msgs::Image> (nh_, "input_image_topic", 1);
-    cloud_sub_ = new message_filters::Subscriber<sensor_msgs::PointCloud2> (nh_, "input_cloud_topic", 1);
-    msg_sync_ = new message_filters::Synchronizer<msgSyncPolicy> (msgSyncPolicy(10), *image_sub_, *cloud_sub_);
-    msg_sync_->registerCallback(boost::bind(&MultimodalObjectRecognitionROS::synchronizeCallback, this, _1, _2));
+    startPipeline();
+    subscribeInputs();
+    event_out.data = "e_started_continuous";
+    pub_event_out_.publish(event_out);
   }
   else if (msg->data == "e_stop")
   {
-    scene_segmentation_ros_->resetCloudAccumulation();
+    unsubscribeInputs();
+    stopPipeline();
+    cancelAllJobs();
+    capture_view_ = false;
+    // the views of a running job are reset by the worker once it reaches a cancellation point
+    resetViews();
     event_out.data = "e_stopped";
     pub_event_out_.publish(event_out);
   }
@@ -825,7 +1702,7 @@ void MultimodalObjectRecognitionROS::eventCallback(const std_msgs::String::Const
   else if (msg->data == "e_stop_data_collection")
   {
     data_collection_ = false;
-    scene_segmentation_ros_->resetCloudAccumulation();
+    resetViews();
     event_out.data = "e_data_collection_stopped";
     pub_event_out_.publish(event_out);
     ROS_WARN_STREAM("\033[1;35mData collection disabled\033[0m");
@@ -838,67 +1715,25 @@ void MultimodalObjectRecognitionROS::eventCallback(const std_msgs::String::Const
 
 void MultimodalObjectRecognitionROS::configCallback(mir_object_recognition::SceneSegmentationConfig &config, uint32_t level)
 {
-  scene_segmentation_ros_->setVoxelGridParams(config.voxel_leaf_size, config.voxel_filter_field_name,
-      config.voxel_filter_limit_min, config.voxel_filter_limit_max);
-  scene_segmentation_ros_->setPassthroughParams(config.enable_passthrough_filter,
-      config.passthrough_filter_field_name,
-      config.passthrough_filter_limit_min,
-      config.passthrough_filter_limit_max);
-  scene_segmentation_ros_->setCropBoxParams(config.enable_cropbox_filter, config.cropbox_filter_min_x, config.cropbox_filter_max_x,
-      config.cropbox_filter_min_y, config.cropbox_filter_max_y, config.cropbox_filter_min_z, config.cropbox_filter_max_z);
-  scene_segmentation_ros_->setNormalParams(config.normal_radius_search, config.use_omp, config.num_cores);
-  Eigen::Vector3f axis(config.sac_x_axis, config.sac_y_axis, config.sac_z_axis);
-  scene_segmentation_ros_->setSACParams(config.sac_max_iterations, config.sac_distance_threshold,
-      config.sac_optimize_coefficients, axis, config.sac_eps_angle,
-      config.sac_normal_distance_weight);
-  scene_segmentation_ros_->setPrismParams(config.prism_min_height, config.prism_max_height);
-  scene_segmentation_ros_->setOutlierParams(config.outlier_radius_search, config.outlier_min_neighbors);
-  scene_segmentation_ros_->setClusterParams(config.cluster_tolerance, config.cluster_min_size, config.cluster_max_size,
-      config.cluster_min_height, config.cluster_max_height, config.cluster_max_length,
-      config.cluster_min_distance_to_polygon);
+  pipeline_->configure(config);
+  RecognitionCache::Params cache_params;
+  cache_params.enable = config.enable_recognition_cache;
+  cache_params.max_age = config.recognition_cache_max_age;
+  cache_params.centroid_tolerance = config.recognition_cache_centroid_tolerance;
+  cache_params.extent_tolerance = config.recognition_cache_extent_tolerance;
+  cache_params.point_count_tolerance = config.recognition_cache_point_count_tolerance;
+  cache_params.max_histogram_distance = config.recognition_cache_histogram_distance;
+  recognition_cache_.setParams(cache_params);
+  PerceivedObjectStore::Params store_params;
+  store_params.enable = config.enable_scene_store;
+  store_params.max_age = config.scene_store_max_age;
+  store_params.block_size = config.scene_store_block_size;
+  store_params.depth_tolerance = config.scene_store_depth_tolerance;
+  store_params.max_changed_ratio = config.scene_store_max_changed_ratio;
+  store_params.max_translation = config.scene_store_max_translation;
+  store_params.max_rotation = config.scene_store_max_rotation;
+  scene_store_.setParams(store_params);
   // Object recognizer param
   enable_rgb_recognizer_ = config.enable_rgb_recognizer;
   enable_pc_recognizer_ = config.enable_pc_recognizer;
-
-  // Cluster param
-  center_cluster_ = config.center_cluster;
-  pad_cluster_ = config.pad_cluster;
-  padded_cluster_size_ = config.padded_cluster_size;
-  // Workspace and object height
-  object_height_above_workspace_ = config.object_height_above_workspace;
-  container_height_ = config.container_height;
-  // RGB proposal params
-  rgb_roi_adjustment_ = config.rgb_roi_adjustment;
-  rgb_bbox_min_diag_ = config.rgb_bbox_min_diag;
-  rgb_bbox_max_diag_ = config.rgb_bbox_max_diag;
-  rgb_cluster_filter_limit_min_ = config.rgb_cluster_filter_limit_min;
-  rgb_cluster_filter_limit_max_ = config.rgb_cluster_filter_limit_max;
-  rgb_cluster_remove_outliers_ = config.rgb_cluster_remove_outliers;
-  // ROI params
-  enable_roi_ = config.enable_roi;
-  roi_base_link_to_laser_distance_ = config.roi_base_link_to_laser_distance;
-  roi_max_object_pose_x_to_base_link_ = config.roi_max_object_pose_x_to_base_link;
-  roi_min_bbox_z_ = config.roi_min_bbox_z;
-}
-
-int main(int argc, char **argv)
-{
-  ros::init(argc, argv, "multimodal_object_recognition");
-  ros::NodeHandle nh("~");
-  // Initialize frame rate
-  int frame_rate = 30;
-  nh.param<int>("frame_rate", frame_rate, 30);
-  ros::Rate loop_rate(frame_rate);
-  // Create an object of multimodal object recognition
-  MultimodalObjectRecognitionROS mm_object_recognition(nh);
-  ROS_INFO_STREAM("\033[1;32m [multimodal_object_recognition] node started with rate "
-                  << frame_rate << " \033[0m\n");
-  // Run mm object recognition
-  while (ros::ok())
-  {
-    mm_object_recognition.update();
-    ros::spinOnce();
-    loop_rate.sleep();
-  }
-  return 0;
 }
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <memory>
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <mir_object_recognition/multimodal_object_recognition_node.h>
+
+namespace mir_object_recognition
+{
+
+/** \brief Nodelet of the multimodal object recognition. Loaded into the nodelet manager of
+ * the camera driver, the image and pointcloud are received as shared pointers without
+ * serialization. Parameters and topics are the same as for the executable.
+ */
+class MultimodalObjectRecognitionNodelet : public nodelet::Nodelet
+{
+  public:
+    virtual void onInit()
+    {
+      ros::NodeHandle nh = getPrivateNodeHandle();
+      int frame_rate = 30;
+      nh.param<int>("frame_rate", frame_rate, 30);
+      mm_object_recognition_.reset(new MultimodalObjectRecognitionROS(nh));
+      // update() is polled like in the main loop of the executable
+      update_timer_ = nh.createTimer(ros::Duration(1.0 / std::max(1, frame_rate)),
+                                     &MultimodalObjectRecognitionNodelet::update, this);
+      NODELET_INFO_STREAM("[multimodal_object_recognition] nodelet started with rate " << frame_rate);
+    }
+
+  private:
+    void update(const ros::TimerEvent &event)
+    {
+      mm_object_recognition_->update();
+    }
+
+    std::unique_ptr<MultimodalObjectRecognitionROS> mm_object_recognition_;
+    ros::Timer update_timer_;
+};
+
+}  // namespace mir_object_recognition
+
+PLUGINLIB_EXPORT_CLASS(mir_object_recognition::MultimodalObjectRecognitionNodelet, nodelet::Nodelet)
@@ -0,0 +1,534 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+#include <boost/filesystem.hpp>
+
+#include <pcl/common/common.h>
+#include <pcl/filters/statistical_outlier_removal.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <pcl_ros/point_cloud.h>
+#include <tf/transform_datatypes.h>
+
+#include <mir_perception_utils/object_utils_ros.h>
+#include <mir_perception_utils/pointcloud_utils_ros.h>
+
+#include <mir_object_recognition/multimodal_object_recognition_pipeline.h>
+
+namespace mpu = mir_perception_utils;
+
+MultimodalObjectRecognitionPipeline::Params::Params()
+  : center_cluster(false),
+    pad_cluster(false),
+    padded_cluster_size(2048),
+    object_height_above_workspace(0.038),
+    container_height(0.05),
+    rgb_roi_adjustment(2),
+    rgb_bbox_min_diag(21),
+    rgb_bbox_max_diag(250),
+    rgb_cluster_filter_limit_min(0.009),
+    rgb_cluster_filter_limit_max(0.35),
+    rgb_cluster_remove_outliers(true),
+    enable_roi(true),
+    roi_base_link_to_laser_distance(0.350),
+    roi_max_object_pose_x_to_base_link(0.650),
+    roi_min_bbox_z(0.03),
+    object_fusion_radius(0.03),
+    enable_workspace_prior(true),
+    workspace_prior_height_tolerance(0.03),
+    workspace_prior_min_points(500),
+    catalogue(std::make_shared<ObjectCatalogue>())
+{
+}
+
+MultimodalObjectRecognitionPipeline::MultimodalObjectRecognitionPipeline(unsigned int num_workers)
+  : scene_segmentation_ros_(new SceneSegmentationROS()),
+    detection_pool_(new mpu::ThreadPool(num_workers))
+{
+}
+
+MultimodalObjectRecognitionPipeline::~MultimodalObjectRecognitionPipeline() {}
+
+void MultimodalObjectRecognitionPipeline::configure(const mir_object_recognition::SceneSegmentationConfig &config)
+{
+  {
+    std::lock_guard<std::mutex> lock(segmentation_mutex_);
+    scene_segmentation_ros_->setVoxelGridParams(config.voxel_leaf_size, config.voxel_filter_field_name,
+        config.voxel_filter_limit_min, config.voxel_filter_limit_max);
+    scene_segmentation_ros_->setPassthroughParams(config.enable_passthrough_filter,
+        config.passthrough_filter_field_name,
+        config.passthrough_filter_limit_min,
+        config.passthrough_filter_limit_max);
+    scene_segmentation_ros_->setCropBoxParams(config.enable_cropbox_filter, config.cropbox_filter_min_x, config.cropbox_filter_max_x,
+        config.cropbox_filter_min_y, config.cropbox_filter_max_y, config.cropbox_filter_min_z, config.cropbox_filter_max_z);
+    scene_segmentation_ros_->setNormalParams(config.normal_radius_search, config.use_omp, config.num_cores);
+    scene_segmentation_ros_->setOrganizedPlaneParams(config.enable_organized_plane, config.organized_plane_stride,
+        config.organized_plane_min_inliers, config.organized_plane_angular_threshold,
+        config.organized_normal_smoothing_size);
+    Eigen::Vector3f axis(config.sac_x_axis, config.sac_y_axis, config.sac_z_axis);
+    scene_segmentation_ros_->setSACParams(config.sac_max_iterations, config.sac_distance_threshold,
+        config.sac_optimize_coefficients, axis, config.sac_eps_angle,
+        config.sac_normal_distance_weight);
+    scene_segmentation_ros_->setPrismParams(config.prism_min_height, config.prism_max_height);
+    scene_segmentation_ros_->setOutlierParams(config.outlier_radius_search, config.outlier_min_neighbors);
+    scene_segmentation_ros_->setClusterParams(config.cluster_tolerance, config.cluster_min_size, config.cluster_max_size,
+        config.cluster_min_height, config.cluster_max_height, config.cluster_max_length,
+        config.cluster_min_distance_to_polygon);
+  }
+
+  std::lock_guard<std::mutex> lock(params_mutex_);
+  // Cluster param
+  params_.center_cluster = config.center_cluster;
+  params_.pad_cluster = config.pad_cluster;
+  params_.padded_cluster_size = config.padded_cluster_size;
+  // Workspace and object height
+  params_.object_height_above_workspace = config.object_height_above_workspace;
+  params_.container_height = config.container_height;
+  params_.enable_workspace_prior = config.enable_workspace_prior;
+  params_.workspace_prior_height_tolerance = config.workspace_prior_height_tolerance;
+  params_.workspace_prior_min_points = config.workspace_prior_min_points;
+  params_.container.cell_size = config.container_raster_cell_size;
+  params_.container.min_points = config.container_min_points;
+  // RGB proposal params
+  params_.rgb_roi_adjustment = config.rgb_roi_adjustment;
+  params_.rgb_bbox_min_diag = config.rgb_bbox_min_diag;
+  params_.rgb_bbox_max_diag = config.rgb_bbox_max_diag;
+  params_.rgb_cluster_filter_limit_min = config.rgb_cluster_filter_limit_min;
+  params_.rgb_cluster_filter_limit_max = config.rgb_cluster_filter_limit_max;
+  params_.rgb_cluster_remove_outliers = config.rgb_cluster_remove_outliers;
+  // ROI params
+  params_.enable_roi = config.enable_roi;
+  params_.roi_base_link_to_laser_distance = config.roi_base_link_to_laser_distance;
+  params_.roi_max_object_pose_x_to_base_link = config.roi_max_object_pose_x_to_base_link;
+  params_.roi_min_bbox_z = config.roi_min_bbox_z;
+  // Fusion of 3D and RGB objects, a radius of 0 disables the fusion
+  params_.object_fusion_radius = config.enable_object_fusion ? config.object_fusion_radius : 0.0;
+  // Crop and downscale of the rgb recognizer requests
+  params_.rgb_crop.crop_to_workspace = config.enable_rgb_workspace_crop;
+  params_.rgb_crop.margin = config.rgb_workspace_crop_margin;
+  params_.rgb_crop.max_size = config.rgb_request_max_size;
+  params_.rgb_crop.max_height = config.prism_max_height;
+}
+
+bool MultimodalObjectRecognitionPipeline::loadObjectInfo(const std::string &filename)
+{
+  if (!boost::filesystem::is_regular_file(filename))
+  {
+    ROS_WARN("No object info is provided!");
+    return false;
+  }
+
+  std::shared_ptr<ObjectCatalogue> catalogue = std::make_shared<ObjectCatalogue>();
+  std::string error;
+  if (!catalogue->load(filename, &error))
+  {
+    ROS_ERROR_STREAM("Cannot read the object info " << filename << ": " << error);
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(params_mutex_);
+  params_.catalogue = catalogue;
+  ROS_INFO("Object info is loaded!");
+  return true;
+}
+
+std::shared_ptr<const ObjectCatalogue> MultimodalObjectRecognitionPipeline::getObjectCatalogue()
+{
+  std::lock_guard<std::mutex> lock(params_mutex_);
+  return params_.catalogue;
+}
+
+MultimodalObjectRecognitionPipeline::Params MultimodalObjectRecognitionPipeline::getParams()
+{
+  std::lock_guard<std::mutex> lock(params_mutex_);
+  return params_;
+}
+
+size_t MultimodalObjectRecognitionPipeline::addView(PerceptionView &view)
+{
+  std::lock_guard<std::mutex> lock(segmentation_mutex_);
+  scene_segmentation_ros_->addCloudAccumulation(view.cloud);
+  accumulated_views_.push_back(std::move(view));
+  return accumulated_views_.size();
+}
+
+void MultimodalObjectRecognitionPipeline::resetViews()
+{
+  std::lock_guard<std::mutex> lock(segmentation_mutex_);
+  accumulated_views_.clear();
+  scene_segmentation_ros_->resetCloudAccumulation();
+}
+
+size_t MultimodalObjectRecognitionPipeline::numViews()
+{
+  std::lock_guard<std::mutex> lock(segmentation_mutex_);
+  return accumulated_views_.size();
+}
+
+void MultimodalObjectRecognitionPipeline::segment(PerceptionFrame &frame, PointCloud::Ptr &cloud_debug)
+{
+  const Params params = getParams();
+
+  std::lock_guard<std::mutex> lock(segmentation_mutex_);
+  StageTimer timer;
+  // fuse the viewpoints added with addView and the view of this frame
+  frame.views = std::move(accumulated_views_);
+  accumulated_views_.clear();
+  PerceptionView view;
+  view.image_msg = frame.image_msg;
+  view.cloud = frame.cloud;
+  view.depth = frame.depth_view;
+  frame.views.push_back(std::move(view));
+
+  scene_segmentation_ros_->addCloudAccumulation(frame.cloud);
+  PointCloud::Ptr cloud(new PointCloud);
+  cloud->header.frame_id = frame.cloud->header.frame_id;
+  scene_segmentation_ros_->getCloudAccumulation(cloud);
+  frame.stage_latency[STAGE_ACCUMULATION] = timer.elapsed();
+
+  timer.restart();
+  const bool use_prior = params.enable_workspace_prior && frame.workspace_prior;
+  if (use_prior)
+  {
+    SceneSegmentation::WorkspacePrior prior = *frame.workspace_prior;
+    prior.height_tolerance = params.workspace_prior_height_tolerance;
+    prior.min_points = params.workspace_prior_min_points;
+    scene_segmentation_ros_->setWorkspacePrior(prior);
+  }
+  // the accumulated cloud is not organized, the plane of a single view is found in its camera cloud
+  const bool single_view = frame.views.size() == 1;
+  if (single_view)
+  {
+    scene_segmentation_ros_->setOrganizedCloud(frame.cloud);
+  }
+  // if the cluster is centered,it looses the correct location of the object
+  scene_segmentation_ros_->segmentCloud(cloud, frame.cloud_object_list, frame.clusters_3d, frame.boxes,
+                      false, params.pad_cluster, params.padded_cluster_size);
+  if (single_view)
+  {
+    if (scene_segmentation_ros_->isOrganizedPlaneMissed())
+    {
+      ROS_DEBUG("[multimodal_object_recognition] No plane found in the organized cloud, voxelized the cloud");
+    }
+    scene_segmentation_ros_->clearOrganizedCloud();
+  }
+  if (use_prior)
+  {
+    if (!scene_segmentation_ros_->isWorkspacePriorUsed())
+    {
+      ROS_DEBUG("[multimodal_object_recognition] Plane not found at the workspace prior, segmented the whole cloud");
+    }
+    scene_segmentation_ros_->clearWorkspacePrior();
+  }
+
+  // keep the plane of this frame, the scene segmentation is reused by the next frame
+  frame.workspace_height = scene_segmentation_ros_->getWorkspaceHeight();
+  if (!frame.clusters_3d.empty())
+  {
+    frame.plane_normal = scene_segmentation_ros_->getPlaneNormal();
+  }
+  frame.workspace_hull = scene_segmentation_ros_->getWorkspaceHull();
+  cloud_debug = scene_segmentation_ros_->getCloudDebug();
+  frame.stage_latency[STAGE_SEGMENTATION] = timer.elapsed();
+
+  // reset object id and accumulated cloud for the next frame
+  scene_segmentation_ros_->resetPclObjectId();
+  scene_segmentation_ros_->resetCloudAccumulation();
+}
+
+void MultimodalObjectRecognitionPipeline::cropRGBRequests(PerceptionFrame &frame)
+{
+  const Params params = getParams();
+  if (!params.rgb_crop.crop_to_workspace && params.rgb_crop.max_size <= 0)
+    return;
+
+  WorkspaceImageCrop cropper;
+  cropper.setParams(params.rgb_crop);
+  const PointCloud empty_hull;
+  const PointCloud &hull = frame.workspace_hull ? *frame.workspace_hull : empty_hull;
+  for (auto &view : frame.views)
+  {
+    view.request_image.reset();
+    view.image_crop = ImageCrop();
+    if (!view.cloud)
+      continue;
+    cropper.crop(view.image_msg, *view.cloud, hull, frame.plane_normal, view.request_image, view.image_crop,
+                 view.depth ? view.depth->cloud_stride : 1);
+  }
+}
+
+void MultimodalObjectRecognitionPipeline::processRGBDetections(PerceptionFrame &frame)
+{
+  const mas_perception_msgs::ObjectList &recognized_image_list = frame.recognized_image_list;
+  if (recognized_image_list.objects.empty())
+    return;
+
+  StageTimer timer;
+  const Params params = getParams();
+  mas_perception_msgs::ObjectList &rgb_object_list = frame.rgb_object_list;
+  rgb_object_list.objects.resize(recognized_image_list.objects.size());
+
+  // The ROI extraction and pose estimation of each detection are independent,
+  // run them on the worker pool, each task writes to its own index
+  std::vector<PointCloud::Ptr> rgb_clusters(recognized_image_list.objects.size());
+  frame.filtered_rgb_clouds.resize(recognized_image_list.objects.size());
+  std::vector<std::future<void>> detection_tasks;
+  detection_tasks.reserve(recognized_image_list.objects.size());
+  int rgb_object_id = RGB_OBJECT_ID;
+  for (int i = 0; i < recognized_image_list.objects.size(); i++)
+  {
+    mas_perception_msgs::Object object = recognized_image_list.objects[i];
+    // Check qualitative info of the object, the catalogue outlives the tasks with the params
+    const ObjectInfo &info = params.catalogue->info(object.name);
+    object.shape.shape = info.round ? object.shape.SPHERE : object.shape.OTHER;
+    // Get ROI, in the image of the view the object was detected in
+    const PerceptionView &view = frame.views[frame.image_detection_views[i]];
+    mas_perception_msgs::Object &rgb_object = rgb_object_list.objects[i];
+    PointCloud::Ptr &cloud_roi = rgb_clusters[i];
+    PointCloud::Ptr &filtered_cloud = frame.filtered_rgb_clouds[i];
+    detection_tasks.push_back(detection_pool_->enqueue(
+        [this, &params, &view, object, &info, rgb_object_id, &rgb_object, &cloud_roi, &filtered_cloud]
+        {
+          processRGBDetection(params, view, object, info, rgb_object_id, rgb_object, cloud_roi,
+                              filtered_cloud);
+        }));
+    rgb_object_id++;
+  }
+  for (auto &task : detection_tasks)
+  {
+    task.get();
+  }
+  // keep the clusters in the order of the detections
+  for (auto &cluster : rgb_clusters)
+  {
+    if (cluster)
+    {
+      frame.clusters_2d.push_back(cluster);
+    }
+  }
+  frame.stage_latency[STAGE_ROI_POSE] = timer.elapsed();
+}
+
+bool MultimodalObjectRecognitionPipeline::getDepthROI(const Params &params, const PerceptionView &view,
+                                                      const sensor_msgs::RegionOfInterest &roi,
+                                                      PointCloud::Ptr &cloud_roi)
+{
+  if (!view.image_msg)
+    return false;
+  const int adjustment = static_cast<int>(params.rgb_roi_adjustment);
+  int min_x = roi.x_offset;
+  int min_y = roi.y_offset;
+  if (static_cast<int>(roi.x_offset) > adjustment)
+    min_x -= adjustment;
+  if (static_cast<int>(roi.y_offset) > adjustment)
+    min_y -= adjustment;
+  const cv::Rect region(min_x, min_y, roi.x_offset + roi.width - min_x, roi.y_offset + roi.height - min_y);
+  if (!view.depth->deprojectRegion(region, view.image_msg->width, view.image_msg->height, *cloud_roi))
+  {
+    ROS_ERROR("Cannot deproject the roi from the depth image");
+    return false;
+  }
+  cloud_roi->header.stamp = view.cloud->header.stamp;
+  if (params.rgb_cluster_remove_outliers && !cloud_roi->points.empty())
+  {
+    pcl::StatisticalOutlierRemoval<PointT> sor;
+    sor.setInputCloud(cloud_roi);
+    sor.setMeanK(50);
+    sor.setStddevMulThresh(3.0);
+    sor.filter(*cloud_roi);
+  }
+  return true;
+}
+
+void MultimodalObjectRecognitionPipeline::processRGBDetection(const Params &params,
+                                                              const PerceptionView &view,
+                                                              const mas_perception_msgs::Object &object,
+                                                              const ObjectInfo &info,
+                                                              int database_id,
+                                                              mas_perception_msgs::Object &rgb_object,
+                                                              PointCloud::Ptr &cloud_roi,
+                                                              PointCloud::Ptr &filtered_cloud)
+{
+  sensor_msgs::RegionOfInterest roi_2d = object.roi;
+  // Remove large 2d misdetected bbox (misdetection)
+  double len_diag = sqrt(powf(roi_2d.width, 2) + powf(roi_2d.height, 2));
+
+  if (len_diag > params.rgb_bbox_min_diag && len_diag < params.rgb_bbox_max_diag)
+  {
+    cloud_roi = PointCloud::Ptr(new PointCloud);
+    bool getROISuccess = false;
+    if (view.depth)
+    {
+      // the view cloud is strided, deproject the roi at full resolution instead
+      getROISuccess = getDepthROI(params, view, roi_2d, cloud_roi);
+    }
+    else
+    {
+      getROISuccess = mpu::pointcloud::getPointCloudROI(roi_2d, view.cloud, cloud_roi,
+                                                        params.rgb_roi_adjustment,
+                                                        params.rgb_cluster_remove_outliers);
+    }
+    if (getROISuccess)
+    {
+      const std::string &frame_id = view.cloud->header.frame_id;
+      sensor_msgs::PointCloud2 ros_pc2;
+      pcl::PCLPointCloud2::Ptr pc2(new pcl::PCLPointCloud2);
+      pcl::toPCLPointCloud2(*cloud_roi, *pc2);
+      pcl_conversions::fromPCL(*pc2, ros_pc2);
+      ros_pc2.header.frame_id = frame_id;
+      ros_pc2.header.stamp = ros::Time::now();
+
+      rgb_object.views.resize(1);
+      rgb_object.views[0].point_cloud = ros_pc2;
+
+      // Get pose
+      geometry_msgs::PoseStamped pose;
+      filtered_cloud = PointCloud::Ptr(new PointCloud);
+      *filtered_cloud = mpu::object::estimatePose(cloud_roi, pose, object.shape.shape,
+                                                  params.rgb_cluster_filter_limit_min,
+                                                  params.rgb_cluster_filter_limit_max);
+      filtered_cloud->header.frame_id = frame_id;
+
+      PointT min_pt;
+      PointT max_pt;
+      pcl::getMinMax3D(*cloud_roi, min_pt, max_pt);
+
+      rgb_object.dimensions.vector.z = max_pt.z - min_pt.z;
+      ROS_INFO("[RGB Object Height] Object %s length: %f", object.name.c_str(), rgb_object.dimensions.vector.z);
+
+      if (max_pt.z > 0.09)
+      {
+        ROS_INFO("[RGB Object Height] Object %s length is greater than 9cm: %f", object.name.c_str(), max_pt.z);
+      }
+
+      // The views are transformed to the target frame before segmentation,
+      // so the pose is already in the target frame
+      pose.header.stamp = ros::Time::now();
+      pose.header.frame_id = frame_id;
+      rgb_object.pose = pose;
+      // Container pose at the center of its floor, on the native cloud of the ROI
+      if (info.container)
+      {
+        ContainerRimEstimator container_estimator;
+        container_estimator.setParams(params.container);
+        Eigen::Vector3f center;
+        float rim_height;
+        if (container_estimator.estimate(*cloud_roi, center, rim_height))
+        {
+          ROS_DEBUG_STREAM("Updating RGB container pose");
+          rgb_object.pose.pose.position.x = center.x();
+          rgb_object.pose.pose.position.y = center.y();
+          rgb_object.pose.pose.position.z = rim_height + params.container_height;
+        }
+      }
+      rgb_object.probability = object.probability;
+      rgb_object.database_id = database_id;
+      rgb_object.name = object.name;
+    }
+    else
+    {
+      ROS_DEBUG("[RGB] DECOY");
+      cloud_roi.reset();
+      rgb_object.name = "DECOY";
+      rgb_object.database_id = database_id;
+    }
+  }
+  else
+  {
+    ROS_DEBUG("[RGB] DECOY");
+    rgb_object.name = "DECOY";
+    rgb_object.database_id = database_id;
+  }
+}
+
+int MultimodalObjectRecognitionPipeline::fuseObjects(PerceptionFrame &frame)
+{
+  const Params params = getParams();
+
+  // Merge recognized_cloud_list and rgb_object_list, objects seen by both recognizers are fused
+  mas_perception_msgs::ObjectList &combined_object_list = frame.combined_object_list;
+  ObjectFusion object_fusion(params.object_fusion_radius);
+  int num_fused = object_fusion.fuse(frame.recognized_cloud_list, frame.rgb_object_list,
+                                     combined_object_list);
+
+  if (params.enable_roi)
+  {
+    for (int i = 0; i < combined_object_list.objects.size(); i++)
+    {
+      double current_object_pose_x = combined_object_list.objects[i].pose.pose.position.x;
+      if (current_object_pose_x < params.roi_base_link_to_laser_distance ||
+          current_object_pose_x > params.roi_max_object_pose_x_to_base_link)
+      {
+        ROS_WARN_STREAM("This object " << combined_object_list.objects[i].name << " out of RoI");
+        combined_object_list.objects[i].name = "DECOY";
+      }
+    }
+  }
+  return num_fused;
+}
+
+void MultimodalObjectRecognitionPipeline::adjustObjectPose(mas_perception_msgs::ObjectList &object_list,
+                                                           double workspace_height)
+{
+  const Params params = getParams();
+  for (int i = 0; i < object_list.objects.size(); i++)
+  {
+    tf::Quaternion q(
+        object_list.objects[i].pose.pose.orientation.x,
+        object_list.objects[i].pose.pose.orientation.y,
+        object_list.objects[i].pose.pose.orientation.z,
+        object_list.objects[i].pose.pose.orientation.w);
+    tf::Matrix3x3 m(q);
+    double roll, pitch, yaw;
+    m.getRPY(roll, pitch, yaw);
+    double change_in_pitch = 0.0;
+    const ObjectInfo &info = params.catalogue->info(object_list.objects[i].name);
+    if (info.round)
+    {
+      yaw = 0.0;
+    }
+
+    // The center of RGB containers is estimated in processRGBDetection
+
+    if (object_list.objects[i].dimensions.vector.z > 0.09)
+    {
+      tf::Quaternion q2;
+      q2.setRPY(0.0, -1.57, 0.0);
+      object_list.objects[i].pose.pose.orientation.x = q2.x();
+      object_list.objects[i].pose.pose.orientation.y = q2.y();
+      object_list.objects[i].pose.pose.orientation.z = q2.z();
+      object_list.objects[i].pose.pose.orientation.w = q2.w();
+    }
+    else
+    {
+      // Make pose flat
+      tf::Quaternion q2 = tf::createQuaternionFromRPY(0.0, change_in_pitch , yaw);
+      object_list.objects[i].pose.pose.orientation.x = q2.x();
+      object_list.objects[i].pose.pose.orientation.y = q2.y();
+      object_list.objects[i].pose.pose.orientation.z = q2.z();
+      object_list.objects[i].pose.pose.orientation.w = q2.w();
+
+      object_list.objects[i].pose.pose.position.z = workspace_height +
+                              params.object_height_above_workspace;
+    }
+
+    // Update workspace height
+    if (workspace_height != -1000.0)
+    {
+      if (info.container)
+      {
+        object_list.objects[i].pose.pose.position.z = workspace_height +
+                              params.container_height;
+        ROS_WARN_STREAM("Updated container height: " << object_list.objects[i].pose.pose.position.z );
+      }
+    }
+
+    // Update axis or bolt pose
+    if (info.pose_adjustment != PoseAdjustment::NONE)
+    {
+      mm_object_recognition_utils_.adjustAxisBoltPose(object_list.objects[i], info.pose_adjustment);
+    }
+  }
+}
@@ -12,10 +12,8 @@
 #include <pcl/common/transforms.h>
 #include <pcl/filters/statistical_outlier_removal.h>
 #include <pcl_conversions/pcl_conversions.h>
-#include <pcl/features/normal_3d.h>
-#include <pcl/segmentation/region_growing.h>
-#include <pcl/filters/extract_indices.h>
 
+#include <mir_object_recognition/container_rim_estimator.h>
 #include <mir_object_recognition/multimodal_object_recognition_utils.h>
 
 MultimodalObjectRecognitionUtils::MultimodalObjectRecognitionUtils() {}
@@ -25,91 +23,20 @@ void MultimodalObjectRecognitionUtils::adjustContainerPose(mas_perception_msgs::
 {
   PointCloud::Ptr cloud(new PointCloud);
   pcl::fromROSMsg(container_object.views[0].point_cloud, *cloud);
-  // find min and max z
-  pcl::PointXYZRGB min_pt;
-  pcl::PointXYZRGB max_pt;
-  pcl::getMinMax3D(*cloud, min_pt, max_pt);
-  ROS_INFO_STREAM("Min and max z " << min_pt.z << ", " << max_pt.z);
-  // estimate normal
-  pcl::search::Search<pcl::PointXYZRGB>::Ptr tree = boost::shared_ptr<pcl::search::Search<pcl::PointXYZRGB> > (new pcl::search::KdTree<pcl::PointXYZRGB>);
-  pcl::PointCloud<pcl::Normal>::Ptr normals (new pcl::PointCloud <pcl::Normal>);
-  pcl::NormalEstimation<pcl::PointXYZRGB, pcl::Normal> normal_estimator;
-  normal_estimator.setSearchMethod(tree);
-  normal_estimator.setInputCloud(cloud);
-  normal_estimator.setKSearch(50);
-  normal_estimator.compute(*normals);
-  // filter points by height
-  pcl::IndicesPtr indices (new std::vector <int>);
-  pcl::PassThrough<pcl::PointXYZRGB> pass;
-  pass.setInputCloud(cloud);
-  pass.setFilterFieldName("z");
-  pass.setFilterLimits(min_pt.z, (min_pt.z + (min_pt.z + max_pt.z/2))/2);
-  pass.filter(*indices);
-  // apply segmentation with region growing
-  pcl::RegionGrowing<pcl::PointXYZRGB, pcl::Normal> reg;
-  reg.setMinClusterSize(300);
-  reg.setMaxClusterSize(1000000);
-  reg.setSearchMethod(tree);
-  reg.setNumberOfNeighbours(200);
-  reg.setInputCloud(cloud);
-  // reg.setIndices (indices);
-  reg.setInputNormals(normals);
-  reg.setSmoothnessThreshold(3.0 / 180.0 * M_PI);
-  reg.setCurvatureThreshold(1.0);
-  std::vector <pcl::PointIndices> clusters;
-  reg.extract(clusters);
-  // find the biggest cluster
-  pcl::PointIndices::Ptr filtered_cluster(new pcl::PointIndices() );
-  int largest_index, largest_cluster;
-  if (clusters.size() == 0)
+  ContainerRimEstimator container_estimator;
+  Eigen::Vector3f center;
+  float rim_height;
+  if (!container_estimator.estimate(*cloud, center, rim_height))
   {
     return;
   }
-  for (size_t i = 0; i < clusters.size(); i++)
-  {
-    if (i == 0)
-    {
-      largest_index = 0;
-      largest_cluster = clusters[0].indices.size();
-    }
-    else
-    {
-      if (largest_cluster <= clusters[i].indices.size())
-      {
-        largest_index = i;
-        largest_cluster = clusters[i].indices.size();
-      }
-    }
-  }
-  int counter = 0;
-  while (counter < clusters[largest_index].indices.size ())
-  {
-    filtered_cluster->indices.push_back(clusters[largest_index].indices[counter]);
-    counter++;
-  }
-  PointCloud::Ptr cloud_filtered (new PointCloud);
-  // point indices to cloud
-  pcl::ExtractIndices<pcl::PointXYZRGB> c_filter(true);
-  c_filter.setInputCloud(cloud);
-  c_filter.setIndices(filtered_cluster);
-  c_filter.filter(*cloud_filtered);
-  // publish selected cluster
-  // PointCloud::Ptr colored_cloud = reg.getColoredCloud();
-  // sensor_msgs::PointCloud2 ros_pointcloud;
-  // pcl::PCLPointCloud2::Ptr cloud_cl(new pcl::PCLPointCloud2);
-  // pcl::toPCLPointCloud2(*cloud_filtered, *cloud_cl);
-  // pcl_conversions::fromPCL(*cloud_cl, ros_pointcloud);
-  // ros_pointcloud.header.frame_id = target_frame_id_;
-  // pub_pc_cluster_.publish(ros_pointcloud);
-  // find centroid
-  Eigen::Vector4f centroid;
-  unsigned int valid_points = pcl::compute3DCentroid(*cloud_filtered, centroid);
   // Change the center of object
-  container_object.pose.pose.position.x = centroid[0];
-  container_object.pose.pose.position.y = centroid[1];
-  container_object.pose.pose.position.z = max_pt.z + container_height;
+  container_object.pose.pose.position.x = center.x();
+  container_object.pose.pose.position.y = center.y();
+  container_object.pose.pose.position.z = rim_height + container_height;
 }
-void MultimodalObjectRecognitionUtils::adjustAxisBoltPose(mas_perception_msgs::Object &object)
+void MultimodalObjectRecognitionUtils::adjustAxisBoltPose(mas_perception_msgs::Object &object,
+                                                          PoseAdjustment adjustment)
 {
   pcl::PointCloud<pcl::PointXYZ>::Ptr xyz_cloud(new pcl::PointCloud<pcl::PointXYZ>);
   pcl::fromROSMsg(object.views[0].point_cloud, *xyz_cloud);
@@ -129,17 +56,17 @@ void MultimodalObjectRecognitionUtils::adjustAxisBoltPose(mas_perception_msgs::O
     }
   }
   unsigned int valid_points = pcl::compute3DCentroid(*point_at_z, centroid);
-  if (object.name == "M20_100")
+  if (adjustment == PoseAdjustment::BOLT)
   {
-    ROS_INFO_STREAM("Updating M20_100 pose from object id: " << object.database_id);
+    ROS_INFO_STREAM("Updating " << object.name << " pose from object id: " << object.database_id);
     float midpoint_x = (object.pose.pose.position.x + centroid[0])/2;
     float midpoint_y = (object.pose.pose.position.y + centroid[1])/2;
     object.pose.pose.position.x = midpoint_x;
     object.pose.pose.position.y = midpoint_y;
   }
-  else if (object.name == "AXIS")
+  else if (adjustment == PoseAdjustment::AXIS)
   {
-    ROS_INFO_STREAM("Updating AXIS pose from object id: " << object.database_id);
+    ROS_INFO_STREAM("Updating " << object.name << " pose from object id: " << object.database_id);
     object.pose.pose.position.x = centroid[0];
     object.pose.pose.position.y = centroid[1];
   }
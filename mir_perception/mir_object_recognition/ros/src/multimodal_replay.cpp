@@ -0,0 +1,362 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <cv_bridge/cv_bridge.h>
+#include <dynamic_reconfigure/config_tools.h>
+#include <opencv2/imgcodecs.hpp>
+#include <pcl/io/pcd_io.h>
+#include <ros/ros.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <mir_object_recognition/multimodal_object_recognition_pipeline.h>
+#include <mir_object_recognition/onnx_detector.h>
+
+/** \brief Offline replay of the multimodal object recognition pipeline.
+ *
+ * Runs segmentation, ROI extraction, pose estimation, fusion and pose adjustment on
+ * recorded scenes without a ROS master, recognizers or TF, and prints the per-stage
+ * latency and the resulting objects of every scene.
+ *
+ * A scene directory contains for every scene N:
+ *   scene_N.pcd     - organized point cloud, already in the target frame
+ *   scene_N.png     - rgb image of the same view (or scene_N.jpg), optional
+ *   scene_N_rgb.txt - recorded rgb recognizer reply, one "label probability x y width height"
+ *                     line per detection, optional. Without it the image is detected with the
+ *                     --rgb-model ONNX model if one is given.
+ *   scene_N_pc.txt  - recorded pc recognizer reply, one "label probability" line per
+ *                     segmented cluster in cluster order, optional
+ * Lines starting with # are ignored.
+ *
+ * Usage: multimodal_replay <scene_dir> [--config scene_segmentation_constraints.yaml]
+ *                          [--object-info objects.xml] [--workers N]
+ *                          [--rgb-model model.onnx] [--rgb-classes rgb_onnx_classes.txt]
+ */
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+struct Detection
+{
+  std::string label;
+  double probability;
+  int x, y, width, height;
+};
+
+void printUsage()
+{
+  std::cerr << "Usage: multimodal_replay <scene_dir> [--config <yaml>] "
+            << "[--object-info <xml>] [--workers <n>] [--rgb-model <onnx>] [--rgb-classes <txt>]"
+            << std::endl;
+}
+
+std::string trim(const std::string &s)
+{
+  size_t begin = s.find_first_not_of(" \t\r\"'");
+  if (begin == std::string::npos)
+    return "";
+  size_t end = s.find_last_not_of(" \t\r\"'");
+  return s.substr(begin, end - begin + 1);
+}
+
+/** \brief Read the flat "key: value" parameters of a parameter yaml file, nested keys
+ * without a value (e.g. the node namespace) are skipped. */
+bool readParams(const std::string &filename, std::map<std::string, std::string> &params)
+{
+  std::ifstream file(filename.c_str());
+  if (!file)
+    return false;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    line = line.substr(0, line.find('#'));
+    size_t colon = line.find(':');
+    if (colon == std::string::npos)
+      continue;
+    std::string key = trim(line.substr(0, colon));
+    std::string value = trim(line.substr(colon + 1));
+    if (!key.empty() && !value.empty())
+      params[key] = value;
+  }
+  return true;
+}
+
+/** \brief Build the dynamic reconfigure config from the defaults and the parameter file */
+bool loadConfig(const std::string &filename, mir_object_recognition::SceneSegmentationConfig &config)
+{
+  typedef mir_object_recognition::SceneSegmentationConfig Config;
+  config = Config::__getDefault__();
+  if (filename.empty())
+    return true;
+
+  std::map<std::string, std::string> params;
+  if (!readParams(filename, params))
+  {
+    std::cerr << "Cannot read config " << filename << std::endl;
+    return false;
+  }
+
+  dynamic_reconfigure::Config msg;
+  for (const auto &description : Config::__getParamDescriptions__())
+  {
+    auto param = params.find(description->name);
+    if (param == params.end())
+      continue;
+    const std::string &value = param->second;
+    if (description->type == "bool")
+    {
+      std::string lower(value);
+      std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+      dynamic_reconfigure::ConfigTools::appendParameter(msg, description->name,
+                                                        lower == "true" || lower == "1");
+    }
+    else if (description->type == "int")
+    {
+      dynamic_reconfigure::ConfigTools::appendParameter(msg, description->name, std::stoi(value));
+    }
+    else if (description->type == "double")
+    {
+      dynamic_reconfigure::ConfigTools::appendParameter(msg, description->name, std::stod(value));
+    }
+    else
+    {
+      dynamic_reconfigure::ConfigTools::appendParameter(msg, description->name, value);
+    }
+  }
+  config.__fromMessage__(msg);
+  config.__clamp__();
+  return true;
+}
+
+/** \brief Read the non empty, non comment lines of a recorded reply, false if there is no file */
+bool readLines(const fs::path &filename, std::vector<std::string> &lines)
+{
+  std::ifstream file(filename.string().c_str());
+  if (!file)
+    return false;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    line = trim(line);
+    if (!line.empty() && line[0] != '#')
+      lines.push_back(line);
+  }
+  return true;
+}
+
+bool readImage(const fs::path &scene, sensor_msgs::ImageConstPtr &image_msg)
+{
+  for (const char *extension : {".png", ".jpg"})
+  {
+    fs::path filename = scene.string() + extension;
+    if (!fs::is_regular_file(filename))
+      continue;
+    cv::Mat image = cv::imread(filename.string(), cv::IMREAD_COLOR);
+    if (image.empty())
+      return false;
+    std_msgs::Header header;
+    header.stamp = ros::Time::now();
+    image_msg = cv_bridge::CvImage(header, sensor_msgs::image_encodings::BGR8, image).toImageMsg();
+    return true;
+  }
+  return false;
+}
+
+void printObjects(const std::string &title, const mas_perception_msgs::ObjectList &object_list)
+{
+  std::cout << "  " << title << ": " << object_list.objects.size() << std::endl;
+  for (const auto &object : object_list.objects)
+  {
+    const geometry_msgs::Point &p = object.pose.pose.position;
+    std::cout << "    " << object.name << " " << object.probability << " ["
+              << p.x << ", " << p.y << ", " << p.z << "]" << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  std::string scene_dir;
+  std::string config_file;
+  std::string object_info;
+  int num_workers = 0;
+  OnnxDetector::Params detector_params;
+  std::string rgb_classes;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg == "--config" && i + 1 < argc)
+      config_file = argv[++i];
+    else if (arg == "--object-info" && i + 1 < argc)
+      object_info = argv[++i];
+    else if (arg == "--workers" && i + 1 < argc)
+      num_workers = std::max(0, std::atoi(argv[++i]));
+    else if (arg == "--rgb-model" && i + 1 < argc)
+      detector_params.model_path = argv[++i];
+    else if (arg == "--rgb-classes" && i + 1 < argc)
+      rgb_classes = argv[++i];
+    else if (arg == "-h" || arg == "--help")
+    {
+      printUsage();
+      return 0;
+    }
+    else if (scene_dir.empty() && arg[0] != '-')
+      scene_dir = arg;
+    else
+    {
+      printUsage();
+      return 1;
+    }
+  }
+  if (scene_dir.empty() || !fs::is_directory(scene_dir))
+  {
+    printUsage();
+    return 1;
+  }
+
+  // Time stamps of the messages only, no ROS master is needed
+  ros::Time::init();
+
+  mir_object_recognition::SceneSegmentationConfig config;
+  if (!loadConfig(config_file, config))
+    return 1;
+  MultimodalObjectRecognitionPipeline pipeline(num_workers);
+  pipeline.configure(config);
+  if (!object_info.empty())
+    pipeline.loadObjectInfo(object_info);
+
+  OnnxDetector detector;
+  if (!rgb_classes.empty() && !OnnxDetector::loadClassNames(rgb_classes, detector_params.class_names))
+  {
+    std::cerr << "Cannot read " << rgb_classes << std::endl;
+    return 1;
+  }
+  if (!detector_params.model_path.empty() && !detector.load(detector_params))
+  {
+    std::cerr << "Cannot load " << detector_params.model_path << std::endl;
+    return 1;
+  }
+
+  std::vector<fs::path> scenes;
+  for (fs::directory_iterator it(scene_dir), end; it != end; ++it)
+  {
+    if (it->path().extension() == ".pcd")
+      scenes.push_back(it->path().parent_path() / it->path().stem());
+  }
+  std::sort(scenes.begin(), scenes.end());
+  if (scenes.empty())
+  {
+    std::cerr << "No scenes found in " << scene_dir << std::endl;
+    return 1;
+  }
+
+  std::vector<LatencyWindow> latency(NUM_PERCEPTION_STAGES, LatencyWindow(scenes.size()));
+  for (const auto &scene : scenes)
+  {
+    PerceptionFrame frame;
+    frame.cloud = PointCloud::Ptr(new PointCloud);
+    if (pcl::io::loadPCDFile<PointT>(scene.string() + ".pcd", *frame.cloud) != 0)
+    {
+      std::cerr << "Cannot read " << scene.string() << ".pcd, skipping" << std::endl;
+      continue;
+    }
+    if (frame.cloud->header.frame_id.empty())
+      frame.cloud->header.frame_id = "base_link";
+    readImage(scene, frame.image_msg);
+
+    PointCloud::Ptr cloud_debug;
+    pipeline.segment(frame, cloud_debug);
+
+    // Recorded rgb recognizer reply, all detections belong to the single view of the scene
+    std::vector<std::string> lines;
+    if (frame.image_msg && readLines(scene.string() + "_rgb.txt", lines))
+    {
+      for (const auto &line : lines)
+      {
+        Detection detection;
+        std::istringstream ss(line);
+        if (!(ss >> detection.label >> detection.probability >> detection.x >> detection.y >>
+              detection.width >> detection.height))
+        {
+          std::cerr << "Malformed rgb detection '" << line << "'" << std::endl;
+          continue;
+        }
+        mas_perception_msgs::Object object;
+        object.name = detection.label;
+        object.probability = detection.probability;
+        object.roi.x_offset = std::max(0, detection.x);
+        object.roi.y_offset = std::max(0, detection.y);
+        object.roi.width = std::max(0, detection.width);
+        object.roi.height = std::max(0, detection.height);
+        frame.recognized_image_list.objects.push_back(object);
+        frame.image_detection_views.push_back(frame.views.size() - 1);
+      }
+      pipeline.processRGBDetections(frame);
+    }
+    else if (frame.image_msg && detector.isLoaded())
+    {
+      StageTimer rgb_timer;
+      cv_bridge::CvImageConstPtr cv_image = cv_bridge::toCvShare(frame.image_msg);
+      detector.detect(cv_image->image, frame.image_msg->header, frame.recognized_image_list);
+      frame.stage_latency[STAGE_RGB_RECOGNIZER_WAIT] = rgb_timer.elapsed();
+      frame.image_detection_views.assign(frame.recognized_image_list.objects.size(), frame.views.size() - 1);
+      pipeline.processRGBDetections(frame);
+    }
+
+    // Recorded pc recognizer reply, labels the segmented clusters in order
+    lines.clear();
+    if (readLines(scene.string() + "_pc.txt", lines))
+    {
+      frame.recognized_cloud_list = frame.cloud_object_list;
+      for (size_t i = 0; i < lines.size() && i < frame.recognized_cloud_list.objects.size(); i++)
+      {
+        std::istringstream ss(lines[i]);
+        mas_perception_msgs::Object &object = frame.recognized_cloud_list.objects[i];
+        ss >> object.name >> object.probability;
+      }
+    }
+
+    pipeline.fuseObjects(frame);
+
+    StageTimer timer;
+    pipeline.adjustObjectPose(frame.combined_object_list, frame.workspace_height);
+    frame.stage_latency[STAGE_ADJUST_POSE] = timer.elapsed();
+    frame.stage_latency[STAGE_TOTAL] = frame.timer.elapsed();
+
+    std::cout << scene.filename().string() << ": " << frame.clusters_3d.size() << " clusters, "
+              << "workspace height " << frame.workspace_height << std::endl;
+    for (int stage = 0; stage < NUM_PERCEPTION_STAGES; stage++)
+    {
+      if (frame.stage_latency[stage] < 0.0)
+        continue;
+      latency[stage].add(frame.stage_latency[stage]);
+      std::cout << "  " << perceptionStageName(stage) << ": "
+                << frame.stage_latency[stage] * 1000.0 << " ms" << std::endl;
+    }
+    printObjects("objects", frame.combined_object_list);
+  }
+
+  std::cout << "Summary (ms):" << std::endl;
+  for (int stage = 0; stage < NUM_PERCEPTION_STAGES; stage++)
+  {
+    if (latency[stage].count() == 0)
+      continue;
+    std::cout << "  " << perceptionStageName(stage) << ": p50 " << latency[stage].percentile(50) * 1000.0
+              << " p95 " << latency[stage].percentile(95) * 1000.0
+              << " p99 " << latency[stage].percentile(99) * 1000.0
+              << " (" << latency[stage].count() << " scenes)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cmath>
+#include <limits>
+
+#include <mir_object_recognition/object_fusion.h>
+
+ObjectFusion::ObjectFusion(double radius) : radius_(radius) {}
+
+void ObjectFusion::setRadius(double radius) { radius_ = radius; }
+
+int64_t ObjectFusion::cellIndex(double value) const
+{
+  return static_cast<int64_t>(std::floor(value / radius_));
+}
+
+int64_t ObjectFusion::cellKey(int64_t cx, int64_t cy) const
+{
+  // shifted unsigned, left shifts of negative values are undefined
+  return static_cast<int64_t>((static_cast<uint64_t>(cx) << 32) ^ (static_cast<uint64_t>(cy) & 0xffffffff));
+}
+
+int ObjectFusion::fuse(const mas_perception_msgs::ObjectList &cloud_objects,
+                       const mas_perception_msgs::ObjectList &rgb_objects,
+                       mas_perception_msgs::ObjectList &fused_objects)
+{
+  fused_objects.objects.clear();
+  fused_objects.objects.reserve(cloud_objects.objects.size() + rgb_objects.objects.size());
+  if (radius_ <= 0.0)
+  {
+    fused_objects.objects.insert(fused_objects.objects.end(), cloud_objects.objects.begin(),
+                                 cloud_objects.objects.end());
+    fused_objects.objects.insert(fused_objects.objects.end(), rgb_objects.objects.begin(),
+                                 rgb_objects.objects.end());
+    return 0;
+  }
+
+  // Hash the 3D objects by the xy cell of their position
+  grid_.clear();
+  for (size_t i = 0; i < cloud_objects.objects.size(); i++)
+  {
+    const mas_perception_msgs::Object &object = cloud_objects.objects[i];
+    if (object.name == "DECOY")
+      continue;
+    const geometry_msgs::Point &p = object.pose.pose.position;
+    grid_[cellKey(cellIndex(p.x), cellIndex(p.y))].push_back(i);
+  }
+
+  // Associate every rgb object with the closest free 3D object within the radius
+  std::vector<int> cloud_match(cloud_objects.objects.size(), -1);
+  std::vector<int> rgb_match(rgb_objects.objects.size(), -1);
+  const double max_distance_sq = radius_ * radius_;
+  int num_fused = 0;
+  for (size_t j = 0; j < rgb_objects.objects.size(); j++)
+  {
+    const mas_perception_msgs::Object &object = rgb_objects.objects[j];
+    if (object.name == "DECOY")
+      continue;
+    const geometry_msgs::Point &p = object.pose.pose.position;
+    const int64_t cx = cellIndex(p.x);
+    const int64_t cy = cellIndex(p.y);
+    double best_distance_sq = std::numeric_limits<double>::max();
+    int best = -1;
+    for (int64_t dx = -1; dx <= 1; dx++)
+    {
+      for (int64_t dy = -1; dy <= 1; dy++)
+      {
+        auto cell = grid_.find(cellKey(cx + dx, cy + dy));
+        if (cell == grid_.end())
+          continue;
+        for (size_t i : cell->second)
+        {
+          if (cloud_match[i] >= 0)
+            continue;
+          const geometry_msgs::Point &q = cloud_objects.objects[i].pose.pose.position;
+          double distance_sq = (p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) +
+                               (p.z - q.z) * (p.z - q.z);
+          if (distance_sq <= max_distance_sq && distance_sq < best_distance_sq)
+          {
+            best_distance_sq = distance_sq;
+            best = static_cast<int>(i);
+          }
+        }
+      }
+    }
+    if (best >= 0)
+    {
+      cloud_match[best] = static_cast<int>(j);
+      rgb_match[j] = best;
+      num_fused++;
+    }
+  }
+
+  // Keep the order of the inputs, 3D objects first
+  for (size_t i = 0; i < cloud_objects.objects.size(); i++)
+  {
+    const mas_perception_msgs::Object &cloud_object = cloud_objects.objects[i];
+    if (cloud_match[i] < 0)
+    {
+      fused_objects.objects.push_back(cloud_object);
+      continue;
+    }
+    const mas_perception_msgs::Object &rgb_object = rgb_objects.objects[cloud_match[i]];
+    const bool rgb_wins = rgb_object.probability > cloud_object.probability;
+    mas_perception_msgs::Object fused = rgb_wins ? rgb_object : cloud_object;
+    if (cloud_object.name == rgb_object.name)
+    {
+      fused.probability = 1.0 - (1.0 - cloud_object.probability) * (1.0 - rgb_object.probability);
+    }
+    fused_objects.objects.push_back(fused);
+  }
+  for (size_t j = 0; j < rgb_objects.objects.size(); j++)
+  {
+    if (rgb_match[j] < 0)
+    {
+      fused_objects.objects.push_back(rgb_objects.objects[j]);
+    }
+  }
+  return num_fused;
+}
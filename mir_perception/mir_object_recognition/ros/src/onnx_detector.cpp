@@ -0,0 +1,202 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <ros/ros.h>
+
+#include <mir_object_recognition/onnx_detector.h>
+
+OnnxDetector::Params::Params()
+  : input_width(640),
+    input_height(640),
+    confidence_threshold(0.7),
+    nms_threshold(0.45),
+    num_threads(0)
+{
+}
+
+OnnxDetector::OnnxDetector() : loaded_(false) {}
+
+bool OnnxDetector::load(const Params &params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  params_ = params;
+  params_.input_width = std::max(params_.input_width, 32);
+  params_.input_height = std::max(params_.input_height, 32);
+  loaded_ = false;
+  try
+  {
+    net_ = cv::dnn::readNetFromONNX(params_.model_path);
+  }
+  catch (const cv::Exception &ex)
+  {
+    ROS_ERROR_STREAM("[onnx_detector] Cannot read " << params_.model_path << ": " << ex.what());
+    return false;
+  }
+  if (net_.empty())
+    return false;
+  net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+  net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+  if (params_.num_threads > 0)
+  {
+    cv::setNumThreads(params_.num_threads);
+  }
+  loaded_ = true;
+  return true;
+}
+
+std::string OnnxDetector::className(int class_id) const
+{
+  if (class_id >= 0 && class_id < static_cast<int>(params_.class_names.size()))
+    return params_.class_names[class_id];
+  return "CLASS_" + std::to_string(class_id);
+}
+
+bool OnnxDetector::detect(const cv::Mat &image, const std_msgs::Header &header,
+                          mas_perception_msgs::ObjectList &detections)
+{
+  detections.objects.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!loaded_ || image.empty())
+    return false;
+
+  // letterbox, pads with gray
+  const Letterbox box = letterbox(image.size(), cv::Size(params_.input_width, params_.input_height));
+  cv::Mat input(params_.input_height, params_.input_width, CV_8UC3, cv::Scalar(114, 114, 114));
+  cv::resize(image, input(cv::Rect(cv::Point(box.pad_x, box.pad_y), box.scaled_size)), box.scaled_size,
+             0, 0, cv::INTER_LINEAR);
+
+  cv::Mat output;
+  try
+  {
+    cv::Mat blob = cv::dnn::blobFromImage(input, 1.0 / 255.0, cv::Size(), cv::Scalar(), true, false);
+    net_.setInput(blob);
+    output = net_.forward();
+  }
+  catch (const cv::Exception &ex)
+  {
+    ROS_ERROR_STREAM("[onnx_detector] Inference failed: " << ex.what());
+    return false;
+  }
+  std::vector<Detection> boxes;
+  if (!decode(output, box, image.size(), static_cast<float>(params_.confidence_threshold),
+              static_cast<float>(params_.nms_threshold), boxes))
+  {
+    ROS_ERROR("[onnx_detector] Unexpected output shape, expected [1, N, 5 + C] or [1, 4 + C, N]");
+    return false;
+  }
+
+  detections.objects.resize(boxes.size());
+  for (size_t i = 0; i < boxes.size(); i++)
+  {
+    mas_perception_msgs::Object &object = detections.objects[i];
+    object.name = className(boxes[i].class_id);
+    std::transform(object.name.begin(), object.name.end(), object.name.begin(), ::toupper);
+    object.probability = boxes[i].score;
+    object.roi.x_offset = boxes[i].box.x;
+    object.roi.y_offset = boxes[i].box.y;
+    object.roi.width = boxes[i].box.width;
+    object.roi.height = boxes[i].box.height;
+    object.pose.header = header;
+  }
+  return true;
+}
+
+OnnxDetector::Letterbox OnnxDetector::letterbox(const cv::Size &image_size, const cv::Size &input_size)
+{
+  Letterbox letterbox;
+  letterbox.scale = std::min(static_cast<double>(input_size.width) / image_size.width,
+                             static_cast<double>(input_size.height) / image_size.height);
+  letterbox.scaled_size = cv::Size(static_cast<int>(image_size.width * letterbox.scale + 0.5),
+                                   static_cast<int>(image_size.height * letterbox.scale + 0.5));
+  letterbox.pad_x = (input_size.width - letterbox.scaled_size.width) / 2;
+  letterbox.pad_y = (input_size.height - letterbox.scaled_size.height) / 2;
+  return letterbox;
+}
+
+bool OnnxDetector::decode(const cv::Mat &output, const Letterbox &letterbox, const cv::Size &image_size,
+                          float confidence_threshold, float nms_threshold,
+                          std::vector<Detection> &detections)
+{
+  detections.clear();
+  if (output.dims != 3 || output.size[0] != 1 || output.type() != CV_32F)
+    return false;
+
+  // rows are the boxes, [1, 4 + C, N] outputs have fewer attributes than boxes
+  cv::Mat rows(output.size[1], output.size[2], CV_32F, const_cast<float *>(output.ptr<float>()));
+  const bool transposed = output.size[1] < output.size[2];
+  if (transposed)
+  {
+    rows = rows.t();
+  }
+  const int num_attributes = rows.cols;
+  const int class_offset = transposed ? 4 : 5;
+  const int num_classes = num_attributes - class_offset;
+  if (num_classes < 1)
+    return false;
+
+  std::vector<Detection> candidates;
+  std::vector<float> scores;
+  for (int i = 0; i < rows.rows; i++)
+  {
+    const float *row = rows.ptr<float>(i);
+    const float objectness = transposed ? 1.0f : row[4];
+    if (objectness < confidence_threshold)
+      continue;
+    const float *class_scores = row + class_offset;
+    Detection detection;
+    detection.class_id =
+        static_cast<int>(std::max_element(class_scores, class_scores + num_classes) - class_scores);
+    detection.score = objectness * class_scores[detection.class_id];
+    if (detection.score < confidence_threshold)
+      continue;
+    // center and size in the letterboxed input to the corner in the image
+    const float x = (row[0] - 0.5f * row[2] - letterbox.pad_x) / letterbox.scale;
+    const float y = (row[1] - 0.5f * row[3] - letterbox.pad_y) / letterbox.scale;
+    detection.box = cv::Rect(static_cast<int>(x), static_cast<int>(y),
+                             static_cast<int>(row[2] / letterbox.scale),
+                             static_cast<int>(row[3] / letterbox.scale));
+    detection.box &= cv::Rect(cv::Point(0, 0), image_size);
+    if (detection.box.area() <= 0)
+      continue;
+    candidates.push_back(detection);
+    scores.push_back(detection.score);
+  }
+
+  // per class suppression, the boxes of each class are offset so that they never overlap
+  std::vector<cv::Rect> offset_boxes(candidates.size());
+  const int offset = std::max(image_size.width, image_size.height) + 1;
+  for (size_t i = 0; i < candidates.size(); i++)
+  {
+    offset_boxes[i] = candidates[i].box + cv::Point(candidates[i].class_id * offset, 0);
+  }
+  std::vector<int> keep;
+  cv::dnn::NMSBoxes(offset_boxes, scores, confidence_threshold, nms_threshold, keep);
+  for (int i : keep)
+  {
+    detections.push_back(candidates[i]);
+  }
+  return true;
+}
+
+bool OnnxDetector::loadClassNames(const std::string &filename, std::vector<std::string> &class_names)
+{
+  std::ifstream file(filename);
+  if (!file)
+    return false;
+  class_names.clear();
+  std::string line;
+  while (std::getline(file, line))
+  {
+    line.erase(0, line.find_first_not_of(" \t\r"));
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    if (line.empty() || line[0] == '#')
+      continue;
+    class_names.push_back(line);
+  }
+  return true;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <mir_object_recognition/perceived_object_store.h>
+
+namespace
+{
+struct BlockSum
+{
+  BlockSum() : count(0), sum_x(0.0), sum_y(0.0), sum_z(0.0) {}
+
+  int count;
+  double sum_x;
+  double sum_y;
+  double sum_z;
+};
+
+uint64_t mixHash(uint64_t value)
+{
+  // splitmix64 finalizer
+  value += 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+double angleDifference(double a, double b)
+{
+  return std::abs(std::atan2(std::sin(a - b), std::cos(a - b)));
+}
+
+/** \brief Rotate the poses by yaw around z, then translate them by x, y */
+void transformPlanar(double x, double y, double yaw, mas_perception_msgs::ObjectList &object_list)
+{
+  const double c = std::cos(yaw);
+  const double s = std::sin(yaw);
+  // quaternion of the rotation around z
+  const double qz = std::sin(yaw / 2.0);
+  const double qw = std::cos(yaw / 2.0);
+  for (auto &object : object_list.objects)
+  {
+    geometry_msgs::Pose &pose = object.pose.pose;
+    const double px = pose.position.x;
+    const double py = pose.position.y;
+    pose.position.x = c * px - s * py + x;
+    pose.position.y = s * px + c * py + y;
+    const geometry_msgs::Quaternion q = pose.orientation;
+    pose.orientation.w = qw * q.w - qz * q.z;
+    pose.orientation.x = qw * q.x - qz * q.y;
+    pose.orientation.y = qw * q.y + qz * q.x;
+    pose.orientation.z = qw * q.z + qz * q.w;
+  }
+}
+}  // namespace
+
+SceneSignature::SceneSignature() : rows(0), cols(0), occupancy_hash(0) {}
+
+PerceivedObjectStore::Params::Params()
+  : enable(true),
+    max_age(300.0),
+    block_size(16),
+    depth_tolerance(0.01),
+    max_changed_ratio(0.002),
+    occupancy_cell_size(0.05),
+    max_translation(0.05),
+    max_rotation(0.05),
+    max_entries(32)
+{
+}
+
+PerceivedObjectStore::PerceivedObjectStore() {}
+
+void PerceivedObjectStore::setParams(const Params &params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool recompute = params.block_size != params_.block_size ||
+                         params.occupancy_cell_size != params_.occupancy_cell_size;
+  params_ = params;
+  params_.block_size = std::max(params_.block_size, 1);
+  params_.occupancy_cell_size = std::max(params_.occupancy_cell_size, 1e-3);
+  params_.max_entries = std::max<size_t>(params_.max_entries, 1);
+  // the stored signatures cannot be compared to new ones anymore
+  if (recompute || !params_.enable)
+  {
+    entries_.clear();
+  }
+}
+
+SceneSignature PerceivedObjectStore::computeSignature(const PointCloud &cloud) const
+{
+  int block_size;
+  double cell_size;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    block_size = params_.block_size;
+    cell_size = params_.occupancy_cell_size;
+  }
+
+  SceneSignature signature;
+  if (cloud.height <= 1 || cloud.width == 0)
+    return signature;
+  signature.rows = (static_cast<int>(cloud.height) + block_size - 1) / block_size;
+  signature.cols = (static_cast<int>(cloud.width) + block_size - 1) / block_size;
+
+  std::vector<BlockSum> blocks(signature.rows * signature.cols);
+  for (int row = 0; row < static_cast<int>(cloud.height); row++)
+  {
+    BlockSum *block_row = &blocks[(row / block_size) * signature.cols];
+    const PointT *points = &cloud.points[row * cloud.width];
+    for (int col = 0; col < static_cast<int>(cloud.width); col++)
+    {
+      const PointT &point = points[col];
+      if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+        continue;
+      BlockSum &block = block_row[col / block_size];
+      block.count++;
+      block.sum_x += point.x;
+      block.sum_y += point.y;
+      block.sum_z += point.z;
+    }
+  }
+
+  // blocks with less than a quarter of valid points are not compared
+  const int min_count = std::max(1, block_size * block_size / 4);
+  signature.heights.resize(blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    const BlockSum &block = blocks[i];
+    if (block.count < min_count)
+    {
+      signature.heights[i] = std::numeric_limits<float>::quiet_NaN();
+      continue;
+    }
+    signature.heights[i] = static_cast<float>(block.sum_z / block.count);
+    const int64_t cx = static_cast<int64_t>(std::floor(block.sum_x / block.count / cell_size));
+    const int64_t cy = static_cast<int64_t>(std::floor(block.sum_y / block.count / cell_size));
+    const int64_t cz = static_cast<int64_t>(std::floor(block.sum_z / block.count / cell_size));
+    // the sum over the blocks does not depend on their order, every block adds its cell
+    const uint64_t key = (static_cast<uint64_t>(cx & 0x1fffff) << 42) |
+                         (static_cast<uint64_t>(cy & 0x1fffff) << 21) |
+                         static_cast<uint64_t>(cz & 0x1fffff);
+    signature.occupancy_hash += mixHash(key);
+  }
+  return signature;
+}
+
+double PerceivedObjectStore::changedRatio(const SceneSignature &a, const SceneSignature &b) const
+{
+  if (a.rows != b.rows || a.cols != b.cols || a.heights.empty())
+    return 1.0;
+  int compared = 0;
+  int changed = 0;
+  for (size_t i = 0; i < a.heights.size(); i++)
+  {
+    const bool valid_a = std::isfinite(a.heights[i]);
+    const bool valid_b = std::isfinite(b.heights[i]);
+    if (!valid_a && !valid_b)
+      continue;
+    compared++;
+    if (valid_a != valid_b || std::abs(a.heights[i] - b.heights[i]) > params_.depth_tolerance)
+      changed++;
+  }
+  return compared > 0 ? static_cast<double>(changed) / compared : 1.0;
+}
+
+bool PerceivedObjectStore::lookup(const std::string &workstation, const SceneSignature &signature,
+                                  const RobotPose &robot_pose, double stamp, Entry &entry,
+                                  double &changed_ratio)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  changed_ratio = 1.0;
+  if (!params_.enable)
+    return false;
+  auto it = entries_.find(workstation);
+  if (it == entries_.end())
+    return false;
+  const Entry &stored = it->second;
+  if (stamp - stored.stamp > params_.max_age)
+  {
+    entries_.erase(it);
+    return false;
+  }
+  // the blocks are only comparable from the same viewpoint
+  if (!robot_pose.valid || !stored.robot_pose.valid ||
+      std::hypot(robot_pose.x - stored.robot_pose.x, robot_pose.y - stored.robot_pose.y) >
+          params_.max_translation ||
+      angleDifference(robot_pose.yaw, stored.robot_pose.yaw) > params_.max_rotation)
+  {
+    return false;
+  }
+  if (signature.rows == stored.signature.rows && signature.cols == stored.signature.cols &&
+      !signature.heights.empty() && signature.occupancy_hash == stored.signature.occupancy_hash)
+  {
+    changed_ratio = 0.0;
+  }
+  else
+  {
+    changed_ratio = changedRatio(signature, stored.signature);
+  }
+  if (changed_ratio > params_.max_changed_ratio)
+    return false;
+  entry = stored;
+  return true;
+}
+
+void PerceivedObjectStore::insert(const std::string &workstation, const Entry &entry)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!params_.enable)
+    return;
+  entries_[workstation] = entry;
+  while (entries_.size() > params_.max_entries)
+  {
+    auto oldest = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it)
+    {
+      if (it->second.stamp < oldest->second.stamp)
+        oldest = it;
+    }
+    entries_.erase(oldest);
+  }
+}
+
+void PerceivedObjectStore::erase(const std::string &workstation)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.erase(workstation);
+}
+
+void PerceivedObjectStore::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+size_t PerceivedObjectStore::size()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void PerceivedObjectStore::toFixedFrame(const RobotPose &robot_pose, mas_perception_msgs::ObjectList &object_list)
+{
+  transformPlanar(robot_pose.x, robot_pose.y, robot_pose.yaw, object_list);
+}
+
+void PerceivedObjectStore::toRobotFrame(const RobotPose &robot_pose, mas_perception_msgs::ObjectList &object_list)
+{
+  // inverse of the robot pose: rotate by -yaw after translating by -x, -y
+  const double c = std::cos(robot_pose.yaw);
+  const double s = std::sin(robot_pose.yaw);
+  transformPlanar(-c * robot_pose.x - s * robot_pose.y, s * robot_pose.x - c * robot_pose.y,
+                  -robot_pose.yaw, object_list);
+}
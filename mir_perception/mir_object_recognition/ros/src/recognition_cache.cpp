@@ -0,0 +1,227 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <mir_object_recognition/recognition_cache.h>
+
+ClusterFingerprint::ClusterFingerprint()
+  : centroid(Eigen::Vector3f::Zero()), extent(Eigen::Vector3f::Zero()), num_points(0)
+{
+  histogram.fill(0.0f);
+}
+
+ClusterFingerprint::ClusterFingerprint(const PointCloud &cluster) : ClusterFingerprint()
+{
+  Eigen::Vector3f min_pt = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max_pt = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+  // 256 intensity levels to BINS_PER_CHANNEL (4) bins
+  const int shift = 6;
+  for (const auto &point : cluster.points)
+  {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+      continue;
+    Eigen::Vector3f p(point.x, point.y, point.z);
+    centroid += p;
+    min_pt = min_pt.cwiseMin(p);
+    max_pt = max_pt.cwiseMax(p);
+    int bin = ((point.r >> shift) * BINS_PER_CHANNEL + (point.g >> shift)) * BINS_PER_CHANNEL +
+              (point.b >> shift);
+    histogram[bin] += 1.0f;
+    num_points++;
+  }
+  if (num_points == 0)
+    return;
+  centroid /= static_cast<float>(num_points);
+  extent = max_pt - min_pt;
+  for (auto &bin : histogram)
+  {
+    bin /= static_cast<float>(num_points);
+  }
+}
+
+void ClusterFingerprint::transform(const Eigen::Affine3f &transform)
+{
+  centroid = transform * centroid;
+}
+
+RecognitionCache::Params::Params()
+  : enable(true),
+    max_age(60.0),
+    centroid_tolerance(0.02),
+    extent_tolerance(0.01),
+    point_count_tolerance(0.3),
+    max_histogram_distance(0.25),
+    max_entries(256)
+{
+}
+
+RecognitionCache::RecognitionCache() {}
+
+void RecognitionCache::setParams(const Params &params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool rehash = params.centroid_tolerance != params_.centroid_tolerance;
+  params_ = params;
+  params_.centroid_tolerance = std::max(params_.centroid_tolerance, 1e-3);
+  params_.max_entries = std::max<size_t>(params_.max_entries, 1);
+  // the cell size changed, the keys of the entries are not valid anymore
+  if (rehash || !params_.enable)
+  {
+    entries_.clear();
+    grid_.clear();
+  }
+  while (entries_.size() > params_.max_entries)
+  {
+    erase(entries_.begin());
+  }
+}
+
+bool RecognitionCache::isEnabled()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return params_.enable;
+}
+
+int64_t RecognitionCache::cellIndex(double value) const
+{
+  return static_cast<int64_t>(std::floor(value / params_.centroid_tolerance));
+}
+
+int64_t RecognitionCache::cellKey(int64_t cx, int64_t cy, int64_t cz) const
+{
+  return ((cx & 0x1fffff) << 42) ^ ((cy & 0x1fffff) << 21) ^ (cz & 0x1fffff);
+}
+
+bool RecognitionCache::matches(const ClusterFingerprint &a, const ClusterFingerprint &b) const
+{
+  if ((a.centroid - b.centroid).norm() > params_.centroid_tolerance)
+    return false;
+  if (((a.extent - b.extent).cwiseAbs().array() > params_.extent_tolerance).any())
+    return false;
+  double count_difference = std::abs(static_cast<double>(a.num_points) - static_cast<double>(b.num_points));
+  if (count_difference > params_.point_count_tolerance * std::max<size_t>(b.num_points, 1))
+    return false;
+  double histogram_distance = 0.0;
+  for (int i = 0; i < ClusterFingerprint::HISTOGRAM_SIZE; i++)
+  {
+    histogram_distance += std::abs(a.histogram[i] - b.histogram[i]);
+  }
+  return 0.5 * histogram_distance <= params_.max_histogram_distance;
+}
+
+RecognitionCache::EntryIt RecognitionCache::find(const ClusterFingerprint &fingerprint,
+                                                 const Clock::time_point &now)
+{
+  const int64_t cx = cellIndex(fingerprint.centroid.x());
+  const int64_t cy = cellIndex(fingerprint.centroid.y());
+  const int64_t cz = cellIndex(fingerprint.centroid.z());
+  const Clock::duration max_age = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(params_.max_age));
+  EntryIt best = entries_.end();
+  float best_distance = std::numeric_limits<float>::max();
+  for (int64_t dx = -1; dx <= 1; dx++)
+  {
+    for (int64_t dy = -1; dy <= 1; dy++)
+    {
+      for (int64_t dz = -1; dz <= 1; dz++)
+      {
+        auto range = grid_.equal_range(cellKey(cx + dx, cy + dy, cz + dz));
+        for (auto cell = range.first; cell != range.second; ++cell)
+        {
+          const Entry &entry = *cell->second;
+          if (now - entry.time > max_age || !matches(fingerprint, entry.fingerprint))
+            continue;
+          float distance = (fingerprint.centroid - entry.fingerprint.centroid).norm();
+          if (distance < best_distance)
+          {
+            best_distance = distance;
+            best = cell->second;
+          }
+        }
+      }
+    }
+  }
+  return best;
+}
+
+void RecognitionCache::erase(EntryIt entry)
+{
+  auto range = grid_.equal_range(entry->key);
+  for (auto cell = range.first; cell != range.second; ++cell)
+  {
+    if (cell->second == entry)
+    {
+      grid_.erase(cell);
+      break;
+    }
+  }
+  entries_.erase(entry);
+}
+
+void RecognitionCache::evictExpired(const Clock::time_point &now)
+{
+  const Clock::duration max_age = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(params_.max_age));
+  while (!entries_.empty() && now - entries_.front().time > max_age)
+  {
+    erase(entries_.begin());
+  }
+}
+
+bool RecognitionCache::lookup(const ClusterFingerprint &fingerprint, Label &label)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!params_.enable || fingerprint.num_points == 0)
+    return false;
+  const Clock::time_point now = Clock::now();
+  evictExpired(now);
+  EntryIt entry = find(fingerprint, now);
+  if (entry == entries_.end())
+    return false;
+  label = entry->label;
+  return true;
+}
+
+void RecognitionCache::insert(const ClusterFingerprint &fingerprint, const Label &label)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!params_.enable || fingerprint.num_points == 0 || label.name.empty())
+    return;
+  const Clock::time_point now = Clock::now();
+  evictExpired(now);
+  // the newer recognition of the same cluster replaces the old one
+  EntryIt old_entry = find(fingerprint, now);
+  if (old_entry != entries_.end())
+  {
+    erase(old_entry);
+  }
+  if (entries_.size() >= params_.max_entries)
+  {
+    erase(entries_.begin());
+  }
+
+  Entry entry;
+  entry.fingerprint = fingerprint;
+  entry.label = label;
+  entry.time = now;
+  entry.key = cellKey(cellIndex(fingerprint.centroid.x()), cellIndex(fingerprint.centroid.y()),
+                      cellIndex(fingerprint.centroid.z()));
+  entries_.push_back(entry);
+  grid_.emplace(entry.key, std::prev(entries_.end()));
+}
+
+void RecognitionCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  grid_.clear();
+}
+
+size_t RecognitionCache::size()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
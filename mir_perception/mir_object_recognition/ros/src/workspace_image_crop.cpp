@@ -0,0 +1,172 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <ros/ros.h>
+
+#include <mir_object_recognition/workspace_image_crop.h>
+
+void ImageCrop::toFullFrame(sensor_msgs::RegionOfInterest &roi) const
+{
+  int x_min = x_offset + static_cast<int>(std::floor(roi.x_offset / scale));
+  int y_min = y_offset + static_cast<int>(std::floor(roi.y_offset / scale));
+  int x_max = x_offset + static_cast<int>(std::ceil((roi.x_offset + roi.width) / scale));
+  int y_max = y_offset + static_cast<int>(std::ceil((roi.y_offset + roi.height) / scale));
+  if (full_width > 0 && full_height > 0)
+  {
+    x_min = std::min(std::max(x_min, 0), full_width);
+    y_min = std::min(std::max(y_min, 0), full_height);
+    x_max = std::min(std::max(x_max, x_min), full_width);
+    y_max = std::min(std::max(y_max, y_min), full_height);
+  }
+  roi.x_offset = x_min;
+  roi.y_offset = y_min;
+  roi.width = x_max - x_min;
+  roi.height = y_max - y_min;
+}
+
+WorkspaceImageCrop::Params::Params()
+  : crop_to_workspace(false), margin(16), max_size(0), max_height(0.1), stride(4)
+{
+}
+
+WorkspaceImageCrop::WorkspaceImageCrop() {}
+
+void WorkspaceImageCrop::setParams(const Params &params)
+{
+  params_ = params;
+  params_.margin = std::max(params_.margin, 0);
+  params_.max_size = std::max(params_.max_size, 0);
+  params_.stride = std::max(params_.stride, 1);
+}
+
+bool WorkspaceImageCrop::workspaceRect(const PointCloud &cloud, const PointCloud &hull,
+                                       const Eigen::Vector3f &normal, cv::Rect &rect) const
+{
+  if (cloud.height <= 1 || hull.points.size() < 3 || normal.norm() < 1e-6)
+    return false;
+
+  // 2D polygon of the hull in the plane
+  const Eigen::Vector3f n = normal.normalized();
+  Eigen::Vector3f origin = Eigen::Vector3f::Zero();
+  for (const auto &point : hull.points)
+  {
+    origin += point.getVector3fMap();
+  }
+  origin /= static_cast<float>(hull.points.size());
+  const Eigen::Vector3f u = n.unitOrthogonal();
+  const Eigen::Vector3f v = n.cross(u);
+  std::vector<Eigen::Vector2f> polygon;
+  polygon.reserve(hull.points.size());
+  for (const auto &point : hull.points)
+  {
+    const Eigen::Vector3f p = point.getVector3fMap() - origin;
+    polygon.emplace_back(u.dot(p), v.dot(p));
+  }
+
+  const int stride = params_.stride;
+  int min_col = cloud.width, min_row = cloud.height, max_col = -1, max_row = -1;
+  for (int row = 0; row < static_cast<int>(cloud.height); row += stride)
+  {
+    for (int col = 0; col < static_cast<int>(cloud.width); col += stride)
+    {
+      const PointT &point = cloud.points[row * cloud.width + col];
+      if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+        continue;
+      const Eigen::Vector3f p = point.getVector3fMap() - origin;
+      if (std::abs(n.dot(p)) > params_.max_height)
+        continue;
+      // crossing number test, the hull is an ordered polygon
+      const float x = u.dot(p);
+      const float y = v.dot(p);
+      bool inside = false;
+      for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+      {
+        const Eigen::Vector2f &a = polygon[i];
+        const Eigen::Vector2f &b = polygon[j];
+        if ((a.y() > y) != (b.y() > y) && x < (b.x() - a.x()) * (y - a.y()) / (b.y() - a.y()) + a.x())
+          inside = !inside;
+      }
+      if (!inside)
+        continue;
+      min_col = std::min(min_col, col);
+      max_col = std::max(max_col, col);
+      min_row = std::min(min_row, row);
+      max_row = std::max(max_row, row);
+    }
+  }
+  if (max_col < 0)
+    return false;
+
+  // the grid cells of the boundary pixels are part of the workspace too
+  const int margin = params_.margin;
+  const int x_min = std::max(min_col - margin, 0);
+  const int y_min = std::max(min_row - margin, 0);
+  const int x_max = std::min<int>(max_col + stride + margin, cloud.width);
+  const int y_max = std::min<int>(max_row + stride + margin, cloud.height);
+  rect = cv::Rect(x_min, y_min, x_max - x_min, y_max - y_min);
+  return rect.area() > 0;
+}
+
+bool WorkspaceImageCrop::crop(const sensor_msgs::ImageConstPtr &image, const PointCloud &cloud,
+                              const PointCloud &hull, const Eigen::Vector3f &normal,
+                              sensor_msgs::ImagePtr &cropped, ImageCrop &image_crop,
+                              int cloud_stride) const
+{
+  if (!image || image->width == 0 || image->height == 0)
+    return false;
+  const int width = image->width;
+  const int height = image->height;
+  const int stride = std::max(cloud_stride, 1);
+  cv::Rect rect(0, 0, width, height);
+  // the cloud must be registered to the image, the pixel of a point is its index times
+  // the stride
+  if (params_.crop_to_workspace && static_cast<int>(cloud.width) == (width + stride - 1) / stride &&
+      static_cast<int>(cloud.height) == (height + stride - 1) / stride)
+  {
+    if (workspaceRect(cloud, hull, normal, rect))
+    {
+      rect = cv::Rect(rect.x * stride, rect.y * stride, rect.width * stride, rect.height * stride) &
+             cv::Rect(0, 0, width, height);
+    }
+    else
+    {
+      ROS_DEBUG("[WorkspaceImageCrop] Workspace not found in the image, sending the full image");
+      rect = cv::Rect(0, 0, width, height);
+    }
+  }
+  const int max_side = std::max(rect.width, rect.height);
+  const double scale = params_.max_size > 0 && max_side > params_.max_size ?
+                       static_cast<double>(params_.max_size) / max_side : 1.0;
+  if (rect.width == width && rect.height == height && scale == 1.0)
+    return false;
+
+  cv_bridge::CvImageConstPtr cv_image;
+  try
+  {
+    cv_image = cv_bridge::toCvShare(image);
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+    return false;
+  }
+  cv_bridge::CvImage out(image->header, image->encoding);
+  if (scale < 1.0)
+    cv::resize(cv_image->image(rect), out.image, cv::Size(), scale, scale, cv::INTER_AREA);
+  else
+    out.image = cv_image->image(rect);
+  cropped = out.toImageMsg();
+
+  image_crop.x_offset = rect.x;
+  image_crop.y_offset = rect.y;
+  image_crop.scale = rect.width > 0 ? static_cast<double>(out.image.cols) / rect.width : 1.0;
+  image_crop.full_width = width;
+  image_crop.full_height = height;
+  return true;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/bounded_queue.h>
+
+TEST(BoundedQueue, DropsTheOldestElements)
+{
+  BoundedQueue<int> queue(3, true);
+  for (int i = 0; i < 3; i++)
+  {
+    EXPECT_EQ(queue.push(i), 0u);
+  }
+  EXPECT_EQ(queue.push(3), 1u);
+  EXPECT_EQ(queue.push(4), 1u);
+  EXPECT_EQ(queue.size(), 3u);
+
+  int item = -1;
+  for (int expected = 2; expected <= 4; expected++)
+  {
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, expected);
+  }
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(BoundedQueue, ZeroCapacityKeepsOneElement)
+{
+  BoundedQueue<int> queue(0, true);
+  EXPECT_EQ(queue.push(1), 0u);
+  EXPECT_EQ(queue.push(2), 1u);
+  int item = -1;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 2);
+}
+
+TEST(BoundedQueue, PushBlocksUntilPopped)
+{
+  BoundedQueue<int> queue(1, false);
+  EXPECT_EQ(queue.push(1), 0u);
+
+  std::atomic<bool> pushed(false);
+  std::thread producer([&] {
+    queue.push(2);
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+
+  int item = -1;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 1);
+  producer.join();
+  EXPECT_TRUE(pushed);
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 2);
+}
+
+TEST(BoundedQueue, CloseWakesBlockedThreads)
+{
+  BoundedQueue<int> empty_queue(1, false);
+  bool popped = true;
+  std::thread consumer([&] {
+    int item;
+    popped = empty_queue.pop(item);
+  });
+
+  BoundedQueue<int> full_queue(1, false);
+  full_queue.push(1);
+  std::thread producer([&] { full_queue.push(2); });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  empty_queue.close();
+  full_queue.close();
+  consumer.join();
+  producer.join();
+  EXPECT_FALSE(popped);
+
+  // the queued element is still popped, the blocked push is discarded
+  int item = -1;
+  ASSERT_TRUE(full_queue.pop(item));
+  EXPECT_EQ(item, 1);
+  EXPECT_FALSE(full_queue.pop(item));
+  EXPECT_EQ(full_queue.push(3), 0u);
+  EXPECT_EQ(full_queue.size(), 0u);
+}
+
+TEST(BoundedQueue, ResetReopensTheQueue)
+{
+  BoundedQueue<int> queue(2, true);
+  queue.push(1);
+  queue.close();
+  queue.reset();
+  EXPECT_EQ(queue.size(), 0u);
+
+  queue.push(2);
+  int item = -1;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 2);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/cluster_cloud_transport.h>
+
+class SharedMemoryRingTest : public ::testing::Test
+{
+  protected:
+    static const size_t CAPACITY = 256;
+
+    SharedMemoryRingTest()
+      : name_("/test_shm_ring_" + std::to_string(getpid())), segment_(MAP_FAILED)
+    {
+    }
+
+    ~SharedMemoryRingTest()
+    {
+      if (segment_ != MAP_FAILED)
+        munmap(segment_, SharedMemoryRing::DATA_OFFSET + CAPACITY);
+    }
+
+    /** \brief Create the ring and map its segment as a reader does */
+    void SetUp() override
+    {
+      ASSERT_TRUE(ring_.create(name_, CAPACITY));
+      int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+      ASSERT_GE(fd, 0);
+      segment_ = mmap(nullptr, SharedMemoryRing::DATA_OFFSET + CAPACITY, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      ASSERT_NE(segment_, MAP_FAILED);
+    }
+
+    const SharedMemoryRing::Header &header() const
+    {
+      return *static_cast<const SharedMemoryRing::Header *>(segment_);
+    }
+
+    /** \brief Write a record of size bytes, all set to value */
+    bool write(size_t size, uint8_t value, uint64_t &position)
+    {
+      const std::vector<uint8_t> record(size, value);
+      return ring_.write(record.data(), size, position);
+    }
+
+    /** \brief Copy a record as the recognizer does (shm_cloud.py)
+     * \return False if the record was overwritten */
+    bool read(uint64_t position, size_t size, std::vector<uint8_t> &record) const
+    {
+      if (position + size > header().write_position.load())
+        return false;
+      const uint8_t *data = static_cast<const uint8_t *>(segment_) + SharedMemoryRing::DATA_OFFSET;
+      record.assign(data + position % CAPACITY, data + position % CAPACITY + size);
+      return header().write_position.load() <= position + CAPACITY;
+    }
+
+    std::string name_;
+    SharedMemoryRing ring_;
+    void *segment_;
+};
+
+const size_t SharedMemoryRingTest::CAPACITY;
+
+TEST_F(SharedMemoryRingTest, Header)
+{
+  EXPECT_EQ(header().magic, SharedMemoryRing::MAGIC);
+  EXPECT_EQ(header().version, SharedMemoryRing::VERSION);
+  EXPECT_EQ(header().capacity, CAPACITY);
+  EXPECT_EQ(header().data_offset, SharedMemoryRing::DATA_OFFSET);
+  EXPECT_EQ(header().write_position.load(), 0u);
+  EXPECT_EQ(ring_.name(), name_);
+  EXPECT_EQ(ring_.capacity(), CAPACITY);
+}
+
+TEST_F(SharedMemoryRingTest, AlignsRecords)
+{
+  uint64_t position;
+  ASSERT_TRUE(write(10, 1, position));
+  EXPECT_EQ(position, 0u);
+  ASSERT_TRUE(write(10, 2, position));
+  EXPECT_EQ(position, 16u);
+  EXPECT_EQ(header().write_position.load(), 26u);
+
+  std::vector<uint8_t> record;
+  ASSERT_TRUE(read(16, 10, record));
+  EXPECT_EQ(record, std::vector<uint8_t>(10, 2));
+}
+
+TEST_F(SharedMemoryRingTest, RecordsDoNotWrapAround)
+{
+  uint64_t first, second, third;
+  ASSERT_TRUE(write(100, 1, first));
+  ASSERT_TRUE(write(100, 2, second));
+  EXPECT_EQ(second, 104u);
+  // 208 + 100 does not fit before the end, the record starts the next lap
+  ASSERT_TRUE(write(100, 3, third));
+  EXPECT_EQ(third, CAPACITY);
+  EXPECT_EQ(header().write_position.load(), CAPACITY + 100);
+
+  std::vector<uint8_t> record;
+  ASSERT_TRUE(read(third, 100, record));
+  EXPECT_EQ(record, std::vector<uint8_t>(100, 3));
+  // the first record was overwritten, the second is intact
+  EXPECT_FALSE(read(first, 100, record));
+  ASSERT_TRUE(read(second, 100, record));
+  EXPECT_EQ(record, std::vector<uint8_t>(100, 2));
+
+  // 360 is not aligned, the record starts at 360 % 256 = 104
+  uint64_t fourth;
+  ASSERT_TRUE(write(4, 4, fourth));
+  EXPECT_EQ(fourth, CAPACITY + 104);
+  EXPECT_FALSE(read(second, 100, record));
+  ASSERT_TRUE(read(third, 100, record));
+}
+
+TEST_F(SharedMemoryRingTest, RejectsLargeRecords)
+{
+  uint64_t position = 7;
+  EXPECT_FALSE(write(CAPACITY / 2 + 1, 1, position));
+  EXPECT_FALSE(write(0, 1, position));
+  EXPECT_EQ(position, 7u);
+  EXPECT_EQ(header().write_position.load(), 0u);
+  ASSERT_TRUE(write(CAPACITY / 2, 1, position));
+  EXPECT_EQ(position, 0u);
+
+  SharedMemoryRing closed;
+  EXPECT_FALSE(closed.isOpen());
+  EXPECT_FALSE(closed.write(&position, sizeof(position), position));
+}
+
+TEST(ClusterCloudTransport, EncodesAHandle)
+{
+  ClusterCloudTransport transport;
+  PointCloud cluster;
+  cluster.points.resize(3);
+  cluster.width = 3;
+  cluster.height = 1;
+  std_msgs::Header header;
+  header.frame_id = "base_link";
+  sensor_msgs::PointCloud2 handle;
+  EXPECT_FALSE(transport.encode(cluster, header, handle));
+
+  const std::string name = "/test_cluster_clouds_" + std::to_string(getpid());
+  ASSERT_TRUE(transport.open(name, 1 << 16));
+  ASSERT_TRUE(transport.encode(cluster, header, handle));
+  ASSERT_TRUE(transport.encode(cluster, header, handle));
+  EXPECT_EQ(handle.header.frame_id, "base_link");
+  EXPECT_EQ(handle.width, 3u);
+  EXPECT_EQ(handle.point_step, sizeof(PointT));
+  EXPECT_TRUE(handle.data.empty());
+  const sensor_msgs::PointField &field = handle.fields.back();
+  EXPECT_EQ(field.name, ClusterCloudTransport::HANDLE_PREFIX + name.substr(1));
+  EXPECT_EQ(field.datatype, 0);
+  // the second record, 8 byte aligned
+  EXPECT_EQ(field.offset, (3 * sizeof(PointT) + 7) / 8 * 8);
+  EXPECT_EQ(field.count, 0u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/container_rim_estimator.h>
+
+class ContainerRimEstimatorTest : public ::testing::Test
+{
+  protected:
+    /** \brief Open container seen from above: a floor of 16 x 24 cm at z = 0 centered at
+     * (0.6, 0.1) and walls of 8 cm, their top is the rim, sampled every 2.5 mm */
+    ContainerRimEstimatorTest() : cloud_(new PointCloud), normals_(new PointCloudN)
+    {
+      const float step = 0.0025f;
+      const int cols = 64;
+      const int rows = 96;
+      for (int row = 0; row <= rows; row++)
+      {
+        for (int col = 0; col <= cols; col++)
+        {
+          addPoint(0.52f + step * col, -0.02f + step * row, 0.0f, 1.0f);
+        }
+      }
+      // the long walls along y at both ends of x, then the short walls along x
+      for (int k = 1; k <= 32; k++)
+      {
+        const float z = step * k;
+        for (int row = 0; row <= rows; row++)
+        {
+          addPoint(0.52f, -0.02f + step * row, z, 0.0f);
+          addPoint(0.68f, -0.02f + step * row, z, 0.0f);
+        }
+        for (int col = 1; col < cols; col++)
+        {
+          addPoint(0.52f + step * col, -0.02f, z, 0.0f);
+          addPoint(0.52f + step * col, 0.22f, z, 0.0f);
+        }
+      }
+      cloud_->width = static_cast<uint32_t>(cloud_->points.size());
+      cloud_->height = 1;
+    }
+
+    void addPoint(float x, float y, float z, float normal_z)
+    {
+      PointT point;
+      point.x = x;
+      point.y = y;
+      point.z = z;
+      cloud_->points.push_back(point);
+      PointNT normal;
+      normal.normal_x = 1.0f - normal_z;
+      normal.normal_z = normal_z;
+      normals_->points.push_back(normal);
+    }
+
+    ContainerRimEstimator estimator_;
+    PointCloud::Ptr cloud_;
+    PointCloudN::Ptr normals_;
+    Eigen::Vector3f center_;
+    float rim_height_;
+};
+
+TEST_F(ContainerRimEstimatorTest, FindsTheFloorCenter)
+{
+  ASSERT_TRUE(estimator_.estimate(*cloud_, center_, rim_height_));
+  // the floor cells next to the walls see their lower part and are not flat, the center
+  // is within a cell of 5 mm
+  EXPECT_NEAR(center_.x(), 0.6f, 0.005f);
+  EXPECT_NEAR(center_.y(), 0.1f, 0.005f);
+  EXPECT_NEAR(center_.z(), 0.0f, 1e-6);
+  EXPECT_NEAR(rim_height_, 0.08f, 1e-6);
+
+  ASSERT_TRUE(estimator_.estimate(*cloud_, center_, rim_height_, normals_));
+  EXPECT_NEAR(center_.x(), 0.6f, 0.005f);
+  EXPECT_NEAR(center_.y(), 0.1f, 0.005f);
+}
+
+TEST_F(ContainerRimEstimatorTest, ObjectsInsideDoNotMoveTheCenter)
+{
+  // a nut of 2 x 2 cm and 1.5 cm height lying in a corner of the floor
+  for (int i = 0; i < 64; i++)
+  {
+    addPoint(0.53f + 0.0025f * (i % 8), -0.01f + 0.0025f * (i / 8), 0.015f, 1.0f);
+  }
+  ASSERT_TRUE(estimator_.estimate(*cloud_, center_, rim_height_));
+  EXPECT_NEAR(center_.x(), 0.6f, 0.005f);
+  EXPECT_NEAR(center_.y(), 0.1f, 0.005f);
+  EXPECT_NEAR(center_.z(), 0.0f, 1e-6);
+}
+
+TEST_F(ContainerRimEstimatorTest, CoarserRasterForLargeClouds)
+{
+  ContainerRimEstimator::Params params;
+  // 33 x 49 cells of 5 mm, 17 x 25 cells of 1 cm
+  params.max_cells = 500;
+  params.flatness_tolerance = 0.02;
+  estimator_.setParams(params);
+  ASSERT_TRUE(estimator_.estimate(*cloud_, center_, rim_height_));
+  EXPECT_NEAR(center_.x(), 0.6f, 0.01f);
+  EXPECT_NEAR(center_.y(), 0.1f, 0.01f);
+}
+
+TEST_F(ContainerRimEstimatorTest, RejectsSmallAndSteepClouds)
+{
+  ContainerRimEstimator::Params params;
+  params.min_points = static_cast<int>(cloud_->points.size()) + 1;
+  estimator_.setParams(params);
+  EXPECT_FALSE(estimator_.estimate(*cloud_, center_, rim_height_));
+
+  // only the walls: no flat region
+  PointCloud walls;
+  for (const auto &point : cloud_->points)
+  {
+    if (point.z > 0.0f || !std::isfinite(point.z))
+      walls.points.push_back(point);
+  }
+  PointT invalid;
+  invalid.x = invalid.y = invalid.z = std::numeric_limits<float>::quiet_NaN();
+  walls.points.push_back(invalid);
+  estimator_.setParams(ContainerRimEstimator::Params());
+  EXPECT_FALSE(estimator_.estimate(walls, center_, rim_height_));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/depth_deprojector.h>
+
+class DepthDeprojectorTest : public ::testing::Test
+{
+  protected:
+    /** \brief Undistorted 8 x 6 camera, fx = fy = 4, principal point in the center */
+    DepthDeprojectorTest()
+    {
+      camera_info_.width = 8;
+      camera_info_.height = 6;
+      camera_info_.K = {4.0, 0.0, 4.0, 0.0, 4.0, 3.0, 0.0, 0.0, 1.0};
+      camera_info_.D = {0.0, 0.0, 0.0, 0.0, 0.0};
+    }
+
+    /** \brief Deproject with the identity transform */
+    bool deproject(const cv::Mat &depth, const cv::Mat &color, const cv::Rect &region, int stride,
+                   bool organized, PointCloud &cloud) const
+    {
+      return DepthDeprojector(camera_info_).deproject(depth, color, Eigen::Matrix3f::Identity(),
+                                                      Eigen::Vector3f::Zero(), region, stride,
+                                                      organized, cloud);
+    }
+
+    sensor_msgs::CameraInfo camera_info_;
+};
+
+TEST_F(DepthDeprojectorTest, RejectsInvalidInput)
+{
+  const DepthDeprojector deprojector(camera_info_);
+  ASSERT_TRUE(deprojector.isValid());
+  EXPECT_TRUE(deprojector.matches(camera_info_));
+  sensor_msgs::CameraInfo no_focal_length = camera_info_;
+  no_focal_length.K[0] = 0.0;
+  EXPECT_FALSE(DepthDeprojector(no_focal_length).isValid());
+  EXPECT_FALSE(deprojector.matches(no_focal_length));
+
+  PointCloud cloud;
+  const cv::Rect region(0, 0, 8, 6);
+  EXPECT_FALSE(deproject(cv::Mat(5, 8, CV_16UC1, cv::Scalar(1000)), cv::Mat(), region, 1, false,
+                         cloud));
+  EXPECT_FALSE(deproject(cv::Mat(6, 8, CV_8UC1, cv::Scalar(1)), cv::Mat(), region, 1, false, cloud));
+}
+
+TEST_F(DepthDeprojectorTest, MillimetersAndMetersMatch)
+{
+  const cv::Rect region(0, 0, 8, 6);
+  PointCloud cloud_mm, cloud_m;
+  ASSERT_TRUE(deproject(cv::Mat(6, 8, CV_16UC1, cv::Scalar(1500)), cv::Mat(), region, 1, false,
+                        cloud_mm));
+  ASSERT_TRUE(deproject(cv::Mat(6, 8, CV_32FC1, cv::Scalar(1.5)), cv::Mat(), region, 1, false,
+                        cloud_m));
+  ASSERT_EQ(cloud_mm.points.size(), 48u);
+  ASSERT_EQ(cloud_m.points.size(), 48u);
+  for (size_t i = 0; i < cloud_mm.points.size(); i++)
+  {
+    EXPECT_NEAR(cloud_mm.points[i].x, cloud_m.points[i].x, 1e-6);
+    EXPECT_NEAR(cloud_mm.points[i].y, cloud_m.points[i].y, 1e-6);
+    EXPECT_NEAR(cloud_mm.points[i].z, 1.5f, 1e-6);
+    EXPECT_NEAR(cloud_m.points[i].z, 1.5f, 1e-6);
+  }
+  // pixel (6, 4): x = (6 - 4) / 4 * 1.5, y = (4 - 3) / 4 * 1.5
+  EXPECT_NEAR(cloud_m.points[4 * 8 + 6].x, 0.75f, 1e-6);
+  EXPECT_NEAR(cloud_m.points[4 * 8 + 6].y, 0.375f, 1e-6);
+}
+
+TEST_F(DepthDeprojectorTest, TransformsToTheTargetFrame)
+{
+  const DepthDeprojector deprojector(camera_info_);
+  cv::Mat depth(6, 8, CV_32FC1, cv::Scalar(2.0));
+  // camera looking down from 1 m: the optical axis is -z of the target frame
+  Eigen::Matrix3f rotation;
+  rotation << 1, 0, 0, 0, -1, 0, 0, 0, -1;
+  const Eigen::Vector3f translation(0.1f, 0.0f, 1.0f);
+
+  PointCloud cloud;
+  ASSERT_TRUE(deprojector.deproject(depth, cv::Mat(), rotation, translation, cv::Rect(4, 3, 1, 1),
+                                    1, false, cloud));
+  ASSERT_EQ(cloud.points.size(), 1u);
+  EXPECT_NEAR(cloud.points[0].x, 0.1f, 1e-6);
+  EXPECT_NEAR(cloud.points[0].y, 0.0f, 1e-6);
+  EXPECT_NEAR(cloud.points[0].z, -1.0f, 1e-6);
+}
+
+TEST_F(DepthDeprojectorTest, OrganizedKeepsInvalidPixels)
+{
+  cv::Mat depth(6, 8, CV_16UC1, cv::Scalar(1000));
+  depth.at<uint16_t>(2, 3) = 0;
+  depth.at<uint16_t>(4, 5) = 0;
+  cv::Mat color(6, 8, CV_8UC3, cv::Scalar(10, 20, 30));
+  // the region is clipped to the image
+  const cv::Rect region(1, 0, 10, 6);
+
+  PointCloud organized;
+  ASSERT_TRUE(deproject(depth, color, region, 2, true, organized));
+  // columns 1, 3, 5, 7 and rows 0, 2, 4
+  EXPECT_EQ(organized.width, 4u);
+  EXPECT_EQ(organized.height, 3u);
+  EXPECT_FALSE(organized.is_dense);
+  ASSERT_EQ(organized.points.size(), 12u);
+  for (size_t i = 0; i < organized.points.size(); i++)
+  {
+    const PointT &point = organized.points[i];
+    // (3, 2) and (5, 4) have no depth
+    const bool invalid = i == 1 * 4 + 1 || i == 2 * 4 + 2;
+    EXPECT_EQ(std::isnan(point.x), invalid);
+    EXPECT_EQ(std::isnan(point.z), invalid);
+    EXPECT_EQ(point.b, 10);
+    EXPECT_EQ(point.g, 20);
+    EXPECT_EQ(point.r, 30);
+  }
+
+  PointCloud dense;
+  ASSERT_TRUE(deproject(depth, cv::Mat(), region, 2, false, dense));
+  EXPECT_EQ(dense.points.size(), 10u);
+  EXPECT_EQ(dense.width, 10u);
+  EXPECT_EQ(dense.height, 1u);
+  EXPECT_TRUE(dense.is_dense);
+  // white without a colour image
+  EXPECT_EQ(dense.points[0].r, 255);
+  EXPECT_EQ(dense.points[0].g, 255);
+  EXPECT_EQ(dense.points[0].b, 255);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/job_queue.h>
+
+TEST(JobQueue, PopsByPriorityThenInOrder)
+{
+  JobQueue<int> queue;
+  const uint32_t low = queue.push(1, 0);
+  const uint32_t high = queue.push(2, 5);
+  const uint32_t second_low = queue.push(3, 0);
+  const uint32_t negative = queue.push(4, -1);
+  EXPECT_NE(low, 0u);
+  EXPECT_EQ(queue.size(), 4u);
+  EXPECT_EQ(queue.position(high), 0);
+  EXPECT_EQ(queue.position(negative), 3);
+
+  const std::vector<uint32_t> expected_ids = {high, low, second_low, negative};
+  const std::vector<int> expected_jobs = {2, 1, 3, 4};
+  for (size_t i = 0; i < expected_ids.size(); i++)
+  {
+    uint32_t id = 0;
+    int job = 0;
+    ASSERT_TRUE(queue.pop(id, job));
+    EXPECT_EQ(id, expected_ids[i]);
+    EXPECT_EQ(job, expected_jobs[i]);
+  }
+  EXPECT_EQ(queue.position(high), -1);
+}
+
+TEST(JobQueue, CancelsOneJob)
+{
+  JobQueue<int> queue;
+  const uint32_t first = queue.push(1, 0);
+  const uint32_t second = queue.push(2, 0);
+  const uint32_t third = queue.push(3, 0);
+  EXPECT_TRUE(queue.remove(second));
+  EXPECT_FALSE(queue.remove(second));
+  EXPECT_EQ(queue.position(third), 1);
+
+  uint32_t id = 0;
+  int job = 0;
+  ASSERT_TRUE(queue.pop(id, job));
+  EXPECT_EQ(id, first);
+  // popped jobs are not queued anymore
+  EXPECT_FALSE(queue.remove(first));
+  ASSERT_TRUE(queue.pop(id, job));
+  EXPECT_EQ(job, 3);
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(JobQueue, CancelsAllJobs)
+{
+  JobQueue<int> queue;
+  queue.push(1, 0);
+  queue.push(2, 1);
+  queue.push(3, 0);
+  EXPECT_EQ(queue.clear(), std::vector<int>({2, 1, 3}));
+  EXPECT_EQ(queue.size(), 0u);
+  EXPECT_TRUE(queue.clear().empty());
+
+  // the queue stays open
+  const uint32_t id = queue.push(4, 0);
+  EXPECT_NE(id, 0u);
+  uint32_t popped_id = 0;
+  int job = 0;
+  ASSERT_TRUE(queue.pop(popped_id, job));
+  EXPECT_EQ(popped_id, id);
+}
+
+TEST(JobQueue, CloseWakesUpThePoppingThread)
+{
+  JobQueue<int> queue;
+  std::atomic<bool> popped(true);
+  std::thread worker([&] {
+    uint32_t id = 0;
+    int job = 0;
+    popped = queue.pop(id, job);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  queue.close();
+  worker.join();
+  EXPECT_FALSE(popped);
+  EXPECT_EQ(queue.push(1, 0), 0u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/object_fusion.h>
+
+class ObjectFusionTest : public ::testing::Test
+{
+  protected:
+    ObjectFusionTest() : fusion_(0.03) {}
+
+    /** \brief Add an object at x, y, z to a recognizer list, the database id is its index
+     * in the list plus 100 for the rgb objects */
+    static void add(mas_perception_msgs::ObjectList &objects, const std::string &name,
+                    double probability, double x, double y, double z, int id_offset)
+    {
+      mas_perception_msgs::Object object;
+      object.name = name;
+      object.probability = probability;
+      object.pose.pose.position.x = x;
+      object.pose.pose.position.y = y;
+      object.pose.pose.position.z = z;
+      object.pose.pose.orientation.w = 1.0;
+      object.database_id = id_offset + static_cast<int>(objects.objects.size());
+      objects.objects.push_back(object);
+    }
+
+    void addCloud(const std::string &name, double probability, double x, double y, double z)
+    {
+      add(cloud_objects_, name, probability, x, y, z, 0);
+    }
+
+    void addRgb(const std::string &name, double probability, double x, double y, double z)
+    {
+      add(rgb_objects_, name, probability, x, y, z, 100);
+    }
+
+    int fuse() { return fusion_.fuse(cloud_objects_, rgb_objects_, fused_); }
+
+    ObjectFusion fusion_;
+    mas_perception_msgs::ObjectList cloud_objects_;
+    mas_perception_msgs::ObjectList rgb_objects_;
+    mas_perception_msgs::ObjectList fused_;
+};
+
+TEST_F(ObjectFusionTest, FusesObjectsWithinTheRadius)
+{
+  addCloud("M20", 0.6, 0.50, 0.10, 0.05);
+  addRgb("M20", 0.7, 0.51, 0.11, 0.05);
+
+  EXPECT_EQ(fuse(), 1);
+  ASSERT_EQ(fused_.objects.size(), 1u);
+  // same label, independent evidence
+  EXPECT_NEAR(fused_.objects[0].probability, 1.0 - 0.4 * 0.3, 1e-9);
+  // the rgb object has the higher probability and is kept
+  EXPECT_EQ(fused_.objects[0].database_id, 100);
+  EXPECT_DOUBLE_EQ(fused_.objects[0].pose.pose.position.x, 0.51);
+}
+
+TEST_F(ObjectFusionTest, DisagreeingLabelsKeepTheMoreProbableObject)
+{
+  // both recognizers see the same physical object, it is reported once
+  addCloud("M20", 0.6, 0.50, 0.10, 0.05);
+  addRgb("M30", 0.8, 0.51, 0.10, 0.05);
+  addCloud("F20", 0.9, 0.80, 0.10, 0.05);
+  addRgb("S40_40_G", 0.5, 0.80, 0.11, 0.05);
+
+  EXPECT_EQ(fuse(), 2);
+  ASSERT_EQ(fused_.objects.size(), 2u);
+  // the probability is not merged, the recognizers contradict each other
+  EXPECT_EQ(fused_.objects[0].name, "M30");
+  EXPECT_DOUBLE_EQ(fused_.objects[0].probability, 0.8);
+  EXPECT_EQ(fused_.objects[0].database_id, 100);
+  EXPECT_EQ(fused_.objects[1].name, "F20");
+  EXPECT_DOUBLE_EQ(fused_.objects[1].probability, 0.9);
+  EXPECT_EQ(fused_.objects[1].database_id, 1);
+}
+
+TEST_F(ObjectFusionTest, KeepsObjectsOutsideTheRadius)
+{
+  addCloud("M20", 0.6, 0.50, 0.10, 0.05);
+  // within the radius in xy, too far in z
+  addRgb("M20", 0.7, 0.50, 0.10, 0.10);
+  addRgb("M30", 0.7, 0.54, 0.10, 0.05);
+
+  EXPECT_EQ(fuse(), 0);
+  ASSERT_EQ(fused_.objects.size(), 3u);
+  EXPECT_EQ(fused_.objects[0].database_id, 0);
+  EXPECT_EQ(fused_.objects[1].database_id, 100);
+  EXPECT_EQ(fused_.objects[2].database_id, 101);
+}
+
+TEST_F(ObjectFusionTest, FusesAcrossCellBorders)
+{
+  // the cells of 0.03 m border at 0 and -0.03, negative cells included
+  addCloud("F20", 0.5, -0.001, -0.029, 0.0);
+  addRgb("F20", 0.5, 0.001, -0.031, 0.0);
+  addCloud("R20", 0.5, -1.2901, 2.4, 0.0);
+  addRgb("R20", 0.5, -1.2899, 2.4, 0.0);
+
+  EXPECT_EQ(fuse(), 2);
+  ASSERT_EQ(fused_.objects.size(), 2u);
+  EXPECT_EQ(fused_.objects[0].name, "F20");
+  EXPECT_NEAR(fused_.objects[0].probability, 0.75, 1e-9);
+  EXPECT_EQ(fused_.objects[1].name, "R20");
+  EXPECT_NEAR(fused_.objects[1].probability, 0.75, 1e-9);
+}
+
+TEST_F(ObjectFusionTest, AssociatesTheClosestFreeObject)
+{
+  addCloud("M20", 0.6, 0.00, 0.0, 0.0);
+  addCloud("M30", 0.6, 0.02, 0.0, 0.0);
+  addRgb("M30", 0.7, 0.019, 0.0, 0.0);
+  addRgb("M20", 0.7, 0.018, 0.0, 0.0);
+
+  EXPECT_EQ(fuse(), 2);
+  ASSERT_EQ(fused_.objects.size(), 2u);
+  EXPECT_EQ(fused_.objects[0].database_id, 101);
+  EXPECT_EQ(fused_.objects[1].database_id, 100);
+}
+
+TEST_F(ObjectFusionTest, PassesDecoysThrough)
+{
+  addCloud("DECOY", 0.9, 0.5, 0.1, 0.0);
+  addRgb("M20", 0.7, 0.5, 0.1, 0.0);
+  addRgb("DECOY", 0.9, 0.5, 0.1, 0.0);
+
+  EXPECT_EQ(fuse(), 0);
+  ASSERT_EQ(fused_.objects.size(), 3u);
+  EXPECT_EQ(fused_.objects[0].name, "DECOY");
+  EXPECT_EQ(fused_.objects[1].name, "M20");
+  EXPECT_EQ(fused_.objects[2].name, "DECOY");
+}
+
+TEST_F(ObjectFusionTest, ZeroRadiusDisablesFusion)
+{
+  fusion_.setRadius(0.0);
+  addCloud("M20", 0.6, 0.5, 0.1, 0.0);
+  addRgb("M20", 0.7, 0.5, 0.1, 0.0);
+
+  EXPECT_EQ(fuse(), 0);
+  EXPECT_EQ(fused_.objects.size(), 2u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
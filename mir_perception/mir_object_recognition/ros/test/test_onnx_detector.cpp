@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/onnx_detector.h>
+
+class OnnxDetectorDecodeTest : public ::testing::Test
+{
+  protected:
+    /** \brief Image of 1280 x 720 letterboxed into an input of 640 x 640: scaled by 0.5 and
+     * padded by 140 rows at the top */
+    OnnxDetectorDecodeTest()
+      : image_size_(1280, 720), letterbox_(OnnxDetector::letterbox(image_size_, cv::Size(640, 640)))
+    {
+    }
+
+    /** \brief Output of 8 boxes and 2 classes, one box per row as [cx, cy, w, h, objectness,
+     * scores...] */
+    static cv::Mat rowOutput()
+    {
+      const int sizes[] = {1, 8, 7};
+      return cv::Mat(3, sizes, CV_32F, cv::Scalar(0));
+    }
+
+    static void setRow(cv::Mat &output, int box, const std::vector<float> &attributes)
+    {
+      float *data = output.ptr<float>() + box * output.size[2];
+      std::copy(attributes.begin(), attributes.end(), data);
+    }
+
+    bool decode(const cv::Mat &output)
+    {
+      return OnnxDetector::decode(output, letterbox_, image_size_, 0.7f, 0.45f, detections_);
+    }
+
+    cv::Size image_size_;
+    OnnxDetector::Letterbox letterbox_;
+    std::vector<OnnxDetector::Detection> detections_;
+};
+
+TEST_F(OnnxDetectorDecodeTest, Letterbox)
+{
+  EXPECT_DOUBLE_EQ(letterbox_.scale, 0.5);
+  EXPECT_EQ(letterbox_.scaled_size, cv::Size(640, 360));
+  EXPECT_EQ(letterbox_.pad_x, 0);
+  EXPECT_EQ(letterbox_.pad_y, 140);
+
+  const OnnxDetector::Letterbox box = OnnxDetector::letterbox(cv::Size(480, 640), cv::Size(640, 640));
+  EXPECT_DOUBLE_EQ(box.scale, 1.0);
+  EXPECT_EQ(box.scaled_size, cv::Size(480, 640));
+  EXPECT_EQ(box.pad_x, 80);
+  EXPECT_EQ(box.pad_y, 0);
+}
+
+TEST_F(OnnxDetectorDecodeTest, DecodesOneBoxPerRow)
+{
+  cv::Mat output = rowOutput();
+  setRow(output, 0, {320.0f, 320.0f, 100.0f, 50.0f, 0.9f, 0.1f, 0.9f});
+  // below the confidence threshold: objectness, then objectness times class score
+  setRow(output, 1, {100.0f, 300.0f, 20.0f, 20.0f, 0.5f, 1.0f, 0.0f});
+  setRow(output, 2, {500.0f, 300.0f, 20.0f, 20.0f, 0.9f, 0.7f, 0.2f});
+  ASSERT_TRUE(decode(output));
+  ASSERT_EQ(detections_.size(), 1u);
+  EXPECT_EQ(detections_[0].class_id, 1);
+  EXPECT_FLOAT_EQ(detections_[0].score, 0.81f);
+  // back to the pixels of the image
+  EXPECT_EQ(detections_[0].box, cv::Rect(540, 310, 200, 100));
+}
+
+TEST_F(OnnxDetectorDecodeTest, DecodesOneBoxPerColumn)
+{
+  // [1, 4 + C, N] without objectness
+  const int sizes[] = {1, 6, 8};
+  cv::Mat output(3, sizes, CV_32F, cv::Scalar(0));
+  const float box[] = {320.0f, 320.0f, 100.0f, 50.0f, 0.2f, 0.8f};
+  for (int attribute = 0; attribute < 6; attribute++)
+  {
+    output.ptr<float>()[attribute * 8 + 3] = box[attribute];
+  }
+  ASSERT_TRUE(decode(output));
+  ASSERT_EQ(detections_.size(), 1u);
+  EXPECT_EQ(detections_[0].class_id, 1);
+  EXPECT_FLOAT_EQ(detections_[0].score, 0.8f);
+  EXPECT_EQ(detections_[0].box, cv::Rect(540, 310, 200, 100));
+}
+
+TEST_F(OnnxDetectorDecodeTest, SuppressesOverlappingBoxesPerClass)
+{
+  cv::Mat output = rowOutput();
+  setRow(output, 0, {320.0f, 320.0f, 100.0f, 50.0f, 1.0f, 0.8f, 0.0f});
+  // the same object, less probable
+  setRow(output, 1, {322.0f, 321.0f, 100.0f, 50.0f, 1.0f, 0.75f, 0.0f});
+  // the same box of another class is kept
+  setRow(output, 2, {320.0f, 320.0f, 100.0f, 50.0f, 1.0f, 0.0f, 0.9f});
+  // a separate object of the first class
+  setRow(output, 3, {100.0f, 300.0f, 40.0f, 40.0f, 1.0f, 0.85f, 0.0f});
+  ASSERT_TRUE(decode(output));
+  ASSERT_EQ(detections_.size(), 3u);
+  // ordered by score
+  EXPECT_EQ(detections_[0].class_id, 1);
+  EXPECT_FLOAT_EQ(detections_[0].score, 0.9f);
+  EXPECT_EQ(detections_[1].class_id, 0);
+  EXPECT_EQ(detections_[1].box, cv::Rect(160, 280, 80, 80));
+  EXPECT_EQ(detections_[2].class_id, 0);
+  EXPECT_FLOAT_EQ(detections_[2].score, 0.8f);
+}
+
+TEST_F(OnnxDetectorDecodeTest, ClipsBoxesToTheImage)
+{
+  cv::Mat output = rowOutput();
+  // over the left edge of the image
+  setRow(output, 0, {10.0f, 320.0f, 40.0f, 20.0f, 1.0f, 0.9f, 0.0f});
+  // in the padding above the image
+  setRow(output, 1, {320.0f, 60.0f, 40.0f, 20.0f, 1.0f, 0.9f, 0.0f});
+  ASSERT_TRUE(decode(output));
+  ASSERT_EQ(detections_.size(), 1u);
+  EXPECT_EQ(detections_[0].box, cv::Rect(0, 340, 60, 40));
+}
+
+TEST_F(OnnxDetectorDecodeTest, RejectsUnexpectedShapes)
+{
+  EXPECT_FALSE(decode(cv::Mat(8, 7, CV_32F, cv::Scalar(0))));
+  const int batch[] = {2, 8, 7};
+  EXPECT_FALSE(decode(cv::Mat(3, batch, CV_32F, cv::Scalar(0))));
+  // boxes without class scores
+  const int no_classes[] = {1, 4, 8};
+  EXPECT_FALSE(decode(cv::Mat(3, no_classes, CV_32F, cv::Scalar(0))));
+  const int sizes[] = {1, 8, 7};
+  EXPECT_FALSE(decode(cv::Mat(3, sizes, CV_64F, cv::Scalar(0))));
+  EXPECT_TRUE(detections_.empty());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/perceived_object_store.h>
+
+class PerceivedObjectStoreTest : public ::testing::Test
+{
+  protected:
+    /** \brief Blocks of 4 x 4 pixels, one changed block of a 8 x 8 scene is tolerated */
+    PerceivedObjectStoreTest()
+    {
+      params_.block_size = 4;
+      params_.max_changed_ratio = 0.02;
+      store_.setParams(params_);
+      robot_pose_.valid = true;
+      robot_pose_.x = 1.0;
+      robot_pose_.y = 2.0;
+      robot_pose_.yaw = 0.5;
+    }
+
+    /** \brief Organized 32 x 32 cloud of a table at 0.7 m, a box of 8 x 8 pixels at 0.75 m
+     * with its corner at pixel (col, row) */
+    static PointCloud scene(int col, int row)
+    {
+      PointCloud cloud;
+      cloud.width = 32;
+      cloud.height = 32;
+      for (int v = 0; v < 32; v++)
+      {
+        for (int u = 0; u < 32; u++)
+        {
+          PointT point;
+          point.x = 0.4f + 0.01f * v;
+          point.y = -0.16f + 0.01f * u;
+          const bool box = u >= col && u < col + 8 && v >= row && v < row + 8;
+          point.z = box ? 0.75f : 0.7f;
+          cloud.points.push_back(point);
+        }
+      }
+      return cloud;
+    }
+
+    /** \brief Store the scene with the box at pixel (8, 8) and an object on it */
+    void insertScene(double stamp)
+    {
+      PerceivedObjectStore::Entry entry;
+      entry.stamp = stamp;
+      entry.robot_pose = robot_pose_;
+      entry.signature = store_.computeSignature(scene(8, 8));
+      mas_perception_msgs::Object object;
+      object.name = "M20";
+      entry.object_list.objects.push_back(object);
+      store_.insert("WS01", entry);
+    }
+
+    bool lookup(const PointCloud &cloud, double stamp)
+    {
+      return store_.lookup("WS01", store_.computeSignature(cloud), robot_pose_, stamp, entry_,
+                           changed_ratio_);
+    }
+
+    PerceivedObjectStore::Params params_;
+    PerceivedObjectStore store_;
+    PerceivedObjectStore::RobotPose robot_pose_;
+    PerceivedObjectStore::Entry entry_;
+    double changed_ratio_;
+};
+
+TEST_F(PerceivedObjectStoreTest, Signature)
+{
+  PointCloud cloud = scene(8, 8);
+  // a block with less than a quarter of valid points is not compared
+  for (int i = 0; i < 13; i++)
+  {
+    cloud.points[i / 4 * 32 + i % 4].z = std::numeric_limits<float>::quiet_NaN();
+  }
+  const SceneSignature signature = store_.computeSignature(cloud);
+  EXPECT_EQ(signature.rows, 8);
+  EXPECT_EQ(signature.cols, 8);
+  ASSERT_EQ(signature.heights.size(), 64u);
+  EXPECT_TRUE(std::isnan(signature.heights[0]));
+  EXPECT_FLOAT_EQ(signature.heights[1], 0.7f);
+  EXPECT_FLOAT_EQ(signature.heights[2 * 8 + 2], 0.75f);
+  EXPECT_NE(signature.occupancy_hash, 0u);
+
+  // unorganized clouds have no signature
+  cloud.width = 32 * 32;
+  cloud.height = 1;
+  EXPECT_TRUE(store_.computeSignature(cloud).heights.empty());
+}
+
+TEST_F(PerceivedObjectStoreTest, ReusesAnUnchangedScene)
+{
+  insertScene(10.0);
+  EXPECT_EQ(store_.size(), 1u);
+  ASSERT_TRUE(lookup(scene(8, 8), 20.0));
+  EXPECT_DOUBLE_EQ(changed_ratio_, 0.0);
+  EXPECT_DOUBLE_EQ(entry_.stamp, 10.0);
+  ASSERT_EQ(entry_.object_list.objects.size(), 1u);
+  EXPECT_EQ(entry_.object_list.objects[0].name, "M20");
+
+  PerceivedObjectStore::Entry entry;
+  EXPECT_FALSE(store_.lookup("WS02", store_.computeSignature(scene(8, 8)), robot_pose_, 20.0, entry,
+                             changed_ratio_));
+}
+
+TEST_F(PerceivedObjectStoreTest, DetectsMovedObjects)
+{
+  insertScene(10.0);
+  // the box moved by 4 pixels: 4 of 64 blocks changed
+  EXPECT_FALSE(lookup(scene(12, 8), 20.0));
+  EXPECT_DOUBLE_EQ(changed_ratio_, 4.0 / 64.0);
+  // a single changed block is tolerated
+  PointCloud raised = scene(8, 8);
+  for (int i = 0; i < 16; i++)
+  {
+    raised.points[i / 4 * 32 + i % 4].z = 0.9f;
+  }
+  EXPECT_TRUE(lookup(raised, 20.0));
+  EXPECT_DOUBLE_EQ(changed_ratio_, 1.0 / 64.0);
+  params_.max_changed_ratio = 0.01;
+  store_.setParams(params_);
+  EXPECT_FALSE(lookup(raised, 20.0));
+}
+
+TEST_F(PerceivedObjectStoreTest, RequiresTheSameViewpoint)
+{
+  insertScene(10.0);
+  robot_pose_.x += 0.04;
+  EXPECT_TRUE(lookup(scene(8, 8), 20.0));
+  robot_pose_.x += 0.02;
+  EXPECT_FALSE(lookup(scene(8, 8), 20.0));
+  robot_pose_.x -= 0.06;
+  robot_pose_.yaw += 0.06;
+  EXPECT_FALSE(lookup(scene(8, 8), 20.0));
+  robot_pose_.yaw -= 0.06;
+  robot_pose_.valid = false;
+  EXPECT_FALSE(lookup(scene(8, 8), 20.0));
+  // still stored
+  EXPECT_EQ(store_.size(), 1u);
+}
+
+TEST_F(PerceivedObjectStoreTest, DropsOldAndErasedEntries)
+{
+  insertScene(10.0);
+  EXPECT_FALSE(lookup(scene(8, 8), 10.0 + params_.max_age + 1.0));
+  EXPECT_EQ(store_.size(), 0u);
+
+  insertScene(10.0);
+  store_.erase("WS01");
+  EXPECT_FALSE(lookup(scene(8, 8), 20.0));
+
+  insertScene(10.0);
+  params_.enable = false;
+  store_.setParams(params_);
+  EXPECT_EQ(store_.size(), 0u);
+  insertScene(10.0);
+  EXPECT_EQ(store_.size(), 0u);
+}
+
+TEST_F(PerceivedObjectStoreTest, KeepsTheNewestEntries)
+{
+  params_.max_entries = 2;
+  store_.setParams(params_);
+  PerceivedObjectStore::Entry entry;
+  entry.stamp = 3.0;
+  store_.insert("WS03", entry);
+  entry.stamp = 1.0;
+  store_.insert("WS01", entry);
+  entry.stamp = 2.0;
+  store_.insert("WS02", entry);
+  EXPECT_EQ(store_.size(), 2u);
+  // the oldest entry was dropped
+  store_.erase("WS01");
+  EXPECT_EQ(store_.size(), 2u);
+  store_.erase("WS02");
+  EXPECT_EQ(store_.size(), 1u);
+}
+
+TEST_F(PerceivedObjectStoreTest, MovesThePosesWithTheRobot)
+{
+  mas_perception_msgs::ObjectList objects;
+  objects.objects.resize(1);
+  geometry_msgs::Pose &pose = objects.objects[0].pose.pose;
+  pose.position.x = 0.5;
+  pose.position.y = 0.1;
+  pose.position.z = 0.75;
+  // yaw of 0.2
+  pose.orientation.z = std::sin(0.1);
+  pose.orientation.w = std::cos(0.1);
+
+  // robot at (1, 2) facing along y
+  PerceivedObjectStore::RobotPose stored;
+  stored.valid = true;
+  stored.x = 1.0;
+  stored.y = 2.0;
+  stored.yaw = M_PI / 2.0;
+  PerceivedObjectStore::toFixedFrame(stored, objects);
+  EXPECT_NEAR(pose.position.x, 0.9, 1e-9);
+  EXPECT_NEAR(pose.position.y, 2.5, 1e-9);
+  EXPECT_DOUBLE_EQ(pose.position.z, 0.75);
+  EXPECT_NEAR(2.0 * std::atan2(pose.orientation.z, pose.orientation.w), M_PI / 2.0 + 0.2, 1e-9);
+
+  // the robot moved 2 cm backwards and turned slightly
+  PerceivedObjectStore::RobotPose current = stored;
+  current.y -= 0.02;
+  current.yaw += 0.01;
+  PerceivedObjectStore::toRobotFrame(current, objects);
+  EXPECT_NEAR(pose.position.x, 0.02 * std::cos(0.01) + 0.5 * std::cos(0.01) + 0.1 * std::sin(0.01), 1e-9);
+  EXPECT_NEAR(pose.position.y, -0.02 * std::sin(0.01) - 0.5 * std::sin(0.01) + 0.1 * std::cos(0.01), 1e-9);
+  EXPECT_NEAR(2.0 * std::atan2(pose.orientation.z, pose.orientation.w), 0.19, 1e-9);
+
+  // back to the stored pose
+  PerceivedObjectStore::toFixedFrame(current, objects);
+  PerceivedObjectStore::toRobotFrame(stored, objects);
+  EXPECT_NEAR(pose.position.x, 0.5, 1e-9);
+  EXPECT_NEAR(pose.position.y, 0.1, 1e-9);
+  EXPECT_NEAR(pose.orientation.z, std::sin(0.1), 1e-9);
+  EXPECT_NEAR(pose.orientation.w, std::cos(0.1), 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/recognition_cache.h>
+
+class RecognitionCacheTest : public ::testing::Test
+{
+  protected:
+    /** \brief Fingerprint of a box of 5 x 5 x 2 points with a spacing of 1 cm, its corner
+     * at x, y, z */
+    static ClusterFingerprint box(float x, float y, float z, uint8_t r = 200, uint8_t b = 10)
+    {
+      PointCloud cluster;
+      for (int i = 0; i < 50; i++)
+      {
+        PointT point;
+        point.x = x + 0.01f * (i % 5);
+        point.y = y + 0.01f * (i / 5 % 5);
+        point.z = z + 0.01f * (i / 25);
+        point.r = r;
+        point.g = 10;
+        point.b = b;
+        cluster.points.push_back(point);
+      }
+      return ClusterFingerprint(cluster);
+    }
+
+    RecognitionCache cache_;
+    RecognitionCache::Label label_;
+};
+
+TEST_F(RecognitionCacheTest, Fingerprint)
+{
+  const ClusterFingerprint fingerprint = box(0.5f, -0.2f, 0.1f);
+  EXPECT_EQ(fingerprint.num_points, 50u);
+  EXPECT_NEAR(fingerprint.centroid.x(), 0.52f, 1e-5);
+  EXPECT_NEAR(fingerprint.centroid.y(), -0.18f, 1e-5);
+  EXPECT_NEAR(fingerprint.centroid.z(), 0.105f, 1e-5);
+  EXPECT_NEAR(fingerprint.extent.x(), 0.04f, 1e-5);
+  EXPECT_NEAR(fingerprint.extent.z(), 0.01f, 1e-5);
+  // all points are in the bin of (200, 10, 10)
+  const int bin = 3 * ClusterFingerprint::BINS_PER_CHANNEL * ClusterFingerprint::BINS_PER_CHANNEL;
+  EXPECT_FLOAT_EQ(fingerprint.histogram[bin], 1.0f);
+}
+
+TEST_F(RecognitionCacheTest, MatchesNearbyClusters)
+{
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"M20", 0.8});
+  EXPECT_EQ(cache_.size(), 1u);
+
+  // within the centroid tolerance of 2 cm, across the border of the hash cells
+  ASSERT_TRUE(cache_.lookup(box(0.505f, -0.19f, 0.1f), label_));
+  EXPECT_EQ(label_.name, "M20");
+  EXPECT_DOUBLE_EQ(label_.probability, 0.8);
+  EXPECT_FALSE(cache_.lookup(box(0.55f, -0.2f, 0.1f), label_));
+  // a different colour at the same place
+  EXPECT_FALSE(cache_.lookup(box(0.5f, -0.2f, 0.1f, 10, 200), label_));
+}
+
+TEST_F(RecognitionCacheTest, IgnoresEmptyLabelsAndFingerprints)
+{
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"", 0.8});
+  cache_.insert(ClusterFingerprint(), {"M20", 0.8});
+  EXPECT_EQ(cache_.size(), 0u);
+  EXPECT_FALSE(cache_.lookup(ClusterFingerprint(), label_));
+}
+
+TEST_F(RecognitionCacheTest, ReplacesMatchingEntries)
+{
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"M20", 0.6});
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"M30", 0.9});
+  EXPECT_EQ(cache_.size(), 1u);
+
+  ASSERT_TRUE(cache_.lookup(box(0.5f, -0.2f, 0.1f), label_));
+  EXPECT_EQ(label_.name, "M30");
+}
+
+TEST_F(RecognitionCacheTest, ExpiresOldEntries)
+{
+  RecognitionCache::Params params;
+  params.max_age = 0.05;
+  cache_.setParams(params);
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"M20", 0.8});
+
+  EXPECT_TRUE(cache_.lookup(box(0.5f, -0.2f, 0.1f), label_));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(cache_.lookup(box(0.5f, -0.2f, 0.1f), label_));
+  EXPECT_EQ(cache_.size(), 0u);
+}
+
+TEST_F(RecognitionCacheTest, EvictsTheOldestEntry)
+{
+  RecognitionCache::Params params;
+  params.max_entries = 2;
+  cache_.setParams(params);
+  cache_.insert(box(0.0f, 0.0f, 0.0f), {"M20", 0.8});
+  cache_.insert(box(0.2f, 0.0f, 0.0f), {"M30", 0.8});
+  cache_.insert(box(0.4f, 0.0f, 0.0f), {"F20", 0.8});
+  EXPECT_EQ(cache_.size(), 2u);
+
+  EXPECT_FALSE(cache_.lookup(box(0.0f, 0.0f, 0.0f), label_));
+  EXPECT_TRUE(cache_.lookup(box(0.4f, 0.0f, 0.0f), label_));
+}
+
+TEST_F(RecognitionCacheTest, MatchesInTheFixedFrame)
+{
+  // the robot moved by 1 m in x, the cluster stayed at the same place in the fixed frame
+  ClusterFingerprint before = box(0.5f, -0.2f, 0.1f);
+  before.transform(Eigen::Affine3f(Eigen::Translation3f(1.0f, 0.0f, 0.0f)));
+  cache_.insert(before, {"M20", 0.8});
+
+  ClusterFingerprint after = box(-0.5f, -0.2f, 0.1f);
+  EXPECT_FALSE(cache_.lookup(after, label_));
+  after.transform(Eigen::Affine3f(Eigen::Translation3f(2.0f, 0.0f, 0.0f)));
+  EXPECT_TRUE(cache_.lookup(after, label_));
+}
+
+TEST_F(RecognitionCacheTest, DisablingClearsTheCache)
+{
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"M20", 0.8});
+  RecognitionCache::Params params;
+  params.enable = false;
+  cache_.setParams(params);
+  EXPECT_FALSE(cache_.isEnabled());
+  EXPECT_EQ(cache_.size(), 0u);
+
+  cache_.insert(box(0.5f, -0.2f, 0.1f), {"M20", 0.8});
+  EXPECT_FALSE(cache_.lookup(box(0.5f, -0.2f, 0.1f), label_));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/recognizer_client.h>
+
+using recognizer_client::findRequest;
+
+TEST(RecognizerClient, CorrelationIdRoundTrip)
+{
+  mas_perception_msgs::ObjectList request;
+  request.objects.resize(3);
+  recognizer_client::setCorrelationId(request, 42);
+  for (const auto &object : request.objects)
+  {
+    EXPECT_EQ(object.pose.header.seq, 42u);
+  }
+  // the recognizer echoes the object pose headers
+  EXPECT_EQ(recognizer_client::getCorrelationId(request), 42u);
+
+  mas_perception_msgs::ImageList images;
+  images.images.resize(2);
+  recognizer_client::setCorrelationId(images, 7);
+  EXPECT_EQ(images.images[1].header.seq, 7u);
+
+  EXPECT_EQ(recognizer_client::getCorrelationId(mas_perception_msgs::ObjectList()), 0u);
+}
+
+TEST(RecognizerClient, TaggedRepliesMatchTheirRequest)
+{
+  std::map<uint32_t, int> pending = {{3, 3}, {4, 4}, {5, 5}};
+  auto it = findRequest(pending, 4, 6);
+  ASSERT_NE(it, pending.end());
+  EXPECT_EQ(it->second, 4);
+  // timed out or canceled
+  EXPECT_EQ(findRequest(pending, 2, 6), pending.end());
+}
+
+TEST(RecognizerClient, UntaggedRepliesMatchTheOldestRequest)
+{
+  std::map<uint32_t, int> pending;
+  EXPECT_EQ(findRequest(pending, 0, 1), pending.end());
+
+  pending = {{3, 3}, {4, 4}, {5, 5}};
+  // empty replies of several pending requests arrive in order
+  for (int expected = 3; expected <= 5; expected++)
+  {
+    auto it = findRequest(pending, 0, 6);
+    ASSERT_NE(it, pending.end());
+    EXPECT_EQ(it->second, expected);
+    pending.erase(it);
+  }
+}
+
+TEST(RecognizerClient, UntaggedRepliesAcrossTheWrapAround)
+{
+  // the ids wrapped around after 0xfffffffe, 0 is skipped
+  std::map<uint32_t, int> pending = {{0xfffffffeu, 1}, {0xffffffffu, 2}, {1, 3}};
+  auto it = findRequest(pending, 0, 2);
+  ASSERT_NE(it, pending.end());
+  EXPECT_EQ(it->second, 1);
+  pending.erase(it);
+  it = findRequest(pending, 0, 2);
+  ASSERT_NE(it, pending.end());
+  EXPECT_EQ(it->second, 2);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
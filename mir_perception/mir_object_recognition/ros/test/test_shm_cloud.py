@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+import os
+import struct
+import unittest
+
+import numpy as np
+from sensor_msgs.msg import PointCloud2, PointField
+
+from pc_object_recognition.utils.shm_cloud import (HANDLE_PREFIX, RING_HEADER,
+                                                   RING_MAGIC, RING_VERSION,
+                                                   WRITE_POSITION_OFFSET,
+                                                   SharedMemoryCloudReader)
+
+CAPACITY = 256
+DATA_OFFSET = 64
+# x, y, z and rgb as in the PointCloud2 of a pcl::PointXYZRGB
+POINT_STEP = 32
+FIELDS = [PointField('x', 0, PointField.FLOAT32, 1),
+          PointField('y', 4, PointField.FLOAT32, 1),
+          PointField('z', 8, PointField.FLOAT32, 1),
+          PointField('rgb', 16, PointField.FLOAT32, 1)]
+
+
+class SharedMemoryCloudReaderTest(unittest.TestCase):
+    """
+    Writes a ring segment as SharedMemoryRing does and reads it back with the reader
+    """
+
+    def setUp(self):
+        self.name = "test_shm_cloud_%d" % os.getpid()
+        self.path = os.path.join("/dev/shm", self.name)
+        self.segment = bytearray(DATA_OFFSET + CAPACITY)
+        RING_HEADER.pack_into(self.segment, 0, RING_MAGIC, RING_VERSION, CAPACITY,
+                              DATA_OFFSET, 0)
+        self.reader = SharedMemoryCloudReader()
+
+    def tearDown(self):
+        self.reader.close()
+        if os.path.exists(self.path):
+            os.remove(self.path)
+
+    def write(self, position, points, write_position):
+        """
+        Write the points at a ring position and encode their handle
+
+        :return:        The handle
+        :rtype:         sensor_msgs.PointCloud2
+        """
+        data = np.zeros(len(points), dtype=np.dtype({'names': ['x', 'y', 'z', 'rgb'],
+                                                     'formats': [np.float32] * 4,
+                                                     'offsets': [0, 4, 8, 16],
+                                                     'itemsize': POINT_STEP}))
+        for i, point in enumerate(points):
+            data[i] = point
+        start = DATA_OFFSET + position % CAPACITY
+        self.segment[start:start + data.nbytes] = data.tobytes()
+        struct.pack_into("<Q", self.segment, WRITE_POSITION_OFFSET, write_position)
+        with open(self.path, "wb") as f:
+            f.write(self.segment)
+
+        handle = PointCloud2()
+        handle.height = 1
+        handle.width = len(points)
+        handle.point_step = POINT_STEP
+        handle.row_step = data.nbytes
+        handle.fields = list(FIELDS)
+        handle.fields.append(PointField(HANDLE_PREFIX + self.name, position & 0xffffffff, 0,
+                                        position >> 32))
+        return handle
+
+    def test_get_handle(self):
+        handle = self.write(0, [(1.0, 2.0, 3.0, 0.0)], 32)
+        self.assertEqual(SharedMemoryCloudReader.get_handle(handle), (self.name, 0))
+        handle.fields[-1].count = 1
+        self.assertEqual(SharedMemoryCloudReader.get_handle(handle)[1], 1 << 32)
+        # a cloud which carries its data
+        handle.data = b'\x00' * 32
+        self.assertIsNone(SharedMemoryCloudReader.get_handle(handle))
+
+    def test_read_points(self):
+        points = [(0.1, 0.2, 0.3, 1.0), (0.4, 0.5, 0.6, 2.0)]
+        handle = self.write(64, points, 128)
+        xyz = self.reader.read_points(handle, ('x', 'y', 'z'))
+        self.assertEqual(xyz.shape, (2, 3))
+        np.testing.assert_allclose(xyz, [p[:3] for p in points], rtol=1e-6)
+        rgb = self.reader.read_points(handle, ('rgb',))
+        np.testing.assert_allclose(rgb[:, 0], [1.0, 2.0])
+
+    def test_read_points_of_the_next_lap(self):
+        # the ring wrapped around once, the record is at offset 0 of the second lap
+        handle = self.write(CAPACITY, [(1.0, 1.0, 1.0, 0.0)], CAPACITY + 32)
+        xyz = self.reader.read_points(handle, ('x', 'y', 'z'))
+        np.testing.assert_allclose(xyz, [[1.0, 1.0, 1.0]])
+
+    def test_overwritten_points(self):
+        handle = self.write(0, [(1.0, 1.0, 1.0, 0.0)], CAPACITY + 64)
+        self.assertIsNone(self.reader.read_points(handle, ('x', 'y', 'z')))
+        # not written yet
+        handle = self.write(64, [(1.0, 1.0, 1.0, 0.0)], 64)
+        self.assertIsNone(self.reader.read_points(handle, ('x', 'y', 'z')))
+
+    def test_missing_and_invalid_segments(self):
+        handle = self.write(0, [(1.0, 1.0, 1.0, 0.0)], 32)
+        os.remove(self.path)
+        self.assertIsNone(self.reader.read_points(handle, ('x', 'y', 'z')))
+
+        struct.pack_into("<I", self.segment, 0, 0)
+        handle = self.write(0, [(1.0, 1.0, 1.0, 0.0)], 32)
+        self.assertIsNone(self.reader.read_points(handle, ('x', 'y', 'z')))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <cmath>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <mir_object_recognition/stage_latency.h>
+
+TEST(LatencyWindow, EmptyWindowIsNaN)
+{
+  LatencyWindow window(10);
+  EXPECT_TRUE(std::isnan(window.percentile(50.0)));
+  EXPECT_EQ(window.count(), 0u);
+}
+
+TEST(LatencyWindow, NearestRankPercentiles)
+{
+  LatencyWindow window(100);
+  // 1 to 10 in shuffled order
+  const double samples[] = {7, 3, 10, 1, 9, 2, 8, 5, 4, 6};
+  for (double sample : samples)
+  {
+    window.add(sample);
+  }
+  EXPECT_DOUBLE_EQ(window.percentile(0.0), 1.0);
+  EXPECT_DOUBLE_EQ(window.percentile(10.0), 1.0);
+  EXPECT_DOUBLE_EQ(window.percentile(11.0), 2.0);
+  EXPECT_DOUBLE_EQ(window.percentile(50.0), 5.0);
+  EXPECT_DOUBLE_EQ(window.percentile(95.0), 10.0);
+  EXPECT_DOUBLE_EQ(window.percentile(100.0), 10.0);
+  EXPECT_EQ(window.count(), 10u);
+}
+
+TEST(LatencyWindow, OldSamplesLeaveTheWindow)
+{
+  LatencyWindow window(4);
+  for (int i = 1; i <= 10; i++)
+  {
+    window.add(i);
+  }
+  // 7, 8, 9 and 10 are in the window
+  EXPECT_DOUBLE_EQ(window.percentile(0.0), 7.0);
+  EXPECT_DOUBLE_EQ(window.percentile(50.0), 8.0);
+  EXPECT_DOUBLE_EQ(window.percentile(100.0), 10.0);
+  EXPECT_EQ(window.count(), 10u);
+
+  // a spike leaves the window after window size samples
+  window.add(100.0);
+  EXPECT_DOUBLE_EQ(window.percentile(100.0), 100.0);
+  for (int i = 0; i < 4; i++)
+  {
+    window.add(1.0);
+  }
+  EXPECT_DOUBLE_EQ(window.percentile(100.0), 1.0);
+}
+
+TEST(LatencyWindow, ZeroSizeKeepsOneSample)
+{
+  LatencyWindow window(0);
+  window.add(3.0);
+  window.add(5.0);
+  EXPECT_DOUBLE_EQ(window.percentile(0.0), 5.0);
+  EXPECT_DOUBLE_EQ(window.percentile(100.0), 5.0);
+}
+
+TEST(StageLatency, StageNames)
+{
+  EXPECT_EQ(std::string(perceptionStageName(STAGE_TRANSFORM)), "transform");
+  EXPECT_EQ(std::string(perceptionStageName(STAGE_TOTAL)), "total");
+  EXPECT_EQ(std::string(perceptionStageName(NUM_PERCEPTION_STAGES)), "unknown");
+  EXPECT_EQ(std::string(perceptionStageName(-1)), "unknown");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
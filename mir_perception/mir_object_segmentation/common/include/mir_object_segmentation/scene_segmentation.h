@@ -8,35 +8,59 @@
 #define MIR_OBJECT_SEGMENTATION_SCENE_SEGMENTATION_H
 
 #include <pcl/ModelCoefficients.h>
+#include <pcl/PointIndices.h>
+#include <pcl/features/integral_image_normal.h>
 #include <pcl/features/normal_3d.h>
 #include <pcl/features/normal_3d_omp.h>
 #include <pcl/filters/passthrough.h>
 #include <pcl/filters/crop_box.h>
 #include <pcl/filters/project_inliers.h>
 #include <pcl/filters/radius_outlier_removal.h>
-#include <pcl/filters/voxel_grid.h>
 #include <pcl/kdtree/kdtree.h>
 #include <pcl/kdtree/kdtree_flann.h>
 #include <pcl/sample_consensus/method_types.h>
 #include <pcl/sample_consensus/model_types.h>
 #include <pcl/segmentation/extract_clusters.h>
 #include <pcl/segmentation/extract_polygonal_prism_data.h>
+#include <pcl/segmentation/organized_multi_plane_segmentation.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/surface/convex_hull.h>
 
 #include <mir_perception_utils/aliases.h>
 #include <mir_perception_utils/bounding_box.h>
+#include <mir_perception_utils/voxel_filter.h>
 
 using namespace mir_perception_utils::object;
 
 class SceneSegmentation
 {
+ public:
+  /** \brief Known geometry of the workspace, e.g. of a workstation the robot is aligned to.
+   * The plane is searched in the slab of the prior first, the whole cloud is only processed
+   * if the prior is rejected.
+   * */
+  struct WorkspacePrior
+  {
+    WorkspacePrior() : plane_height(0.0), height_tolerance(0.03), min_points(500) {}
+
+    // expected height of the plane in the frame of the cloud
+    double plane_height;
+    // extent of the plane in x and y, not limited in x and y with less than 3 points
+    std::vector<Eigen::Vector2f> polygon;
+    // max distance of the points and the found plane to the expected height
+    double height_tolerance;
+    // min points in the slab, the prior is rejected with less
+    int min_points;
+  };
+
  private:
   pcl::PassThrough<PointT> pass_through_;
   pcl::CropBox<PointT> crop_box_;
-  pcl::VoxelGrid<PointT> voxel_grid_;
+  mir_perception_utils::VoxelFilter<PointT> voxel_filter_;
   pcl::NormalEstimation<PointT, PointNT> normal_estimation_;
   pcl::NormalEstimationOMP<PointT, PointNT> normal_estimation_omp_;
+  pcl::IntegralImageNormalEstimation<PointT, PointNT> integral_normal_estimation_;
+  pcl::OrganizedMultiPlaneSegmentation<PointT, PointNT, pcl::Label> organized_plane_segmentation_;
 
   pcl::SACSegmentationFromNormals<PointT, PointNT> sac_;
   pcl::ProjectInliers<PointT> project_inliers_;
@@ -56,12 +80,13 @@ class SceneSegmentation
    * \param[in] Point cloud
    * \param[out] A list of point cloud clusters
    * \param[out] A list of bounding boxes
+   * \param[out] Convex hull of the workspace plane
    * \param[out] Model coefficients
    * \param[out] Workspace height
    * */
   PointCloud::Ptr segmentScene(const PointCloud::ConstPtr &cloud,
                                std::vector<PointCloud::Ptr> &clusters,
-                               std::vector<BoundingBox> &boxes,
+                               std::vector<BoundingBox> &boxes, PointCloud::Ptr &hull,
                                pcl::ModelCoefficients::Ptr &coefficients, double &workspace_height);
   /** \brief Find plane
    * \param[in] Point cloud
@@ -73,15 +98,40 @@ class SceneSegmentation
                             PointCloud::Ptr &plane, pcl::ModelCoefficients::Ptr &coefficients,
                             double &workspace_height);
 
+  /** \brief Search the plane of the next segmentations in the workspace prior first
+   * \param[in] Workspace prior
+   * */
+  void setWorkspacePrior(const WorkspacePrior &prior);
+  /** \brief Process the whole cloud again */
+  void clearWorkspacePrior();
+  /** \brief True if the plane of the last findPlane was found in the workspace prior */
+  bool isWorkspacePriorUsed() const;
+  /** \brief True if the organized plane search of the last findPlane found no plane and the
+   * cloud was voxelized */
+  bool isOrganizedPlaneMissed() const;
+  /** \brief Reason the voxel filter of the last findPlane failed and all points were kept,
+   * empty if it did not fail */
+  const std::string &getVoxelFilterError() const;
+
+  /** \brief Find the plane of the next segmentations in this organized cloud instead of the
+   * segmented cloud, e.g. the camera cloud of an accumulated scene with a single view
+   * \param[in] Organized cloud in the frame of the segmented clouds
+   * */
+  void setOrganizedCloud(const PointCloud::ConstPtr &cloud);
+  /** \brief Find the plane in the segmented cloud again */
+  void clearOrganizedCloud();
+
   /** \brief Set voxel grid parameters
    * \param[in] Leaf size for x,y,z
    * \param[in] Field name, on which axis the filter will be applied
    * \param[in] The minimum allowed the field value
    * \param[in] The maximum allowed the field value
+   * \return False if the voxel filter does not support the field, it keeps all points then
    * */
-  void setVoxelGridParams(double leaf_size, const std::string &field_name, double limit_min,
+  bool setVoxelGridParams(double leaf_size, const std::string &field_name, double limit_min,
                           double limit_max);
-  /** \brief Set passthrough filter parameters
+  /** \brief Set passthrough filter parameters. The passthrough and the crop box are applied
+   * to the input points in the pass of the voxel grid, before the points are averaged.
    * \param[in] Enable or disable passthrough filter
    * \param[in] Field name, on which axis the filter will be applied
    * \param[in] The minimum allowed the field value
@@ -108,6 +158,21 @@ class SceneSegmentation
    * \param[in] Number of cores to use for computing normal with OMP (default=4)
    * */
   void setNormalParams(double radius_search, bool use_omp = false, int num_cores = 4);
+  /** \brief Set the parameters of the plane search in organized clouds. Organized clouds are
+   * decimated instead of voxelized, their normals are estimated with integral images in the
+   * camera frame given by the sensor pose of the cloud and the planes are grown over the pixel
+   * grid, no kd-tree is built. The largest plane within the
+   * SAC eps angle of the SAC axis is the workspace, the distance threshold is the one of the
+   * SAC segmentation. Unorganized clouds and organized clouds without a plane are processed
+   * with the voxel grid, normal estimation and SAC segmentation.
+   * \param[in] Enable or disable the organized plane search
+   * \param[in] Pixel step of the decimation in rows and columns
+   * \param[in] The minimum number of points of a plane
+   * \param[in] The maximum angle between the normals of neighboring plane points in radians
+   * \param[in] Size of the area in pixels used to smooth the normals
+   * */
+  void setOrganizedPlaneParams(bool enable, int stride, int min_inliers, double angular_threshold,
+                               double normal_smoothing_size);
   /** \brief Set SAC parameters
    * \param[in] The maximum number of iterations the algorithm will run for
    * \param[in] The distance to model threshold
@@ -150,9 +215,57 @@ class SceneSegmentation
                         double cluster_min_distance_to_polygon);
 
  private:
+  /** \brief Voxelize, filter, estimate normals and fit the plane */
+  PointCloud::Ptr estimatePlane(const PointCloud::ConstPtr &cloud, PointCloud::Ptr &hull,
+                                PointCloud::Ptr &plane, pcl::ModelCoefficients::Ptr &coefficients,
+                                double &workspace_height);
+  /** \brief Decimate and filter an organized cloud, estimate its normals and find the
+   * largest plane perpendicular to the SAC axis */
+  PointCloud::Ptr estimatePlaneOrganized(const PointCloud::ConstPtr &cloud, PointCloud::Ptr &hull,
+                                         PointCloud::Ptr &plane,
+                                         pcl::ModelCoefficients::Ptr &coefficients,
+                                         double &workspace_height);
+  /** \brief Apply the limits of the voxel grid, the passthrough and the crop box with the PCL
+   * filters, for the clouds which do not go through the voxel filter
+   * \param[in,out] Cloud
+   * \param[in] Replace the filtered points by NaN points instead of removing them
+   * */
+  void applyFilterLimits(PointCloud::Ptr &cloud, bool keep_organized);
+  /** \brief Project the plane inliers, their convex hull and the mean height of the hull */
+  void computePlaneHull(const PointCloud::ConstPtr &cloud, const pcl::PointIndices::Ptr &inliers,
+                        const pcl::ModelCoefficients::Ptr &coefficients, PointCloud::Ptr &hull,
+                        PointCloud::Ptr &plane, double &workspace_height);
+  /** \brief Points of the cloud in the slab of the workspace prior
+   * \param[in] Cloud
+   * \param[in] Replace the points outside of the slab by NaN points instead of removing them
+   * \param[out] Number of points in the slab
+   * */
+  PointCloud::Ptr cropToWorkspacePrior(const PointCloud::ConstPtr &cloud, bool keep_organized,
+                                       size_t &num_points) const;
+  /** \brief Pass the passthrough limits and the crop box to the voxel filter */
+  void updateVoxelFilterBox();
+
   bool enable_passthrough_filter_;
   bool enable_cropbox_filter_;
   bool use_omp_;
+  bool enable_organized_plane_;
+  int organized_stride_;
+  std::string voxel_filter_field_;
+  double voxel_filter_limit_min_;
+  double voxel_filter_limit_max_;
+  std::string passthrough_field_;
+  double passthrough_limit_min_;
+  double passthrough_limit_max_;
+  Eigen::Vector3f cropbox_min_;
+  Eigen::Vector3f cropbox_max_;
+  // passthrough on a field other than x, y or z, applied after the voxel filter
+  bool passthrough_separate_;
+  PointCloud::ConstPtr organized_cloud_;
+  bool use_workspace_prior_;
+  bool workspace_prior_used_;
+  bool organized_plane_missed_;
+  std::string voxel_filter_error_;
+  WorkspacePrior workspace_prior_;
 };
 
 #endif  // MIR_OBJECT_SEGMENTATION_SCENE_SEGMENTATION_H
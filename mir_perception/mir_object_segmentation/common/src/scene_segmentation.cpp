@@ -4,17 +4,42 @@
  * Author: Mohammad Wasil, Santosh Thoduka
  *
  */
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 
+#include <pcl/common/transforms.h>
+#include <pcl/filters/filter.h>
+
 #include <mir_object_segmentation/scene_segmentation.h>
 
-SceneSegmentation::SceneSegmentation() : use_omp_(false)
+SceneSegmentation::SceneSegmentation()
+    : enable_passthrough_filter_(false),
+      enable_cropbox_filter_(false),
+      use_omp_(false),
+      enable_organized_plane_(false),
+      organized_stride_(2),
+      voxel_filter_limit_min_(-std::numeric_limits<double>::max()),
+      voxel_filter_limit_max_(std::numeric_limits<double>::max()),
+      passthrough_limit_min_(-std::numeric_limits<double>::max()),
+      passthrough_limit_max_(std::numeric_limits<double>::max()),
+      cropbox_min_(Eigen::Vector3f::Zero()),
+      cropbox_max_(Eigen::Vector3f::Zero()),
+      passthrough_separate_(false),
+      use_workspace_prior_(false),
+      workspace_prior_used_(false),
+      organized_plane_missed_(false)
 {
   cluster_extraction_.setSearchMethod(boost::make_shared<pcl::search::KdTree<PointT>>());
   normal_estimation_.setSearchMethod(boost::make_shared<pcl::search::KdTree<PointT>>());
   normal_estimation_omp_.setSearchMethod(boost::make_shared<pcl::search::KdTree<PointT>>());
+  integral_normal_estimation_.setNormalEstimationMethod(
+      pcl::IntegralImageNormalEstimation<PointT, PointNT>::AVERAGE_3D_GRADIENT);
+  integral_normal_estimation_.setMaxDepthChangeFactor(0.02f);
+  integral_normal_estimation_.setNormalSmoothingSize(10.0f);
 };
 SceneSegmentation::~SceneSegmentation(){
 
@@ -23,12 +48,13 @@ SceneSegmentation::~SceneSegmentation(){
 PointCloud::Ptr SceneSegmentation::segmentScene(const PointCloud::ConstPtr &cloud,
                                                 std::vector<PointCloud::Ptr> &clusters,
                                                 std::vector<BoundingBox> &boxes,
+                                                PointCloud::Ptr &hull,
                                                 pcl::ModelCoefficients::Ptr &coefficients,
                                                 double &workspace_height)
 {
   PointCloud::Ptr filtered(new PointCloud);
   PointCloud::Ptr plane(new PointCloud);
-  PointCloud::Ptr hull(new PointCloud);
+  hull = PointCloud::Ptr(new PointCloud);
   pcl::PointIndices::Ptr segmented_cloud_inliers(new pcl::PointIndices);
   std::vector<pcl::PointIndices> clusters_indices;
 
@@ -65,26 +91,158 @@ PointCloud::Ptr SceneSegmentation::findPlane(const PointCloud::ConstPtr &cloud,
                                              PointCloud::Ptr &hull, PointCloud::Ptr &plane,
                                              pcl::ModelCoefficients::Ptr &coefficients,
                                              double &workspace_height)
+{
+  workspace_prior_used_ = false;
+  organized_plane_missed_ = false;
+  voxel_filter_error_.clear();
+  const PointCloud::ConstPtr &plane_cloud = organized_cloud_ ? organized_cloud_ : cloud;
+  const bool organized = enable_organized_plane_ && plane_cloud->isOrganized();
+  if (use_workspace_prior_) {
+    // voxelize and estimate normals only for the points around the expected plane
+    size_t num_points = 0;
+    PointCloud::Ptr cropped = cropToWorkspacePrior(organized ? plane_cloud : cloud, organized,
+                                                   num_points);
+    if (static_cast<int>(num_points) >= workspace_prior_.min_points) {
+      PointCloud::Ptr filtered =
+          organized ? estimatePlaneOrganized(cropped, hull, plane, coefficients, workspace_height)
+                    : estimatePlane(cropped, hull, plane, coefficients, workspace_height);
+      if (coefficients->values.size() > 0 && hull->points.size() > 0 &&
+          std::abs(workspace_height - workspace_prior_.plane_height) <=
+              workspace_prior_.height_tolerance) {
+        workspace_prior_used_ = true;
+        return filtered;
+      }
+    }
+    coefficients->values.clear();
+    hull->points.clear();
+    plane->points.clear();
+  }
+  if (organized) {
+    PointCloud::Ptr filtered =
+        estimatePlaneOrganized(plane_cloud, hull, plane, coefficients, workspace_height);
+    if (coefficients->values.size() > 0 && hull->points.size() > 0) {
+      return filtered;
+    }
+    organized_plane_missed_ = true;
+    coefficients->values.clear();
+    hull->points.clear();
+    plane->points.clear();
+  }
+  return estimatePlane(cloud, hull, plane, coefficients, workspace_height);
+}
+
+void SceneSegmentation::setWorkspacePrior(const WorkspacePrior &prior)
+{
+  workspace_prior_ = prior;
+  workspace_prior_.height_tolerance = std::max(workspace_prior_.height_tolerance, 0.0);
+  use_workspace_prior_ = true;
+}
+
+void SceneSegmentation::clearWorkspacePrior() { use_workspace_prior_ = false; }
+
+bool SceneSegmentation::isWorkspacePriorUsed() const { return workspace_prior_used_; }
+
+bool SceneSegmentation::isOrganizedPlaneMissed() const { return organized_plane_missed_; }
+
+const std::string &SceneSegmentation::getVoxelFilterError() const { return voxel_filter_error_; }
+
+void SceneSegmentation::setOrganizedCloud(const PointCloud::ConstPtr &cloud)
+{
+  organized_cloud_ = cloud;
+}
+
+void SceneSegmentation::clearOrganizedCloud() { organized_cloud_.reset(); }
+
+PointCloud::Ptr SceneSegmentation::cropToWorkspacePrior(const PointCloud::ConstPtr &cloud,
+                                                        bool keep_organized,
+                                                        size_t &num_points) const
+{
+  PointCloud::Ptr cropped(new PointCloud);
+  cropped->header = cloud->header;
+  cropped->sensor_origin_ = cloud->sensor_origin_;
+  cropped->sensor_orientation_ = cloud->sensor_orientation_;
+  cropped->points.reserve(keep_organized ? cloud->points.size() : cloud->points.size() / 4);
+  PointT nan_point;
+  nan_point.x = nan_point.y = nan_point.z = std::numeric_limits<float>::quiet_NaN();
+  num_points = 0;
+
+  const std::vector<Eigen::Vector2f> &polygon = workspace_prior_.polygon;
+  const bool use_polygon = polygon.size() >= 3;
+  Eigen::Vector2f min_xy = Eigen::Vector2f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector2f max_xy = -min_xy;
+  for (const auto &vertex : polygon) {
+    min_xy = min_xy.cwiseMin(vertex);
+    max_xy = max_xy.cwiseMax(vertex);
+  }
+  const float min_z = workspace_prior_.plane_height - workspace_prior_.height_tolerance;
+  const float max_z = workspace_prior_.plane_height + workspace_prior_.height_tolerance;
+
+  for (const auto &point : cloud->points) {
+    // NaN points fail the comparisons
+    if (!(point.z >= min_z && point.z <= max_z) || !std::isfinite(point.x) ||
+        !std::isfinite(point.y)) {
+      if (keep_organized) cropped->points.push_back(nan_point);
+      continue;
+    }
+    if (use_polygon) {
+      if (point.x < min_xy.x() || point.x > max_xy.x() || point.y < min_xy.y() ||
+          point.y > max_xy.y()) {
+        if (keep_organized) cropped->points.push_back(nan_point);
+        continue;
+      }
+      // crossing number test
+      bool inside = false;
+      for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        if ((polygon[i].y() > point.y) != (polygon[j].y() > point.y) &&
+            point.x < (polygon[j].x() - polygon[i].x()) * (point.y - polygon[i].y()) /
+                              (polygon[j].y() - polygon[i].y()) +
+                          polygon[i].x()) {
+          inside = !inside;
+        }
+      }
+      if (!inside) {
+        if (keep_organized) cropped->points.push_back(nan_point);
+        continue;
+      }
+    }
+    cropped->points.push_back(point);
+    num_points++;
+  }
+  if (keep_organized) {
+    cropped->width = cloud->width;
+    cropped->height = cloud->height;
+    cropped->is_dense = false;
+  } else {
+    cropped->width = static_cast<uint32_t>(cropped->points.size());
+    cropped->height = 1;
+    cropped->is_dense = true;
+  }
+  return cropped;
+}
+
+PointCloud::Ptr SceneSegmentation::estimatePlane(const PointCloud::ConstPtr &cloud,
+                                                 PointCloud::Ptr &hull, PointCloud::Ptr &plane,
+                                                 pcl::ModelCoefficients::Ptr &coefficients,
+                                                 double &workspace_height)
 {
   PointCloud::Ptr filtered(new PointCloud);
   pcl::PointIndices::Ptr segmented_cloud_inliers(new pcl::PointIndices);
 
   PointCloudN::Ptr normals(new PointCloudN);
 
-  voxel_grid_.setInputCloud(cloud);
-  voxel_grid_.filter(*filtered);
-
-  if (enable_passthrough_filter_) {
+  // limits, passthrough, crop box and NaN points are removed while the points are voxelized
+  if (!voxel_filter_.filter(*cloud, *filtered)) {
+    // reported by getVoxelFilterError, the points are kept as pcl::VoxelGrid does instead
+    // of fitting the plane to an empty cloud, the limits are applied on their own then
+    voxel_filter_error_ = voxel_filter_.getError();
+    std::vector<int> indices;
+    pcl::removeNaNFromPointCloud(*cloud, *filtered, indices);
+    applyFilterLimits(filtered, false);
+  } else if (passthrough_separate_) {
     pass_through_.setInputCloud(filtered);
     pass_through_.filter(*filtered);
   }
 
-  // cropbox filter to include filters in XYZ
-  if (enable_cropbox_filter_){
-    crop_box_.setInputCloud(filtered);
-    crop_box_.filter(*filtered);
-  }
-
   if (use_omp_) {
     normal_estimation_omp_.setInputCloud(filtered);
     normal_estimation_omp_.compute(*normals);
@@ -107,8 +265,132 @@ PointCloud::Ptr SceneSegmentation::findPlane(const PointCloud::ConstPtr &cloud,
     return filtered;
   }
 
+  computePlaneHull(filtered, inliers, coefficients, hull, plane, workspace_height);
+  return filtered;
+}
+
+PointCloud::Ptr SceneSegmentation::estimatePlaneOrganized(const PointCloud::ConstPtr &cloud,
+                                                          PointCloud::Ptr &hull,
+                                                          PointCloud::Ptr &plane,
+                                                          pcl::ModelCoefficients::Ptr &coefficients,
+                                                          double &workspace_height)
+{
+  // decimate instead of voxelizing, the grid of the camera is kept
+  PointCloud::Ptr filtered(new PointCloud);
+  const uint32_t stride = static_cast<uint32_t>(organized_stride_);
+  filtered->header = cloud->header;
+  filtered->width = (cloud->width + stride - 1) / stride;
+  filtered->height = (cloud->height + stride - 1) / stride;
+  filtered->is_dense = false;
+  filtered->points.reserve(static_cast<size_t>(filtered->width) * filtered->height);
+  for (uint32_t row = 0; row < cloud->height; row += stride) {
+    const PointT *cloud_row = &cloud->points[static_cast<size_t>(row) * cloud->width];
+    for (uint32_t col = 0; col < cloud->width; col += stride) {
+      filtered->points.push_back(cloud_row[col]);
+    }
+  }
+
+  // the filters of the voxel path, filtered points are set to NaN to keep the grid
+  applyFilterLimits(filtered, true);
+
+  // the depth change factor compares the depth along the camera axis, not the height in the
+  // target frame, the normals are computed in the camera frame (the sensor pose of the cloud)
+  // and rotated back
+  const Eigen::Affine3f sensor_pose =
+      Eigen::Translation3f(cloud->sensor_origin_.head<3>()) * cloud->sensor_orientation_;
+  const bool in_camera_frame = sensor_pose.matrix().isIdentity();
+  PointCloud::Ptr camera_cloud = filtered;
+  if (!in_camera_frame) {
+    camera_cloud.reset(new PointCloud);
+    pcl::transformPointCloud(*filtered, *camera_cloud, sensor_pose.inverse());
+  }
+  PointCloudN::Ptr normals(new PointCloudN);
+  integral_normal_estimation_.setInputCloud(camera_cloud);
+  integral_normal_estimation_.compute(*normals);
+  if (!in_camera_frame) {
+    const Eigen::Matrix3f rotation = sensor_pose.rotation();
+    for (auto &normal : normals->points) {
+      // NaN normals stay NaN
+      normal.getNormalVector3fMap() = rotation * normal.getNormalVector3fMap();
+    }
+  }
+
+  std::vector<pcl::ModelCoefficients> plane_coefficients;
+  std::vector<pcl::PointIndices> plane_inliers;
+  organized_plane_segmentation_.setInputNormals(normals);
+  organized_plane_segmentation_.setInputCloud(filtered);
+  organized_plane_segmentation_.segment(plane_coefficients, plane_inliers);
+
+  // the largest plane which satisfies the axis constraint of the SAC segmentation
+  Eigen::Vector3f axis = sac_.getAxis();
+  const double eps_angle = sac_.getEpsAngle();
+  const bool use_axis = eps_angle > 0.0 && axis.norm() > 0.0;
+  if (use_axis) axis.normalize();
+  int best = -1;
+  for (size_t i = 0; i < plane_coefficients.size(); i++) {
+    const std::vector<float> &values = plane_coefficients[i].values;
+    if (values.size() < 4) continue;
+    if (use_axis) {
+      const Eigen::Vector3f normal = Eigen::Vector3f(values[0], values[1], values[2]).normalized();
+      if (std::acos(std::min(1.0f, std::abs(normal.dot(axis)))) > eps_angle) continue;
+    }
+    if (best < 0 || plane_inliers[i].indices.size() > plane_inliers[best].indices.size()) {
+      best = static_cast<int>(i);
+    }
+  }
+  if (best < 0) {
+    // reported by isOrganizedPlaneMissed, the cloud is voxelized then
+    coefficients->values.clear();
+    return filtered;
+  }
+
+  *coefficients = plane_coefficients[best];
+  coefficients->header = cloud->header;
+  // the normals face the camera, the plane normal faces along the axis
+  if (use_axis &&
+      Eigen::Vector3f(coefficients->values[0], coefficients->values[1], coefficients->values[2])
+              .dot(axis) < 0.0f) {
+    for (auto &value : coefficients->values) value = -value;
+  }
+  pcl::PointIndices::Ptr inliers(new pcl::PointIndices(plane_inliers[best]));
+  computePlaneHull(filtered, inliers, coefficients, hull, plane, workspace_height);
+  return filtered;
+}
+
+void SceneSegmentation::applyFilterLimits(PointCloud::Ptr &cloud, bool keep_organized)
+{
+  pcl::PassThrough<PointT> limits_filter;
+  if (!voxel_filter_field_.empty()) {
+    limits_filter.setFilterFieldName(voxel_filter_field_);
+    limits_filter.setFilterLimits(voxel_filter_limit_min_, voxel_filter_limit_max_);
+    limits_filter.setKeepOrganized(keep_organized);
+    limits_filter.setInputCloud(cloud);
+    limits_filter.filter(*cloud);
+  }
+
+  if (enable_passthrough_filter_) {
+    pass_through_.setKeepOrganized(keep_organized);
+    pass_through_.setInputCloud(cloud);
+    pass_through_.filter(*cloud);
+    pass_through_.setKeepOrganized(false);
+  }
+
+  if (enable_cropbox_filter_) {
+    crop_box_.setKeepOrganized(keep_organized);
+    crop_box_.setInputCloud(cloud);
+    crop_box_.filter(*cloud);
+    crop_box_.setKeepOrganized(false);
+  }
+}
+
+void SceneSegmentation::computePlaneHull(const PointCloud::ConstPtr &cloud,
+                                         const pcl::PointIndices::Ptr &inliers,
+                                         const pcl::ModelCoefficients::Ptr &coefficients,
+                                         PointCloud::Ptr &hull, PointCloud::Ptr &plane,
+                                         double &workspace_height)
+{
   project_inliers_.setModelType(pcl::SACMODEL_NORMAL_PARALLEL_PLANE);
-  project_inliers_.setInputCloud(filtered);
+  project_inliers_.setInputCloud(cloud);
   project_inliers_.setModelCoefficients(coefficients);
   project_inliers_.setIndices(inliers);
   project_inliers_.setCopyAllData(false);
@@ -126,16 +408,17 @@ PointCloud::Ptr SceneSegmentation::findPlane(const PointCloud::ConstPtr &cloud,
     z /= hull->points.size();
   }
   workspace_height = z;
-
-  return filtered;
 }
 
-void SceneSegmentation::setVoxelGridParams(double leaf_size, const std::string &filter_field,
+bool SceneSegmentation::setVoxelGridParams(double leaf_size, const std::string &filter_field,
                                            double limit_min, double limit_max)
 {
-  voxel_grid_.setLeafSize(leaf_size, leaf_size, leaf_size);
-  voxel_grid_.setFilterFieldName(filter_field);
-  voxel_grid_.setFilterLimits(limit_min, limit_max);
+  voxel_filter_.setLeafSize(static_cast<float>(leaf_size));
+  const bool supported = voxel_filter_.setFilterLimits(filter_field, limit_min, limit_max);
+  voxel_filter_field_ = filter_field;
+  voxel_filter_limit_min_ = limit_min;
+  voxel_filter_limit_max_ = limit_max;
+  return supported;
 }
 
 void SceneSegmentation::setPassthroughParams(bool enable_passthrough_filter,
@@ -145,6 +428,10 @@ void SceneSegmentation::setPassthroughParams(bool enable_passthrough_filter,
   enable_passthrough_filter_ = enable_passthrough_filter;
   pass_through_.setFilterFieldName(field_name);
   pass_through_.setFilterLimits(limit_min, limit_max);
+  passthrough_field_ = field_name;
+  passthrough_limit_min_ = limit_min;
+  passthrough_limit_max_ = limit_max;
+  updateVoxelFilterBox();
 }
 
 void SceneSegmentation::setCropBoxParams(bool enable_cropbox_filter, double min_x, double max_x,
@@ -153,6 +440,33 @@ void SceneSegmentation::setCropBoxParams(bool enable_cropbox_filter, double min_
   enable_cropbox_filter_ = enable_cropbox_filter;
   crop_box_.setMin(Eigen::Vector4f(min_x, min_y, min_z, 1.0));
   crop_box_.setMax(Eigen::Vector4f(max_x, max_y, max_z, 1.0));
+  cropbox_min_ = Eigen::Vector3f(min_x, min_y, min_z);
+  cropbox_max_ = Eigen::Vector3f(max_x, max_y, max_z);
+  updateVoxelFilterBox();
+}
+
+void SceneSegmentation::updateVoxelFilterBox()
+{
+  const float unbounded = std::numeric_limits<float>::max();
+  Eigen::Vector3f box_min = Eigen::Vector3f::Constant(-unbounded);
+  Eigen::Vector3f box_max = Eigen::Vector3f::Constant(unbounded);
+  if (enable_cropbox_filter_) {
+    box_min = cropbox_min_;
+    box_max = cropbox_max_;
+  }
+  const int axis = passthrough_field_ == "x" ? 0
+                   : passthrough_field_ == "y" ? 1
+                   : passthrough_field_ == "z" ? 2 : -1;
+  passthrough_separate_ = enable_passthrough_filter_ && axis < 0;
+  if (enable_passthrough_filter_ && axis >= 0) {
+    box_min[axis] = std::max(box_min[axis], static_cast<float>(passthrough_limit_min_));
+    box_max[axis] = std::min(box_max[axis], static_cast<float>(passthrough_limit_max_));
+  }
+  if (enable_cropbox_filter_ || (enable_passthrough_filter_ && axis >= 0)) {
+    voxel_filter_.setCropBox(box_min, box_max);
+  } else {
+    voxel_filter_.clearCropBox();
+  }
 }
 
 void SceneSegmentation::setNormalParams(double radius_search, bool use_omp, int num_cores)
@@ -165,12 +479,24 @@ void SceneSegmentation::setNormalParams(double radius_search, bool use_omp, int
     normal_estimation_.setRadiusSearch(radius_search);
   }
 }
+void SceneSegmentation::setOrganizedPlaneParams(bool enable, int stride, int min_inliers,
+                                                double angular_threshold,
+                                                double normal_smoothing_size)
+{
+  enable_organized_plane_ = enable;
+  organized_stride_ = std::max(stride, 1);
+  organized_plane_segmentation_.setMinInliers(static_cast<unsigned>(std::max(min_inliers, 1)));
+  organized_plane_segmentation_.setAngularThreshold(angular_threshold);
+  integral_normal_estimation_.setNormalSmoothingSize(static_cast<float>(normal_smoothing_size));
+}
+
 void SceneSegmentation::setSACParams(int max_iterations, double distance_threshold,
                                      bool optimize_coefficients, Eigen::Vector3f axis,
                                      double eps_angle, double normal_distance_weight)
 {
   sac_.setMaxIterations(max_iterations);
   sac_.setDistanceThreshold(distance_threshold);
+  organized_plane_segmentation_.setDistanceThreshold(distance_threshold);
   sac_.setAxis(axis);
   sac_.setEpsAngle(eps_angle);
   sac_.setOptimizeCoefficients(optimize_coefficients);
@@ -19,6 +19,9 @@
 
 #include <mir_object_segmentation/SceneSegmentationConfig.h>
 #include <mir_object_segmentation/scene_segmentation_ros.h>
+#include <mir_perception_utils/bounding_box_visualizer.h>
+#include <mir_perception_utils/clustered_point_cloud_visualizer.h>
+#include <mir_perception_utils/label_visualizer.h>
 
 /** \brief This node subscribes to pointcloud topic.
  * Inputs:
@@ -52,7 +55,9 @@ using mpu::visualization::Color;
 class SceneSegmentationNode
 {
  public:
-  SceneSegmentationNode();
+  /** \brief Constructor
+   * \param[in] Private NodeHandle of the node or nodelet */
+  explicit SceneSegmentationNode(ros::NodeHandle nh);
   virtual ~SceneSegmentationNode();
 
  private:
@@ -91,7 +96,7 @@ class SceneSegmentationNode
   unsigned int padded_cluster_size_;
 
  private:
-  void pointcloudCallback(const sensor_msgs::PointCloud2::Ptr &msg);
+  void pointcloudCallback(const sensor_msgs::PointCloud2::ConstPtr &msg);
   void eventCallback(const std_msgs::String::ConstPtr &msg);
   void configCallback(mir_object_segmentation::SceneSegmentationConfig &config, uint32_t level);
 
@@ -43,9 +43,6 @@ class SceneSegmentationROS
   virtual ~SceneSegmentationROS();
 
  private:
-  ros::NodeHandle nh_;
-  ros::ServiceClient recognize_service;
-
   /** Create unique pointer object of cloud_accumulation */
   CloudAccumulation::UPtr cloud_accumulation_;
   /** Create unique pointer for object scene_segmentation */
@@ -53,7 +50,6 @@ class SceneSegmentationROS
   SceneSegmentationUPtr scene_segmentation_;
 
   pcl::ModelCoefficients::Ptr model_coefficients_;
-  boost::shared_ptr<tf::TransformListener> tf_listener_;
 
   bool add_to_octree_;
   int pcl_object_id_;
@@ -61,6 +57,10 @@ class SceneSegmentationROS
   double workspace_height_;
 
   PointCloud::Ptr cloud_debug_;
+  PointCloud::Ptr hull_;
+
+  /** \brief Warn if the voxel filter of the last plane search failed */
+  void warnVoxelFilterError();
 
  public:
   /** \brief Find plane, segment table top point cloud and cluster them
@@ -83,6 +83,28 @@ class SceneSegmentationROS
    * */
   void findPlane(const PointCloud::ConstPtr &cloud_in, PointCloud::Ptr &cloud_debug);
 
+  /** \brief Search the plane in the given workspace prior until it is cleared
+   * \param[in] Workspace prior in the frame of the segmented clouds
+   * */
+  void setWorkspacePrior(const SceneSegmentation::WorkspacePrior &prior);
+
+  /** \brief Search the plane in the whole cloud */
+  void clearWorkspacePrior();
+
+  /** \brief True if the plane of the last segmented cloud was found in the workspace prior */
+  bool isWorkspacePriorUsed();
+
+  /** \brief True if no plane was found in the organized cloud and the cloud was voxelized */
+  bool isOrganizedPlaneMissed();
+
+  /** \brief Find the plane in the given organized cloud until it is cleared
+   * \param[in] Organized cloud in the frame of the segmented clouds
+   * */
+  void setOrganizedCloud(const PointCloud::ConstPtr &cloud);
+
+  /** \brief Find the plane in the segmented cloud */
+  void clearOrganizedCloud();
+
   /** \brief Reset accumulated cloud */
   void resetCloudAccumulation();
 
@@ -102,6 +124,9 @@ class SceneSegmentationROS
   /** Returns plane height */
   double getWorkspaceHeight();
 
+  /** Returns the convex hull of the plane of the last segmented cloud */
+  PointCloud::Ptr getWorkspaceHull();
+
   /** Reset 3D object id */
   void resetPclObjectId();
 
@@ -143,6 +168,18 @@ class SceneSegmentationROS
    * */
   void setNormalParams(double normal_radius_search, bool use_omp = false, int num_cores = 4);
 
+  /** \brief Set the plane search parameters of organized clouds
+   * \param[in] Enable or disable the organized plane search
+   * \param[in] Pixel step of the decimation
+   * \param[in] The minimum number of points of a plane
+   * \param[in] The maximum angle between the normals of neighboring plane points in radians
+   * \param[in] Size of the area in pixels used to smooth the normals
+   * */
+  void setOrganizedPlaneParams(bool enable_organized_plane, int organized_plane_stride,
+                               int organized_plane_min_inliers,
+                               double organized_plane_angular_threshold,
+                               double organized_normal_smoothing_size);
+
   /** \brief Set SAC parameters
    * \param[in] The maximum number of iterations the algorithm will run for
    * \param[in] The distance to model threshold
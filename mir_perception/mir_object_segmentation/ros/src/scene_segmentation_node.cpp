@@ -27,11 +27,12 @@
 
 #include <mir_object_segmentation/scene_segmentation_node.h>
 
-SceneSegmentationNode::SceneSegmentationNode()
-    : nh_("~"),
-      bounding_box_visualizer_("output/bounding_boxes", Color(Color::SEA_GREEN)),
-      cluster_visualizer_("output/tabletop_clusters"),
-      label_visualizer_("output/labels", Color(Color::TEAL)),
+SceneSegmentationNode::SceneSegmentationNode(ros::NodeHandle nh)
+    : nh_(nh),
+      server_(nh),
+      bounding_box_visualizer_(&nh_, "output/bounding_boxes", Color(Color::SEA_GREEN)),
+      cluster_visualizer_(boost::make_shared<ros::NodeHandle>(nh), "output/tabletop_clusters"),
+      label_visualizer_(nh, "output/labels", Color(Color::TEAL)),
       add_to_octree_(false),
       object_id_(0),
       scene_segmentation_ros_(0.0025)
@@ -53,18 +54,13 @@ SceneSegmentationNode::SceneSegmentationNode()
 }
 
 SceneSegmentationNode::~SceneSegmentationNode() {}
-void SceneSegmentationNode::pointcloudCallback(const sensor_msgs::PointCloud2::Ptr &msg)
+void SceneSegmentationNode::pointcloudCallback(const sensor_msgs::PointCloud2::ConstPtr &msg)
 {
   if (add_to_octree_) {
-    sensor_msgs::PointCloud2 msg_transformed;
-    if (!mpu::pointcloud::transformPointCloudMsg(tf_listener_, target_frame_id_, *msg,
-                                                 msg_transformed))
-      return;
-
+    // the accumulation does not need the organized layout, invalid points are dropped
     PointCloud::Ptr cloud = boost::make_shared<PointCloud>();
-    pcl::PCLPointCloud2 pc2;
-    pcl_conversions::toPCL(msg_transformed, pc2);
-    pcl::fromPCLPointCloud2(pc2, *cloud);
+    if (!mpu::pointcloud::ingestPointCloudMsg(tf_listener_, target_frame_id_, *msg, *cloud, false))
+      return;
 
     scene_segmentation_ros_.addCloudAccumulation(cloud);
 
@@ -192,12 +188,3 @@ void SceneSegmentationNode::configCallback(mir_object_segmentation::SceneSegment
   octree_resolution_ = config.octree_resolution;
   object_height_above_workspace_ = config.object_height_above_workspace;
 }
-
-int main(int argc, char **argv)
-{
-  ros::init(argc, argv, "scene_segmentation_node");
-  SceneSegmentationNode scene_seg;
-  ROS_INFO_STREAM("\033[1;32m[scene_segmentation_node] node started \033[0m\n");
-  ros::spin();
-  return 0;
-}
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#include <memory>
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <mir_object_segmentation/scene_segmentation_node.h>
+
+namespace mir_object_segmentation
+{
+/** \brief Nodelet of the scene segmentation. Loaded into the nodelet manager of the camera
+ * driver, the pointcloud is received as shared pointer without serialization.
+ */
+class SceneSegmentationNodelet : public nodelet::Nodelet
+{
+ public:
+  virtual void onInit()
+  {
+    scene_segmentation_.reset(new SceneSegmentationNode(getPrivateNodeHandle()));
+    NODELET_INFO_STREAM("[scene_segmentation] nodelet started");
+  }
+
+ private:
+  std::unique_ptr<SceneSegmentationNode> scene_segmentation_;
+};
+
+}  // namespace mir_object_segmentation
+
+PLUGINLIB_EXPORT_CLASS(mir_object_segmentation::SceneSegmentationNodelet, nodelet::Nodelet)
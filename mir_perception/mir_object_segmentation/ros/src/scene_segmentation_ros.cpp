@@ -27,6 +27,7 @@ SceneSegmentationROS::SceneSegmentationROS(double octree_resolution)
   scene_segmentation_ = SceneSegmentationUPtr(new SceneSegmentation());
   model_coefficients_ = pcl::ModelCoefficients::Ptr(new pcl::ModelCoefficients);
   cloud_debug_ = PointCloud::Ptr(new PointCloud);
+  hull_ = PointCloud::Ptr(new PointCloud);
 }
 
 SceneSegmentationROS::~SceneSegmentationROS() {}
@@ -37,8 +38,10 @@ void SceneSegmentationROS::segmentCloud(const PointCloud::ConstPtr &cloud,
                                         bool pad_cluster, int num_points)
 {
   std::string frame_id = cloud->header.frame_id;
-  cloud_debug_ = scene_segmentation_->segmentScene(cloud, clusters, boxes,
+  cloud_debug_ = scene_segmentation_->segmentScene(cloud, clusters, boxes, hull_,
                                                    model_coefficients_, workspace_height_);
+  warnVoxelFilterError();
+  hull_->header.frame_id = frame_id;
   cloud_debug_->header.frame_id = frame_id;
 
   object_list.objects.resize(boxes.size());
@@ -81,9 +84,42 @@ void SceneSegmentationROS::findPlane(const PointCloud::ConstPtr &cloud_in,
   PointCloud::Ptr plane(new PointCloud);
   cloud_debug =
       scene_segmentation_->findPlane(cloud_in, hull, plane, model_coefficients_, workspace_height_);
+  warnVoxelFilterError();
   cloud_debug->header.frame_id = cloud_in->header.frame_id;
 }
 
+void SceneSegmentationROS::warnVoxelFilterError()
+{
+  const std::string &error = scene_segmentation_->getVoxelFilterError();
+  if (!error.empty()) {
+    ROS_WARN_STREAM_THROTTLE(5.0, "[SceneSegmentationROS] Voxel filter failed, keeping all points: "
+                                      << error);
+  }
+}
+
+void SceneSegmentationROS::setWorkspacePrior(const SceneSegmentation::WorkspacePrior &prior)
+{
+  scene_segmentation_->setWorkspacePrior(prior);
+}
+
+void SceneSegmentationROS::clearWorkspacePrior() { scene_segmentation_->clearWorkspacePrior(); }
+bool SceneSegmentationROS::isWorkspacePriorUsed()
+{
+  return scene_segmentation_->isWorkspacePriorUsed();
+}
+
+bool SceneSegmentationROS::isOrganizedPlaneMissed()
+{
+  return scene_segmentation_->isOrganizedPlaneMissed();
+}
+
+void SceneSegmentationROS::setOrganizedCloud(const PointCloud::ConstPtr &cloud)
+{
+  scene_segmentation_->setOrganizedCloud(cloud);
+}
+
+void SceneSegmentationROS::clearOrganizedCloud() { scene_segmentation_->clearOrganizedCloud(); }
+
 void SceneSegmentationROS::resetCloudAccumulation() { cloud_accumulation_->reset(); }
 void SceneSegmentationROS::addCloudAccumulation(const PointCloud::Ptr &cloud)
 {
@@ -103,14 +139,18 @@ Eigen::Vector3f SceneSegmentationROS::getPlaneNormal()
 }
 
 double SceneSegmentationROS::getWorkspaceHeight() { return workspace_height_; }
+PointCloud::Ptr SceneSegmentationROS::getWorkspaceHull() { return hull_; }
 void SceneSegmentationROS::resetPclObjectId() { pcl_object_id_ = 0; }
 void SceneSegmentationROS::setVoxelGridParams(double voxel_leaf_size,
                                               std::string voxel_filter_field_name,
                                               double voxel_filter_limit_min,
                                               double voxel_filter_limit_max)
 {
-  scene_segmentation_->setVoxelGridParams(voxel_leaf_size, voxel_filter_field_name,
-                                          voxel_filter_limit_min, voxel_filter_limit_max);
+  if (!scene_segmentation_->setVoxelGridParams(voxel_leaf_size, voxel_filter_field_name,
+                                               voxel_filter_limit_min, voxel_filter_limit_max)) {
+    ROS_WARN_STREAM("[SceneSegmentationROS] Unsupported voxel filter field "
+                    << voxel_filter_field_name << ", keeping all points");
+  }
 }
 
 void SceneSegmentationROS::setPassthroughParams(bool enable_passthrough_filter,
@@ -134,6 +174,18 @@ void SceneSegmentationROS::setNormalParams(double normal_radius_search, bool use
   scene_segmentation_->setNormalParams(normal_radius_search, use_omp, num_cores);
 }
 
+void SceneSegmentationROS::setOrganizedPlaneParams(bool enable_organized_plane,
+                                                   int organized_plane_stride,
+                                                   int organized_plane_min_inliers,
+                                                   double organized_plane_angular_threshold,
+                                                   double organized_normal_smoothing_size)
+{
+  scene_segmentation_->setOrganizedPlaneParams(enable_organized_plane, organized_plane_stride,
+                                               organized_plane_min_inliers,
+                                               organized_plane_angular_threshold,
+                                               organized_normal_smoothing_size);
+}
+
 void SceneSegmentationROS::setSACParams(int sac_max_iterations, double sac_distance_threshold,
                                         bool sac_optimize_coefficients, Eigen::Vector3f axis,
                                         double sac_eps_angle, double sac_normal_distance_weight)
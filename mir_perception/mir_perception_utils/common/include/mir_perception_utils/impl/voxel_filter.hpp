@@ -0,0 +1,321 @@
+#ifndef MIR_PERCEPTION_UTILS_VOXEL_FILTER_HPP
+#define MIR_PERCEPTION_UTILS_VOXEL_FILTER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <pcl/point_traits.h>
+
+namespace mir_perception_utils
+{
+namespace detail
+{
+/** \brief Channel sums of the colour of point types with rgb or rgba, nothing otherwise */
+template <typename PointType, bool HasColor = pcl::traits::has_color<PointType>::value>
+struct VoxelColor
+{
+  template <typename Voxel>
+  static void add(const PointType &, Voxel &)
+  {
+  }
+  template <typename Voxel>
+  static void average(const Voxel &, PointType &)
+  {
+  }
+};
+
+template <typename PointType>
+struct VoxelColor<PointType, true>
+{
+  template <typename Voxel>
+  static void add(const PointType &point, Voxel &voxel)
+  {
+    voxel.r += point.r;
+    voxel.g += point.g;
+    voxel.b += point.b;
+    voxel.a += point.a;
+  }
+  template <typename Voxel>
+  static void average(const Voxel &voxel, PointType &point)
+  {
+    // truncated as in pcl::VoxelGrid
+    point.r = static_cast<uint8_t>(voxel.r / voxel.count);
+    point.g = static_cast<uint8_t>(voxel.g / voxel.count);
+    point.b = static_cast<uint8_t>(voxel.b / voxel.count);
+    point.a = static_cast<uint8_t>(voxel.a / voxel.count);
+  }
+};
+}  // namespace detail
+
+template <typename PointType>
+const uint64_t VoxelFilter<PointType>::KEY_INVALID;
+template <typename PointType>
+const int VoxelFilter<PointType>::KEY_BITS;
+
+template <typename PointType>
+VoxelFilter<PointType>::VoxelFilter()
+    : filter_axis_(-1),
+      limit_min_(-std::numeric_limits<float>::max()),
+      limit_max_(std::numeric_limits<float>::max()),
+      limits_negative_(false),
+      use_crop_box_(false),
+      crop_min_(Eigen::Vector3f::Constant(-std::numeric_limits<float>::max())),
+      crop_max_(Eigen::Vector3f::Constant(std::numeric_limits<float>::max())),
+      use_box_(false),
+      mode_(CENTROID),
+      min_points_(1),
+      generation_(0),
+      table_bits_(0)
+{
+  inverse_leaf_[0] = inverse_leaf_[1] = inverse_leaf_[2] = inverse_leaf_[3] = 0.0f;
+  updateBox();
+}
+
+template <typename PointType>
+void VoxelFilter<PointType>::setLeafSize(float leaf_size_x, float leaf_size_y, float leaf_size_z)
+{
+  inverse_leaf_[0] = leaf_size_x > 0.0f ? 1.0f / leaf_size_x : 0.0f;
+  inverse_leaf_[1] = leaf_size_y > 0.0f ? 1.0f / leaf_size_y : 0.0f;
+  inverse_leaf_[2] = leaf_size_z > 0.0f ? 1.0f / leaf_size_z : 0.0f;
+  inverse_leaf_[3] = 0.0f;
+}
+
+template <typename PointType>
+bool VoxelFilter<PointType>::setFilterLimits(const std::string &field_name, double limit_min,
+                                             double limit_max, bool limits_negative)
+{
+  filter_axis_ = field_name == "x" ? 0 : field_name == "y" ? 1 : field_name == "z" ? 2 : -1;
+  limit_min_ = static_cast<float>(limit_min);
+  limit_max_ = static_cast<float>(limit_max);
+  limits_negative_ = limits_negative;
+  updateBox();
+  if (filter_axis_ < 0 && !field_name.empty()) {
+    error_ = "unsupported filter field " + field_name + ", keeping all points";
+    return false;
+  }
+  error_.clear();
+  return true;
+}
+
+template <typename PointType>
+void VoxelFilter<PointType>::setCropBox(const Eigen::Vector3f &min_point,
+                                        const Eigen::Vector3f &max_point)
+{
+  use_crop_box_ = true;
+  crop_min_ = min_point;
+  crop_max_ = max_point;
+  updateBox();
+}
+
+template <typename PointType>
+void VoxelFilter<PointType>::clearCropBox()
+{
+  use_crop_box_ = false;
+  updateBox();
+}
+
+template <typename PointType>
+void VoxelFilter<PointType>::updateBox()
+{
+  const float unbounded = std::numeric_limits<float>::max();
+  for (int axis = 0; axis < 4; axis++) {
+    box_min_[axis] = -unbounded;
+    box_max_[axis] = unbounded;
+  }
+  if (use_crop_box_) {
+    for (int axis = 0; axis < 3; axis++) {
+      box_min_[axis] = crop_min_[axis];
+      box_max_[axis] = crop_max_[axis];
+    }
+  }
+  // negative limits are not a box, they are checked on their own
+  const bool box_limits = filter_axis_ >= 0 && !limits_negative_;
+  if (box_limits) {
+    box_min_[filter_axis_] = std::max(box_min_[filter_axis_], limit_min_);
+    box_max_[filter_axis_] = std::min(box_max_[filter_axis_], limit_max_);
+  }
+  use_box_ = use_crop_box_ || box_limits;
+}
+
+template <typename PointType>
+bool VoxelFilter<PointType>::computeKeys(const Cloud &cloud_in)
+{
+  const size_t num_points = cloud_in.points.size();
+  keys_.resize(num_points);
+  const int64_t bias = int64_t(1) << (KEY_BITS - 1);
+  const int64_t key_max = (int64_t(1) << KEY_BITS) - 1;
+  // beyond the keys, checked before the conversion to int32
+  const float scaled_max = static_cast<float>(bias + 1);
+  bool in_range = true;
+
+#ifdef __SSE2__
+  const __m128 inverse_leaf = _mm_loadu_ps(inverse_leaf_);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 limit = _mm_set1_ps(scaled_max);
+  const __m128 box_min = _mm_loadu_ps(box_min_);
+  const __m128 box_max = _mm_loadu_ps(box_max_);
+#endif
+  const bool check_negative_limits = filter_axis_ >= 0 && limits_negative_;
+  for (size_t i = 0; i < num_points; i++) {
+    const PointType &point = cloud_in.points[i];
+    keys_[i] = KEY_INVALID;
+    if (check_negative_limits) {
+      const float value = point.data[filter_axis_];
+      if (value >= limit_min_ && value <= limit_max_) continue;
+    }
+    int32_t ijk[4];
+#ifdef __SSE2__
+    // x, y and z of the point in one register, the 4th lane is multiplied by 0
+    const __m128 p = _mm_loadu_ps(point.data);
+    // limits and crop box in one compare, NaN points fail it as well
+    if (use_box_ &&
+        (_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(p, box_min), _mm_cmple_ps(p, box_max))) & 7) != 7)
+      continue;
+    const __m128 zero = _mm_sub_ps(p, p);
+    // x - x is NaN for NaN and inf
+    if ((_mm_movemask_ps(_mm_cmpord_ps(zero, zero)) & 7) != 7) continue;
+    const __m128 scaled = _mm_mul_ps(p, inverse_leaf);
+    if (_mm_movemask_ps(_mm_cmpge_ps(_mm_andnot_ps(sign, scaled), limit)) & 7) {
+      in_range = false;
+      continue;
+    }
+    // floor, the truncation is one too large for negative fractions
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(scaled));
+    const __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, scaled), one));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(ijk), _mm_cvttps_epi32(floored));
+#else
+    if (use_box_) {
+      bool inside = true;
+      for (int axis = 0; axis < 3; axis++) {
+        const float value = point.data[axis];
+        inside &= value >= box_min_[axis] && value <= box_max_[axis];
+      }
+      if (!inside) continue;
+    }
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) continue;
+    bool out_of_range = false;
+    for (int axis = 0; axis < 3; axis++) {
+      const float scaled = point.data[axis] * inverse_leaf_[axis];
+      out_of_range |= std::abs(scaled) >= scaled_max;
+      ijk[axis] = out_of_range ? 0 : static_cast<int32_t>(std::floor(scaled));
+    }
+    if (out_of_range) {
+      in_range = false;
+      continue;
+    }
+#endif
+    const int64_t i_key = ijk[0] + bias;
+    const int64_t j_key = ijk[1] + bias;
+    const int64_t k_key = ijk[2] + bias;
+    if (i_key < 0 || i_key > key_max || j_key < 0 || j_key > key_max || k_key < 0 ||
+        k_key > key_max) {
+      in_range = false;
+      continue;
+    }
+    keys_[i] = (static_cast<uint64_t>(i_key) << (2 * KEY_BITS)) |
+               (static_cast<uint64_t>(j_key) << KEY_BITS) | static_cast<uint64_t>(k_key);
+  }
+  return in_range;
+}
+
+template <typename PointType>
+void VoxelFilter<PointType>::reserveTable(size_t num_points)
+{
+  int bits = 4;
+  while ((size_t(1) << bits) < 2 * num_points) bits++;
+  if (bits > table_bits_) {
+    table_bits_ = bits;
+    table_.assign(size_t(1) << bits, Slot());
+    for (auto &slot : table_) slot.generation = 0;
+    generation_ = 0;
+  }
+  generation_++;
+  // the generation wrapped around, old slots would look occupied
+  if (generation_ == 0) {
+    for (auto &slot : table_) slot.generation = 0;
+    generation_ = 1;
+  }
+}
+
+template <typename PointType>
+uint32_t VoxelFilter<PointType>::findVoxel(uint64_t key, uint32_t point_index)
+{
+  const size_t mask = table_.size() - 1;
+  // fibonacci hashing of the packed key, linear probing
+  size_t index = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - table_bits_));
+  while (true) {
+    Slot &slot = table_[index];
+    if (slot.generation != generation_) {
+      slot.key = key;
+      slot.generation = generation_;
+      slot.voxel = static_cast<uint32_t>(voxels_.size());
+      Voxel voxel = {};
+      voxel.first = point_index;
+      voxels_.push_back(voxel);
+      return slot.voxel;
+    }
+    if (slot.key == key) return slot.voxel;
+    index = (index + 1) & mask;
+  }
+}
+
+template <typename PointType>
+bool VoxelFilter<PointType>::filter(const Cloud &cloud_in, Cloud &cloud_out)
+{
+  cloud_out.points.clear();
+  cloud_out.header = cloud_in.header;
+  cloud_out.width = 0;
+  cloud_out.height = 1;
+  cloud_out.is_dense = true;
+  if (inverse_leaf_[0] <= 0.0f || inverse_leaf_[1] <= 0.0f || inverse_leaf_[2] <= 0.0f) {
+    error_ = "leaf size is not set";
+    return false;
+  }
+  if (!computeKeys(cloud_in)) {
+    error_ = "points beyond 2^20 voxels of the origin, the leaf size is too small";
+    return false;
+  }
+  error_.clear();
+
+  const size_t num_points = cloud_in.points.size();
+  reserveTable(num_points);
+  voxels_.clear();
+  for (size_t i = 0; i < num_points; i++) {
+    if (keys_[i] == KEY_INVALID) continue;
+    Voxel &voxel = voxels_[findVoxel(keys_[i], static_cast<uint32_t>(i))];
+    voxel.count++;
+    if (mode_ == CENTROID) {
+      const PointType &point = cloud_in.points[i];
+      voxel.x += point.x;
+      voxel.y += point.y;
+      voxel.z += point.z;
+      detail::VoxelColor<PointType>::add(point, voxel);
+    }
+  }
+
+  cloud_out.points.reserve(voxels_.size());
+  for (const Voxel &voxel : voxels_) {
+    if (voxel.count < min_points_) continue;
+    cloud_out.points.push_back(cloud_in.points[voxel.first]);
+    if (mode_ == CENTROID) {
+      PointType &point = cloud_out.points.back();
+      const float count = static_cast<float>(voxel.count);
+      point.x = voxel.x / count;
+      point.y = voxel.y / count;
+      point.z = voxel.z / count;
+      detail::VoxelColor<PointType>::average(voxel, point);
+    }
+  }
+  cloud_out.width = static_cast<uint32_t>(cloud_out.points.size());
+  return true;
+}
+
+}  // namespace mir_perception_utils
+
+#endif  // MIR_PERCEPTION_UTILS_VOXEL_FILTER_HPP
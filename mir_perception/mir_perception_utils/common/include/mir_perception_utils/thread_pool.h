@@ -0,0 +1,101 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+
+#ifndef MIR_PERCEPTION_UTILS_THREAD_POOL_H
+#define MIR_PERCEPTION_UTILS_THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace mir_perception_utils
+{
+/** \brief Fixed size pool of worker threads executing tasks in FIFO order.
+ *
+ * Tasks are submitted with enqueue(), which returns a future for the result of the task.
+ * The destructor finishes all queued tasks before joining the workers.
+ */
+class ThreadPool
+{
+ public:
+  /** \brief Constructor
+   * \param[in] Number of worker threads, 0 uses the number of hardware threads
+   * */
+  explicit ThreadPool(unsigned int num_threads = 0) : stop_(false)
+  {
+    if (num_threads == 0) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < num_threads; i++) {
+      workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /** \brief Queue a task
+   * \param[in] Callable without arguments
+   * \return Future for the result of the task, exceptions thrown by the task are
+   * rethrown by future::get()
+   * */
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> enqueue(F &&f)
+  {
+    typedef typename std::result_of<F()>::type ResultT;
+    auto task = std::make_shared<std::packaged_task<ResultT()>>(std::forward<F>(f));
+    std::future<ResultT> result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([task] { (*task)(); });
+    }
+    condition_.notify_one();
+    return result;
+  }
+
+  size_t size() const { return workers_.size(); }
+
+ private:
+  void workerLoop()
+  {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (stop_ && tasks_.empty()) return;
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_;
+};
+}  // namespace mir_perception_utils
+
+#endif  // MIR_PERCEPTION_UTILS_THREAD_POOL_H
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+
+#ifndef MIR_PERCEPTION_UTILS_VOXEL_FILTER_H
+#define MIR_PERCEPTION_UTILS_VOXEL_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace mir_perception_utils
+{
+/** \brief Voxel grid downsampling with a hash table of the occupied voxels.
+ *
+ * The voxels are the ones of pcl::VoxelGrid, floor(p / leaf), and a voxel is reduced to the
+ * centroid of its points (x, y, z and each colour channel averaged) or to its first point.
+ * Instead of sorting the index array of all points, the packed key of every voxel (21 bits
+ * per axis, +-2^20 voxels around the origin) is looked up in an open addressing table, which
+ * is linear in the number of points and has no limit on the number of voxels of the bounding
+ * box. The keys are computed with SSE2 if it is available. The buffers are kept between
+ * calls, a filter which is reused for every frame does not allocate once it has seen the
+ * largest cloud.
+ *
+ * The filter limits and the crop box (e.g. of a passthrough and a crop box filter) are
+ * applied to the input points in the same pass, only the points inside of them are
+ * accumulated, there is no intermediate cloud.
+ *
+ * The points are in the order of the first point of each voxel, pcl::VoxelGrid orders them
+ * by voxel index. Fields other than x, y, z and the colour are those of the first point.
+ * Failures are not logged, the caller reports getError(). Not thread safe, use one filter
+ * per thread.
+ */
+template <typename PointType>
+class VoxelFilter
+{
+ public:
+  typedef pcl::PointCloud<PointType> Cloud;
+
+  enum Mode
+  {
+    CENTROID,
+    FIRST_POINT
+  };
+
+  VoxelFilter();
+
+  /** \brief Set the leaf size
+   * \param[in] Leaf size for x, y and z
+   * */
+  void setLeafSize(float leaf_size) { setLeafSize(leaf_size, leaf_size, leaf_size); }
+  void setLeafSize(float leaf_size_x, float leaf_size_y, float leaf_size_z);
+
+  /** \brief Only keep the points within the limits of a field, as pcl::VoxelGrid
+   * \param[in] Field name, "x", "y" or "z", empty to keep all points
+   * \param[in] The minimum allowed field value
+   * \param[in] The maximum allowed field value
+   * \param[in] Keep the points outside of the limits instead
+   * \return False if the field is not supported, all points are kept then
+   * */
+  bool setFilterLimits(const std::string &field_name, double limit_min, double limit_max,
+                       bool limits_negative = false);
+
+  /** \brief Only keep the points inside of an axis aligned box, in addition to the limits
+   * \param[in] Minimum x, y and z
+   * \param[in] Maximum x, y and z
+   * */
+  void setCropBox(const Eigen::Vector3f &min_point, const Eigen::Vector3f &max_point);
+  /** \brief Remove the crop box, the filter limits are kept */
+  void clearCropBox();
+
+  /** \brief Centroid of the points of a voxel (default) or its first point */
+  void setMode(Mode mode) { mode_ = mode; }
+
+  /** \brief Voxels with fewer points are removed (default 1) */
+  void setMinPointsPerVoxel(unsigned int min_points) { min_points_ = min_points; }
+
+  /** \brief Downsample a cloud
+   * \param[in] Input cloud, non-finite points are skipped
+   * \param[out] Downsampled cloud, must not be the input cloud
+   * \return False if the leaf size is not set or a point is too far from the origin for
+   *         the leaf size, the output is empty then
+   * */
+  bool filter(const Cloud &cloud_in, Cloud &cloud_out);
+
+  /** \brief Reason of the last failed filter or setFilterLimits call, empty if it succeeded */
+  const std::string &getError() const { return error_; }
+
+ private:
+  struct Voxel
+  {
+    uint32_t count;
+    uint32_t first;
+    float x, y, z;
+    uint32_t r, g, b, a;
+  };
+
+  struct Slot
+  {
+    uint64_t key;
+    uint32_t generation;
+    uint32_t voxel;
+  };
+
+  /** \brief Packed voxel key of every point, KEY_INVALID for skipped points */
+  bool computeKeys(const Cloud &cloud_in);
+  /** \brief Grow the table to at least twice the number of points */
+  void reserveTable(size_t num_points);
+  /** \brief Voxel of a key, a new voxel is added if the key is not in the table */
+  uint32_t findVoxel(uint64_t key, uint32_t point_index);
+  /** \brief Intersection of the crop box and the (positive) filter limits */
+  void updateBox();
+
+  static const uint64_t KEY_INVALID = ~uint64_t(0);
+  static const int KEY_BITS = 21;
+
+  float inverse_leaf_[4];
+  int filter_axis_;
+  float limit_min_;
+  float limit_max_;
+  bool limits_negative_;
+  bool use_crop_box_;
+  Eigen::Vector3f crop_min_;
+  Eigen::Vector3f crop_max_;
+  // the points inside of the box are kept, 4th lane unbounded
+  bool use_box_;
+  float box_min_[4];
+  float box_max_[4];
+  Mode mode_;
+  unsigned int min_points_;
+
+  std::vector<uint64_t> keys_;
+  std::vector<Voxel> voxels_;
+  std::vector<Slot> table_;
+  // slots of older calls are empty, the table is not cleared between calls
+  uint32_t generation_;
+  int table_bits_;
+
+  std::string error_;
+};
+
+}  // namespace mir_perception_utils
+
+#include "impl/voxel_filter.hpp"
+
+#endif  // MIR_PERCEPTION_UTILS_VOXEL_FILTER_H
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+
+#include <gtest/gtest.h>
+
+#include <pcl/filters/crop_box.h>
+#include <pcl/filters/voxel_grid.h>
+
+#include <mir_perception_utils/voxel_filter.h>
+
+using mir_perception_utils::VoxelFilter;
+
+typedef pcl::PointXYZRGB PointType;
+typedef pcl::PointCloud<PointType> Cloud;
+typedef std::tuple<int, int, int> VoxelIndex;
+
+class VoxelFilterTest : public ::testing::Test
+{
+ protected:
+  /** \brief Random coloured points around the origin, every 97th point is NaN */
+  VoxelFilterTest()
+  {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coordinate(-1.5f, 1.5f);
+    for (size_t i = 0; i < 200000; i++) {
+      PointType point;
+      point.x = i % 97 == 0 ? std::numeric_limits<float>::quiet_NaN() : coordinate(rng);
+      point.y = coordinate(rng);
+      point.z = coordinate(rng) * 0.3f;
+      point.r = static_cast<uint8_t>(rng() % 256);
+      point.g = static_cast<uint8_t>(rng() % 256);
+      point.b = static_cast<uint8_t>(rng() % 256);
+      point.a = 255;
+      cloud_.points.push_back(point);
+    }
+    cloud_.width = static_cast<uint32_t>(cloud_.points.size());
+    cloud_.height = 1;
+    cloud_.is_dense = false;
+    grid_.setDownsampleAllData(true);
+  }
+
+  VoxelIndex voxelOf(const PointType &point)
+  {
+    const Eigen::Vector3i ijk = grid_.getGridCoordinates(point.x, point.y, point.z);
+    return VoxelIndex(ijk.x(), ijk.y(), ijk.z());
+  }
+
+  /** \brief Same voxels as pcl::VoxelGrid, with the same centroids and colours */
+  void expectGridVoxels(const Cloud &input, const Cloud &filtered)
+  {
+    Cloud expected;
+    grid_.setInputCloud(input.makeShared());
+    grid_.filter(expected);
+    ASSERT_GT(expected.points.size(), 0u);
+    ASSERT_EQ(filtered.points.size(), expected.points.size());
+    EXPECT_EQ(filtered.width, expected.points.size());
+
+    std::map<VoxelIndex, PointType> voxels;
+    for (const auto &point : expected.points) voxels[voxelOf(point)] = point;
+    for (const auto &point : filtered.points) {
+      const auto voxel = voxels.find(voxelOf(point));
+      ASSERT_NE(voxel, voxels.end());
+      EXPECT_NEAR(point.x, voxel->second.x, 1e-5);
+      EXPECT_NEAR(point.y, voxel->second.y, 1e-5);
+      EXPECT_NEAR(point.z, voxel->second.z, 1e-5);
+      // both truncate the average, pcl::VoxelGrid averages in float
+      EXPECT_LE(std::abs(point.r - voxel->second.r), 1);
+      EXPECT_LE(std::abs(point.g - voxel->second.g), 1);
+      EXPECT_LE(std::abs(point.b - voxel->second.b), 1);
+      voxels.erase(voxel);
+    }
+  }
+
+  Cloud cloud_;
+  pcl::VoxelGrid<PointType> grid_;
+  VoxelFilter<PointType> filter_;
+  Cloud filtered_;
+};
+
+// the test is built with and without SSE2, both paths of the key computation are covered
+TEST_F(VoxelFilterTest, CentroidMatchesVoxelGrid)
+{
+  const float leaf = 0.009f;
+  filter_.setLeafSize(leaf);
+  filter_.setFilterLimits("z", -0.15, 0.25);
+  // the buffers of the previous calls are reused
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(filter_.filter(cloud_, filtered_));
+  }
+
+  grid_.setLeafSize(leaf, leaf, leaf);
+  grid_.setFilterFieldName("z");
+  grid_.setFilterLimits(-0.15, 0.25);
+  expectGridVoxels(cloud_, filtered_);
+}
+
+TEST_F(VoxelFilterTest, CropBoxMatchesCropBoxAndVoxelGrid)
+{
+  const float leaf = 0.009f;
+  filter_.setLeafSize(leaf);
+  filter_.setFilterLimits("z", -0.15, 0.25);
+  filter_.setCropBox(Eigen::Vector3f(-1.0f, -0.5f, -1.0f), Eigen::Vector3f(0.7f, 1.2f, 0.2f));
+  ASSERT_TRUE(filter_.filter(cloud_, filtered_));
+
+  Cloud cropped;
+  pcl::CropBox<PointType> crop_box;
+  crop_box.setMin(Eigen::Vector4f(-1.0f, -0.5f, -1.0f, 1.0f));
+  crop_box.setMax(Eigen::Vector4f(0.7f, 1.2f, 0.2f, 1.0f));
+  crop_box.setInputCloud(cloud_.makeShared());
+  crop_box.filter(cropped);
+  grid_.setLeafSize(leaf, leaf, leaf);
+  grid_.setFilterFieldName("z");
+  grid_.setFilterLimits(-0.15, 0.25);
+  expectGridVoxels(cropped, filtered_);
+
+  // the filter limits are kept without the crop box
+  filter_.clearCropBox();
+  ASSERT_TRUE(filter_.filter(cloud_, filtered_));
+  expectGridVoxels(cloud_, filtered_);
+}
+
+TEST_F(VoxelFilterTest, NegativeLimitsAndMinPointsMatchVoxelGrid)
+{
+  const float leaf = 0.05f;
+  filter_.setLeafSize(leaf);
+  filter_.setFilterLimits("x", -0.5, 0.5, true);
+  filter_.setMinPointsPerVoxel(5);
+  ASSERT_TRUE(filter_.filter(cloud_, filtered_));
+
+  grid_.setLeafSize(leaf, leaf, leaf);
+  grid_.setFilterFieldName("x");
+  grid_.setFilterLimits(-0.5, 0.5);
+  grid_.setFilterLimitsNegative(true);
+  grid_.setMinimumPointsNumberPerVoxel(5);
+  expectGridVoxels(cloud_, filtered_);
+  for (const auto &point : filtered_.points) {
+    EXPECT_FALSE(point.x > -0.5f && point.x < 0.5f);
+  }
+}
+
+TEST_F(VoxelFilterTest, FirstPointKeepsTheVoxelsOfVoxelGrid)
+{
+  const float leaf = 0.01f;
+  filter_.setLeafSize(leaf);
+  filter_.setMode(VoxelFilter<PointType>::FIRST_POINT);
+  ASSERT_TRUE(filter_.filter(cloud_, filtered_));
+
+  Cloud expected;
+  grid_.setLeafSize(leaf, leaf, leaf);
+  grid_.setInputCloud(cloud_.makeShared());
+  grid_.filter(expected);
+  std::set<VoxelIndex> voxels;
+  for (const auto &point : expected.points) voxels.insert(voxelOf(point));
+  ASSERT_EQ(filtered_.points.size(), voxels.size());
+  for (const auto &point : filtered_.points) {
+    // one point per voxel
+    EXPECT_EQ(voxels.erase(voxelOf(point)), 1u);
+  }
+}
+
+TEST_F(VoxelFilterTest, RejectsUnsetLeafAndFarPoints)
+{
+  Cloud cloud;
+  PointType point;
+  point.x = point.y = point.z = 0.5f;
+  cloud.points.push_back(point);
+
+  EXPECT_FALSE(filter_.filter(cloud, filtered_));
+  EXPECT_TRUE(filtered_.points.empty());
+  EXPECT_FALSE(filter_.getError().empty());
+
+  // 2^20 voxels of 1e-7 m are about 0.1 m
+  filter_.setLeafSize(1e-7f);
+  EXPECT_FALSE(filter_.filter(cloud, filtered_));
+  EXPECT_TRUE(filtered_.points.empty());
+
+  filter_.setLeafSize(0.1f);
+  ASSERT_TRUE(filter_.filter(cloud, filtered_));
+  EXPECT_EQ(filtered_.points.size(), 1u);
+  EXPECT_TRUE(filter_.getError().empty());
+
+  // fields other than x, y and z keep all points
+  EXPECT_FALSE(filter_.setFilterLimits("rgb", 0.0, 1.0));
+  EXPECT_FALSE(filter_.getError().empty());
+  ASSERT_TRUE(filter_.filter(cloud, filtered_));
+  EXPECT_EQ(filtered_.points.size(), 1u);
+  EXPECT_TRUE(filter_.setFilterLimits("z", 0.0, 1.0));
+  EXPECT_TRUE(filter_.getError().empty());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -13,7 +13,10 @@
 #include <ros/ros.h>
 
 #include <mas_perception_msgs/BoundingBox.h>
+#include <visualization_msgs/Marker.h>
+
 #include <mir_perception_utils/color.h>
+#include <mir_perception_utils/lazy_publisher.h>
 
 using mir_perception_utils::visualization::Color;
 
@@ -36,8 +39,11 @@ class BoundingBoxVisualizer
 
   int getNumSubscribers();
 
+  /** \brief True if published boxes would be received, the boxes need not be computed otherwise */
+  bool isActive() const;
+
  private:
-  ros::Publisher marker_publisher_;
+  LazyPublisher<visualization_msgs::Marker> marker_publisher_;
 
   const Color color_;
   bool check_subscribers_;
@@ -11,10 +11,12 @@
 #include <vector>
 
 #include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
 
 #include <pcl/point_cloud.h>
 
 #include <mir_perception_utils/color.h>
+#include <mir_perception_utils/lazy_publisher.h>
 
 namespace mir_perception_utils
 {
@@ -33,8 +35,11 @@ class ClusteredPointCloudVisualizer
                const std::string &frame_id);
   int getNumSubscribers();
 
+  /** \brief True if published clusters would be received */
+  bool isActive() const;
+
  private:
-  ros::Publisher cloud_publisher_;
+  LazyPublisher<sensor_msgs::PointCloud2> cloud_publisher_;
 
   bool check_subscribers_;
 
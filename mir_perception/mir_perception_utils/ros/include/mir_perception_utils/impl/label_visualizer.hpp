@@ -13,43 +13,48 @@ namespace mir_perception_utils
 {
 namespace visualization
 {
-LabelVisualizer::LabelVisualizer(const ros::NodeHandle &nh, const std::string &topic_name,
+inline LabelVisualizer::LabelVisualizer(const ros::NodeHandle &nh, const std::string &topic_name,
                                  Color color, bool check_subscribers)
     : color_(color), check_subscribers_(check_subscribers)
 {
   ros::NodeHandle nh_(nh);
-  marker_publisher_ = nh_.advertise<visualization_msgs::MarkerArray>(topic_name, 10);
+  marker_publisher_ =
+      LazyPublisher<visualization_msgs::MarkerArray>(nh_, topic_name, 10, check_subscribers);
 }
 
-LabelVisualizer::LabelVisualizer(const std::string &topic_name, Color color, bool check_subscribers)
+inline LabelVisualizer::LabelVisualizer(const std::string &topic_name, Color color, bool check_subscribers)
     : color_(color), check_subscribers_(check_subscribers)
 {
   ros::NodeHandle nh("~");
-  marker_publisher_ = nh.advertise<visualization_msgs::MarkerArray>(topic_name, 10);
+  marker_publisher_ =
+      LazyPublisher<visualization_msgs::MarkerArray>(nh, topic_name, 10, check_subscribers);
 }
 
-int LabelVisualizer::getNumSubscribers() { return marker_publisher_.getNumSubscribers(); }
-void LabelVisualizer::publish(const std::vector<std::string> &labels,
+inline int LabelVisualizer::getNumSubscribers() { return marker_publisher_.getNumSubscribers(); }
+inline bool LabelVisualizer::isActive() const { return marker_publisher_.isActive(); }
+inline void LabelVisualizer::publish(const std::vector<std::string> &labels,
                               const geometry_msgs::PoseArray &poses)
 {
-  visualization_msgs::MarkerArray markers;
-  for (int i = 0; i < labels.size(); i++) {
-    visualization_msgs::Marker m;
-    m.header = poses.header;
-    m.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
-    m.action = visualization_msgs::Marker::ADD;
-    m.scale.z = 0.04;
-    m.color = std_msgs::ColorRGBA(color_);
-    m.ns = "labels";
-    m.id = i;
-    m.pose.position.x = poses.poses[i].position.x;
-    m.pose.position.y = poses.poses[i].position.y + 0.02;
-    m.pose.position.z = poses.poses[i].position.z;
-    m.pose.orientation.w = 1.0;
-    m.text = labels[i];
-    markers.markers.push_back(m);
-  }
-  marker_publisher_.publish(markers);
+  marker_publisher_.publish([&] {
+    visualization_msgs::MarkerArray markers;
+    for (int i = 0; i < labels.size(); i++) {
+      visualization_msgs::Marker m;
+      m.header = poses.header;
+      m.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+      m.action = visualization_msgs::Marker::ADD;
+      m.scale.z = 0.04;
+      m.color = std_msgs::ColorRGBA(color_);
+      m.ns = "labels";
+      m.id = i;
+      m.pose.position.x = poses.poses[i].position.x;
+      m.pose.position.y = poses.poses[i].position.y + 0.02;
+      m.pose.position.z = poses.poses[i].position.z;
+      m.pose.orientation.w = 1.0;
+      m.text = labels[i];
+      markers.markers.push_back(m);
+    }
+    return markers;
+  });
 }
 }
 }
@@ -5,26 +5,27 @@ namespace mir_perception_utils
 {
 namespace visualization
 {
-PlanarPolygonVisualizer::PlanarPolygonVisualizer(const std::string &topic_name, Color color,
+inline PlanarPolygonVisualizer::PlanarPolygonVisualizer(const std::string &topic_name, Color color,
                                                  bool check_subscribers, double thickness)
     : color_(color), check_subscribers_(check_subscribers), thickness_(thickness)
 {
   ros::NodeHandle nh("~");
-  marker_publisher_ = nh.advertise<visualization_msgs::Marker>(topic_name, 1);
+  marker_publisher_ = LazyPublisher<visualization_msgs::Marker>(nh, topic_name, 1, check_subscribers);
 }
 
 template <typename PointT>
-void PlanarPolygonVisualizer::publish(const pcl::PlanarPolygon<PointT> &polygon,
+inline void PlanarPolygonVisualizer::publish(const pcl::PlanarPolygon<PointT> &polygon,
                                       const std::string &frame_id)
 {
-  if (marker_publisher_.getNumSubscribers() == 0) return;
-  visualization_msgs::Marker marker;
-  buildPolygonMarker<PointT>(polygon.getContour(), marker, frame_id);
-  marker_publisher_.publish(marker);
+  marker_publisher_.publish([&] {
+    visualization_msgs::Marker marker;
+    buildPolygonMarker<PointT>(polygon.getContour(), marker, frame_id);
+    return marker;
+  });
 }
 
 template <typename PointT>
-void PlanarPolygonVisualizer::buildPolygonMarker(
+inline void PlanarPolygonVisualizer::buildPolygonMarker(
     const typename pcl::PointCloud<PointT>::VectorType &points, visualization_msgs::Marker &marker,
     const std::string &frame_id, int id)
 {
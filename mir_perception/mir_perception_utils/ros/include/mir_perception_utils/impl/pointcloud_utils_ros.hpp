@@ -0,0 +1,128 @@
+#ifndef POINTCLOUD_UTILS_ROS_HPP
+#define POINTCLOUD_UTILS_ROS_HPP
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <pcl/common/transforms.h>
+#include <pcl/filters/filter.h>
+#include <pcl/point_traits.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+namespace mir_perception_utils
+{
+namespace pointcloud
+{
+namespace detail
+{
+/** \brief Byte offset of a 4 byte field of the points, -1 if there is no such field */
+inline int fieldOffset(const sensor_msgs::PointCloud2 &cloud, const std::string &name, bool float_only)
+{
+  for (const auto &field : cloud.fields) {
+    if (field.name != name || field.count != 1) continue;
+    if (field.datatype == sensor_msgs::PointField::FLOAT32 ||
+        (!float_only && (field.datatype == sensor_msgs::PointField::UINT32 ||
+                         field.datatype == sensor_msgs::PointField::INT32))) {
+      return static_cast<int>(field.offset);
+    }
+  }
+  return -1;
+}
+
+template <typename PointType>
+inline void copyColor(const uint8_t *point_data, int rgb_offset, PointType &point, std::true_type)
+{
+  if (rgb_offset >= 0) std::memcpy(&point.rgba, point_data + rgb_offset, sizeof(uint32_t));
+}
+
+template <typename PointType>
+inline void copyColor(const uint8_t *, int, PointType &, std::false_type)
+{
+}
+
+/** The sensor pose of the cloud is the transform of its source frame, so that e.g. the depth
+ * of organized clouds can be recovered after the transform. */
+template <typename PointType>
+inline void setSensorPose(const Eigen::Matrix4f &transform, pcl::PointCloud<PointType> &cloud)
+{
+  cloud.sensor_origin_ = Eigen::Vector4f(transform(0, 3), transform(1, 3), transform(2, 3), 0.0f);
+  cloud.sensor_orientation_ = Eigen::Quaternionf(Eigen::Matrix3f(transform.topLeftCorner<3, 3>()));
+}
+}  // namespace detail
+
+template <typename PointType>
+bool ingestPointCloudMsg(const sensor_msgs::PointCloud2 &cloud_in, const Eigen::Matrix4f &transform,
+                         pcl::PointCloud<PointType> &cloud_out, bool keep_organized)
+{
+  const int x_offset = detail::fieldOffset(cloud_in, "x", true);
+  const int y_offset = detail::fieldOffset(cloud_in, "y", true);
+  const int z_offset = detail::fieldOffset(cloud_in, "z", true);
+  int rgb_offset = detail::fieldOffset(cloud_in, "rgb", false);
+  if (rgb_offset < 0) rgb_offset = detail::fieldOffset(cloud_in, "rgba", false);
+  const int max_offset = std::max(std::max(x_offset, y_offset), std::max(z_offset, rgb_offset));
+
+  if (x_offset < 0 || y_offset < 0 || z_offset < 0 || cloud_in.is_bigendian ||
+      max_offset + sizeof(float) > cloud_in.point_step) {
+    // layout which is not read directly, convert and transform in separate passes
+    pcl::fromROSMsg(cloud_in, cloud_out);
+    pcl::transformPointCloud(cloud_out, cloud_out, transform);
+    if (!keep_organized) {
+      std::vector<int> indices;
+      pcl::removeNaNFromPointCloud(cloud_out, cloud_out, indices);
+    }
+    detail::setSensorPose(transform, cloud_out);
+    return x_offset >= 0 && y_offset >= 0 && z_offset >= 0;
+  }
+  if (cloud_in.data.size() < static_cast<size_t>(cloud_in.row_step) * cloud_in.height ||
+      cloud_in.row_step < cloud_in.point_step * cloud_in.width) {
+    ROS_ERROR("Pointcloud data size does not match its width, height and steps");
+    return (false);
+  }
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::integral_constant<bool, pcl::traits::has_color<PointType>::value> has_color;
+  cloud_out.points.resize(static_cast<size_t>(cloud_in.width) * cloud_in.height);
+  size_t num_points = 0;
+  for (uint32_t row = 0; row < cloud_in.height; row++) {
+    const uint8_t *row_data = &cloud_in.data[static_cast<size_t>(row) * cloud_in.row_step];
+    for (uint32_t col = 0; col < cloud_in.width; col++) {
+      const uint8_t *point_data = row_data + col * cloud_in.point_step;
+      Eigen::Vector4f xyz(0.0f, 0.0f, 0.0f, 1.0f);
+      std::memcpy(&xyz[0], point_data + x_offset, sizeof(float));
+      std::memcpy(&xyz[1], point_data + y_offset, sizeof(float));
+      std::memcpy(&xyz[2], point_data + z_offset, sizeof(float));
+      const bool valid = std::isfinite(xyz[0]) && std::isfinite(xyz[1]) && std::isfinite(xyz[2]);
+      if (!valid && !keep_organized) continue;
+
+      PointType &point = cloud_out.points[num_points++];
+      if (valid) {
+        point.getVector4fMap() = transform * xyz;
+      } else {
+        point.x = point.y = point.z = nan;
+      }
+      detail::copyColor(point_data, rgb_offset, point, has_color);
+    }
+  }
+  cloud_out.points.resize(num_points);
+
+  pcl_conversions::toPCL(cloud_in.header, cloud_out.header);
+  detail::setSensorPose(transform, cloud_out);
+  if (keep_organized) {
+    cloud_out.width = cloud_in.width;
+    cloud_out.height = cloud_in.height;
+    cloud_out.is_dense = cloud_in.is_dense;
+  } else {
+    cloud_out.width = static_cast<uint32_t>(num_points);
+    cloud_out.height = 1;
+    cloud_out.is_dense = true;
+  }
+  return (true);
+}
+
+}  // namespace pointcloud
+}  // namespace mir_perception_utils
+
+#endif  // POINTCLOUD_UTILS_ROS_HPP
@@ -12,8 +12,10 @@
 
 #include <geometry_msgs/PoseArray.h>
 #include <ros/ros.h>
+#include <visualization_msgs/MarkerArray.h>
 
 #include <mir_perception_utils/color.h>
+#include <mir_perception_utils/lazy_publisher.h>
 
 using mir_perception_utils::visualization::Color;
 
@@ -33,8 +35,11 @@ class LabelVisualizer
 
   int getNumSubscribers();
 
+  /** \brief True if published labels would be received, the labels need not be computed otherwise */
+  bool isActive() const;
+
  private:
-  ros::Publisher marker_publisher_;
+  LazyPublisher<visualization_msgs::MarkerArray> marker_publisher_;
 
   const Color color_;
   bool check_subscribers_;
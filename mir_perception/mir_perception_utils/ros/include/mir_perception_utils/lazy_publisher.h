@@ -0,0 +1,80 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+#ifndef MIR_PERCEPTION_UTILS_LAZY_PUBLISHER_H
+#define MIR_PERCEPTION_UTILS_LAZY_PUBLISHER_H
+
+#include <string>
+#include <utility>
+
+#include <ros/ros.h>
+
+namespace mir_perception_utils
+{
+/** \brief Publisher for debug and visualization outputs, the message is only built if
+ * somebody listens.
+ *
+ * publish() takes a producer (e.g. a lambda) which returns the message, or a shared
+ * pointer to it, and runs it only if the topic has subscribers. With check_subscribers
+ * set to false the producer always runs, e.g. for topics which are recorded by rosbag
+ * from a remote machine. Latched topics always run the producer, so that subscribers which
+ * connect later receive the latest message and not a stale one.
+ *
+ * \code
+ * debug_cloud_.publish([&] {
+ *   sensor_msgs::PointCloud2 msg;
+ *   pcl::toROSMsg(*cloud, msg);
+ *   return msg;
+ * });
+ * \endcode
+ */
+template <typename MessageT>
+class LazyPublisher
+{
+ public:
+  LazyPublisher() : check_subscribers_(true) {}
+
+  /** \brief Constructor
+   * \param[in] NodeHandle to advertise the topic with
+   * \param[in] Topic name
+   * \param[in] Queue size
+   * \param[in] Run the producers only if the topic has subscribers, ignored if latched
+   * \param[in] Latch the last message
+   * */
+  LazyPublisher(ros::NodeHandle &nh, const std::string &topic_name, uint32_t queue_size,
+                bool check_subscribers = true, bool latch = false)
+      : check_subscribers_(check_subscribers && !latch)
+  {
+    publisher_ = nh.advertise<MessageT>(topic_name, queue_size, latch);
+  }
+
+  /** \brief True if a published message would be received by anybody */
+  bool isActive() const
+  {
+    return publisher_ && (!check_subscribers_ || publisher_.getNumSubscribers() > 0);
+  }
+
+  /** \brief Build and publish the message if the topic is active
+   * \param[in] Producer returning the message or a shared pointer to it
+   * \return True if the producer was run
+   * */
+  template <typename ProducerT>
+  bool publish(ProducerT &&producer) const
+  {
+    if (!isActive()) return false;
+    publisher_.publish(std::forward<ProducerT>(producer)());
+    return true;
+  }
+
+  uint32_t getNumSubscribers() const { return publisher_ ? publisher_.getNumSubscribers() : 0; }
+
+  std::string getTopic() const { return publisher_.getTopic(); }
+
+ private:
+  ros::Publisher publisher_;
+  bool check_subscribers_;
+};
+
+}  // namespace mir_perception_utils
+
+#endif  // MIR_PERCEPTION_UTILS_LAZY_PUBLISHER_H
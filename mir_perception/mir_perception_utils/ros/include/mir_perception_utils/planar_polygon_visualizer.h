@@ -16,6 +16,7 @@
 #include <pcl/point_cloud.h>
 
 #include <mir_perception_utils/color.h>
+#include <mir_perception_utils/lazy_publisher.h>
 
 namespace mir_perception_utils
 {
@@ -38,7 +39,7 @@ class PlanarPolygonVisualizer
                           int id = 1);
 
  private:
-  ros::Publisher marker_publisher_;
+  LazyPublisher<visualization_msgs::Marker> marker_publisher_;
 
   const std::string frame_id_;
   const Color color_;
@@ -8,6 +8,10 @@
 #ifndef MIR_PERCCEPTION_UTILS_POINTCLOUD_UTILS_ROS_H
 #define MIR_PERCCEPTION_UTILS_POINTCLOUD_UTILS_ROS_H
 
+#include <string>
+
+#include <Eigen/Dense>
+
 #include <ros/ros.h>
 
 #include <pcl_ros/point_cloud.h>
@@ -22,16 +26,46 @@ namespace mir_perception_utils
 {
 namespace pointcloud
 {
-/** \brief Transform sensor_msgs PointCloud2
+/** \brief Transform sensor_msgs PointCloud2, the input is not modified
 * \param[in] Transform listener
 * \param[in] Target frame id
 * \param[in] sensor_msgs PointCloud2 input
 * \param[in] sensor_msgs PointCloud2 output
+* \param[in] Frame id of the input, overrides the frame id of its header if not empty
 */
 bool transformPointCloudMsg(const boost::shared_ptr<tf::TransformListener> &tf_listener,
                             const std::string &target_frame,
                             const sensor_msgs::PointCloud2 &cloud_in,
-                            sensor_msgs::PointCloud2 &cloud_out);
+                            sensor_msgs::PointCloud2 &cloud_out,
+                            const std::string &source_frame = "");
+
+/** \brief Convert a sensor_msgs PointCloud2 to a pcl PointCloud and transform it in a single
+ * pass over the message buffer, without intermediate messages or clouds. Messages whose x, y
+ * and z are not float32 are converted and transformed in separate passes.
+* \param[in] sensor_msgs PointCloud2 input
+* \param[in] Transform applied to the points
+* \param[out] pcl PointCloud output, its memory is reused, the sensor pose is the transform
+* \param[in] Keep the organized layout with invalid points as NaN, otherwise invalid points
+*     are dropped
+* \return False if the input has no x, y and z or its data does not match its size
+*/
+template <typename PointType>
+bool ingestPointCloudMsg(const sensor_msgs::PointCloud2 &cloud_in, const Eigen::Matrix4f &transform,
+                         pcl::PointCloud<PointType> &cloud_out, bool keep_organized = true);
+
+/** \brief Transform sensor_msgs PointCloud2 to the target frame and convert it to a pcl
+ * PointCloud in a single pass, see ingestPointCloudMsg above, the input is not modified
+* \param[in] Transform listener
+* \param[in] Target frame id
+* \param[in] sensor_msgs PointCloud2 input
+* \param[out] pcl PointCloud output in the target frame, its memory is reused
+* \param[in] Keep the organized layout with invalid points as NaN
+* \param[in] Frame id of the input, overrides the frame id of its header if not empty
+*/
+bool ingestPointCloudMsg(const boost::shared_ptr<tf::TransformListener> &tf_listener,
+                         const std::string &target_frame, const sensor_msgs::PointCloud2 &cloud_in,
+                         PointCloud &cloud_out, bool keep_organized = true,
+                         const std::string &source_frame = "");
 
 /** \brief Transform pcl PointCloud
  * \param[in] Transform listener
@@ -64,5 +98,6 @@ bool getPointCloudROI(const sensor_msgs::RegionOfInterest &roi, const PointCloud
                       PointCloud::Ptr &cloud_roi, float roi_size_adjustment, bool remove_outliers);
 }
 };
+#include "impl/pointcloud_utils_ros.hpp"
 
 #endif  // MIR_PERCCEPTION_UTILS_POINTCLOUD_UTILS_ROS_H
@@ -11,19 +11,61 @@
 
 using namespace mir_perception_utils;
 
+namespace
+{
+// the input may be shared with other subscribers (nodelets), so its header is not
+// modified, the transform at the latest common time is looked up instead
+void lookupLatestTransform(const boost::shared_ptr<tf::TransformListener> &tf_listener,
+                           const std::string &target_frame, const std::string &frame_id,
+                           tf::StampedTransform &transform, ros::Time &common_time)
+{
+  tf_listener->getLatestCommonTime(target_frame, frame_id, common_time, NULL);
+  tf_listener->waitForTransform(target_frame, frame_id, ros::Time::now(), ros::Duration(1.0));
+  tf_listener->lookupTransform(target_frame, frame_id, common_time, transform);
+}
+}  // namespace
+
 bool pointcloud::transformPointCloudMsg(const boost::shared_ptr<tf::TransformListener> &tf_listener,
                                         const std::string &target_frame,
                                         const sensor_msgs::PointCloud2 &cloud_in,
-                                        sensor_msgs::PointCloud2 &cloud_out)
+                                        sensor_msgs::PointCloud2 &cloud_out,
+                                        const std::string &source_frame)
 {
   if (tf_listener) {
     try {
+      const std::string &frame_id = source_frame.empty() ? cloud_in.header.frame_id : source_frame;
       ros::Time common_time;
-      tf_listener->getLatestCommonTime(target_frame, cloud_in.header.frame_id, common_time, NULL);
-      cloud_in.header.stamp = common_time;
-      tf_listener->waitForTransform(target_frame, cloud_in.header.frame_id, ros::Time::now(),
-                                    ros::Duration(1.0));
-      pcl_ros::transformPointCloud(target_frame, cloud_in, cloud_out, *tf_listener);
+      tf::StampedTransform transform;
+      lookupLatestTransform(tf_listener, target_frame, frame_id, transform, common_time);
+      pcl_ros::transformPointCloud(target_frame, transform, cloud_in, cloud_out);
+      cloud_out.header.stamp = common_time;
+      cloud_out.header.frame_id = target_frame;
+    } catch (tf::TransformException &ex) {
+      ROS_ERROR("PCL transform error: %s", ex.what());
+      return (false);
+    }
+  } else {
+    ROS_ERROR_THROTTLE(2.0, "TF listener not initialized.");
+    return (false);
+  }
+  return (true);
+}
+
+bool pointcloud::ingestPointCloudMsg(const boost::shared_ptr<tf::TransformListener> &tf_listener,
+                                     const std::string &target_frame,
+                                     const sensor_msgs::PointCloud2 &cloud_in, PointCloud &cloud_out,
+                                     bool keep_organized, const std::string &source_frame)
+{
+  if (tf_listener) {
+    try {
+      const std::string &frame_id = source_frame.empty() ? cloud_in.header.frame_id : source_frame;
+      ros::Time common_time;
+      tf::StampedTransform transform;
+      lookupLatestTransform(tf_listener, target_frame, frame_id, transform, common_time);
+      Eigen::Matrix4f matrix;
+      pcl_ros::transformAsMatrix(transform, matrix);
+      if (!ingestPointCloudMsg(cloud_in, matrix, cloud_out, keep_organized)) return (false);
+      pcl_conversions::toPCL(common_time, cloud_out.header.stamp);
       cloud_out.header.frame_id = target_frame;
     } catch (tf::TransformException &ex) {
       ROS_ERROR("PCL transform error: %s", ex.what());
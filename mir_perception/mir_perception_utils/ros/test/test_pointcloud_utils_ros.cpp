@@ -0,0 +1,155 @@
+/*
+ * Copyright 2023 Bonn-Rhein-Sieg University
+ */
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <pcl/filters/filter.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <pcl_ros/transforms.h>
+
+#include <mir_perception_utils/pointcloud_utils_ros.h>
+
+using mir_perception_utils::pointcloud::ingestPointCloudMsg;
+
+typedef pcl::PointXYZRGB PointType;
+typedef pcl::PointCloud<PointType> Cloud;
+
+class IngestPointCloudMsgTest : public ::testing::Test
+{
+ protected:
+  /** \brief Organized 5 x 4 coloured cloud, every third point is NaN, and a rotation about z
+   * with a translation */
+  IngestPointCloudMsgTest()
+  {
+    Cloud cloud;
+    cloud.width = 5;
+    cloud.height = 4;
+    cloud.is_dense = false;
+    for (uint32_t i = 0; i < cloud.width * cloud.height; i++) {
+      PointType point;
+      point.x = 0.1f * static_cast<float>(i % cloud.width);
+      point.y = -0.2f + 0.05f * static_cast<float>(i / cloud.width);
+      point.z = i % 3 == 0 ? std::numeric_limits<float>::quiet_NaN() : 0.8f + 0.01f * i;
+      point.r = static_cast<uint8_t>(10 * i);
+      point.g = static_cast<uint8_t>(255 - 10 * i);
+      point.b = static_cast<uint8_t>(i);
+      point.a = 255;
+      cloud.points.push_back(point);
+    }
+    pcl::toROSMsg(cloud, msg_);
+    msg_.header.frame_id = "camera_link";
+    msg_.header.stamp = ros::Time(10, 500);
+
+    Eigen::Affine3f transform = Eigen::Affine3f::Identity();
+    transform.translate(Eigen::Vector3f(0.1f, -0.2f, 0.5f));
+    transform.rotate(Eigen::AngleAxisf(0.3f, Eigen::Vector3f::UnitZ()));
+    transform_ = transform.matrix();
+  }
+
+  /** \brief Transform with pcl_ros and convert with pcl, as the pipeline did before */
+  Cloud reference(bool keep_organized)
+  {
+    sensor_msgs::PointCloud2 transformed;
+    pcl_ros::transformPointCloud(transform_, msg_, transformed);
+    Cloud cloud;
+    pcl::fromROSMsg(transformed, cloud);
+    if (!keep_organized) {
+      std::vector<int> indices;
+      pcl::removeNaNFromPointCloud(cloud, cloud, indices);
+    }
+    return cloud;
+  }
+
+  static void expectSamePoints(const Cloud &expected, const Cloud &cloud)
+  {
+    ASSERT_EQ(cloud.width, expected.width);
+    ASSERT_EQ(cloud.height, expected.height);
+    ASSERT_EQ(cloud.points.size(), expected.points.size());
+    for (size_t i = 0; i < cloud.points.size(); i++) {
+      const PointType &point = cloud.points[i];
+      const PointType &expected_point = expected.points[i];
+      if (!std::isfinite(expected_point.z)) {
+        EXPECT_FALSE(std::isfinite(point.z)) << "point " << i;
+        continue;
+      }
+      EXPECT_NEAR(point.x, expected_point.x, 1e-5) << "point " << i;
+      EXPECT_NEAR(point.y, expected_point.y, 1e-5) << "point " << i;
+      EXPECT_NEAR(point.z, expected_point.z, 1e-5) << "point " << i;
+      EXPECT_EQ(point.rgba, expected_point.rgba) << "point " << i;
+    }
+  }
+
+  sensor_msgs::PointCloud2 msg_;
+  Eigen::Matrix4f transform_;
+};
+
+TEST_F(IngestPointCloudMsgTest, MatchesTransformAndConversion)
+{
+  Cloud cloud;
+  ASSERT_TRUE(ingestPointCloudMsg(msg_, transform_, cloud));
+  expectSamePoints(reference(true), cloud);
+  EXPECT_FALSE(cloud.is_dense);
+  EXPECT_EQ(cloud.header.frame_id, "camera_link");
+  EXPECT_EQ(cloud.header.stamp, pcl_conversions::toPCL(msg_.header.stamp));
+  // the sensor pose is the transform of the source frame
+  EXPECT_NEAR(cloud.sensor_origin_.x(), 0.1f, 1e-6);
+  EXPECT_NEAR(cloud.sensor_origin_.y(), -0.2f, 1e-6);
+  EXPECT_NEAR(cloud.sensor_origin_.z(), 0.5f, 1e-6);
+  EXPECT_TRUE(cloud.sensor_orientation_.toRotationMatrix().isApprox(transform_.topLeftCorner<3, 3>()));
+}
+
+TEST_F(IngestPointCloudMsgTest, DropsInvalidPoints)
+{
+  Cloud cloud;
+  ASSERT_TRUE(ingestPointCloudMsg(msg_, transform_, cloud, false));
+  const Cloud expected = reference(false);
+  EXPECT_EQ(cloud.points.size(), 13u);
+  EXPECT_EQ(cloud.height, 1u);
+  EXPECT_TRUE(cloud.is_dense);
+  expectSamePoints(expected, cloud);
+}
+
+TEST_F(IngestPointCloudMsgTest, ReusesTheOutputCloud)
+{
+  Cloud cloud;
+  ASSERT_TRUE(ingestPointCloudMsg(msg_, transform_, cloud, false));
+  ASSERT_TRUE(ingestPointCloudMsg(msg_, transform_, cloud, true));
+  expectSamePoints(reference(true), cloud);
+}
+
+TEST_F(IngestPointCloudMsgTest, ConvertsOtherLayoutsInSeparatePasses)
+{
+  // big endian messages are not read directly, pcl ignores the flag
+  msg_.is_bigendian = true;
+  Cloud cloud;
+  ASSERT_TRUE(ingestPointCloudMsg(msg_, transform_, cloud));
+  expectSamePoints(reference(true), cloud);
+  ASSERT_TRUE(ingestPointCloudMsg(msg_, transform_, cloud, false));
+  expectSamePoints(reference(false), cloud);
+  EXPECT_NEAR(cloud.sensor_origin_.z(), 0.5f, 1e-6);
+
+  // x is not a float32
+  msg_.is_bigendian = false;
+  for (auto &field : msg_.fields) {
+    if (field.name == "x") field.datatype = sensor_msgs::PointField::FLOAT64;
+  }
+  EXPECT_FALSE(ingestPointCloudMsg(msg_, transform_, cloud));
+}
+
+TEST_F(IngestPointCloudMsgTest, RejectsTruncatedData)
+{
+  msg_.data.resize(msg_.data.size() - msg_.point_step);
+  Cloud cloud;
+  EXPECT_FALSE(ingestPointCloudMsg(msg_, transform_, cloud));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
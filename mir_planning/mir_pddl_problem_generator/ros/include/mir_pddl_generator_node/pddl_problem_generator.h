@@ -19,6 +19,8 @@
 #include "rosplan_knowledge_msgs/GetInstanceService.h"
 #include "rosplan_knowledge_msgs/GetMetricService.h"
 
+#include <mir_object_catalogue/object_catalogue.h>
+
 class PDDLProblemGenerator
 {
  public:
@@ -39,6 +41,9 @@ class PDDLProblemGenerator
   std::string state_goal_service_;
 
   std::map<std::string, float> points_map_;
+  ObjectCatalogue object_catalogue_;
+  // points of the objects of the catalogue, indexed by object id
+  std::vector<float> object_points_;
   int max_goals_;
   bool prefer_goals_with_same_source_ws_;
 
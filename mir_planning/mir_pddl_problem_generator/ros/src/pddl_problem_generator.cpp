@@ -12,6 +12,18 @@ PDDLProblemGenerator::PDDLProblemGenerator() : nh_("~")
     nh_.getParam("points", points_map_);
     if (points_map_.size() == 0) ROS_ERROR("Points for objects and location not defined.");
 
+    std::string object_catalogue;
+    nh_.param<std::string>("object_catalogue", object_catalogue, "");
+    std::string error;
+    if (!object_catalogue_.load(object_catalogue, &error)) {
+        ROS_WARN_STREAM("[mir_pddl_problem_generator] Cannot read the object catalogue "
+                        << object_catalogue << ": " << error);
+    }
+    object_points_.resize(object_catalogue_.size(), 0.0f);
+    for (ObjectId id = 1; id < object_catalogue_.size(); id++) {
+        object_points_[id] = getPoints(object_catalogue_.info(id).name);
+    }
+
     std::stringstream ss;
 
     ss << "/" << knowledge_base << "/domain/name";
@@ -381,6 +393,9 @@ float PDDLProblemGenerator::getPoints(const std::string &key)
 
 float PDDLProblemGenerator::getPointsObject(const std::string &obj)
 {
+    // instances such as em-01-02 resolve to their object in the catalogue
+    ObjectId id = object_catalogue_.find(obj);
+    if (id != ObjectCatalogue::UNKNOWN_ID) return object_points_[id];
     size_t minus_pos = obj.find_first_of("-");
     return (minus_pos == obj.npos) ? getPoints(obj) : getPoints(obj.substr(0, minus_pos));
 }